@@ -1,124 +1,387 @@
 #include "ds18b20.h"
+#include "onewire_bus.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "esp_attr.h"
 #include "esp_log.h"
-#include "driver/gpio.h"
-#include "esp_rom_sys.h" // For esp_rom_delay_us
+#include "esp_timer.h"
+#include <math.h>
+#include <string.h>
 
 #define ONEWIRE_GPIO 18
 static const char *TAG = "DS18B20_DRIVER";
 
-// --- Private 1-Wire Functions ---
-static void onewire_set_output() { 
-    gpio_set_direction(ONEWIRE_GPIO, GPIO_MODE_OUTPUT); 
-}
-static void ds18b20_set_resolution(uint8_t resolution_config);
-static void onewire_set_input() { 
-    gpio_set_direction(ONEWIRE_GPIO, GPIO_MODE_INPUT); 
-}
-static void onewire_high() { 
-    onewire_set_input(); 
-}
-static void onewire_low() { 
-    onewire_set_output(); gpio_set_level(ONEWIRE_GPIO, 0); 
-}
-static int onewire_read_level() { return gpio_get_level(ONEWIRE_GPIO); }
-//1 wire reset process
-static bool onewire_reset(void) {
-    onewire_low();
-    esp_rom_delay_us(480);
-    onewire_high();
-    esp_rom_delay_us(70);
-    bool presence = (onewire_read_level() == 0);
-    esp_rom_delay_us(410);
-    return presence;
-}
-// Writes one byte to the 1-Wire bus, LSB first.
-static void onewire_write_bit(bool bit) {
-    onewire_low();
-    esp_rom_delay_us(bit ? 6 : 60);
-    onewire_high();
-    esp_rom_delay_us(bit ? 64 : 10);
-}
-//Reads one byte from the 1-Wire bus, LSB first
-
-static bool onewire_read_bit(void) {
-    onewire_low();
-    esp_rom_delay_us(6);
-    onewire_high();
-    esp_rom_delay_us(9);
-    bool bit = (onewire_read_level() == 1);
-    esp_rom_delay_us(55);
-    return bit;
-}
-
-static void onewire_write_byte(uint8_t byte) {
-    for (int i = 0; i < 8; i++) {
-        onewire_write_bit(byte & 0x01);
-        byte >>= 1;
-    }
-}
-
-static uint8_t onewire_read_byte(void) {
-    uint8_t byte = 0;
-    for (int i = 0; i < 8; i++) {
-        byte >>= 1;
-        if (onewire_read_bit()) {
-            byte |= 0x80;
+#ifdef DS18B20_ONEWIRE_BITBANG
+static const onewire_backend_t *const s_default_bus = &onewire_gpio_backend;
+#else
+static const onewire_backend_t *const s_default_bus = &onewire_rmt_backend;
+#endif
+static const onewire_backend_t *s_bus = NULL;
+
+// Max conversion time per resolution (data sheet, tCONV), 9..12 bits.
+static const uint16_t conv_time_ms[] = { 94, 188, 375, 750 };
+#define POLL_MARGIN_MS 20   // grace past tCONV before a poll gives up
+
+static uint8_t s_resolution = DS18B20_DEFAULT_RESOLUTION;
+static int64_t s_conv_deadline_us = -1;   // -1: no conversion pending
+
+#define DS18B20_FAMILY 0x28
+
+// ROMs found by the last search. Kept across deep sleep so the search only
+// runs on a cold boot or after a probe stops answering.
+typedef struct {
+    bool valid;
+    uint8_t count;
+    uint8_t rom[DS18B20_MAX_PROBES][8];
+} probe_table_t;
+static RTC_DATA_ATTR probe_table_t s_probes;
+
+// Bus errors since cold boot.
+static RTC_DATA_ATTR ds18b20_stats_t s_stats;
+
+#define SCRATCHPAD_LEN   9
+#define POR_RAW_TEMP     0x0550  // 85 degC, power-on value before any conversion
+
+static bool bus_open(const onewire_backend_t *bus) {
+    if (s_bus) s_bus->deinit();
+    s_bus = NULL;
+    if (bus->init(ONEWIRE_GPIO) != ESP_OK) return false;
+    s_bus = bus;
+    return true;
+}
+
+// Dallas/Maxim CRC8, x^8 + x^5 + x^4 + 1 (reflected 0x8C), one lookup
+// per byte instead of eight shift/xor steps.
+static const uint8_t crc8_table[256] = {
+    0x00, 0x5E, 0xBC, 0xE2, 0x61, 0x3F, 0xDD, 0x83, 0xC2, 0x9C, 0x7E, 0x20, 0xA3, 0xFD, 0x1F, 0x41,
+    0x9D, 0xC3, 0x21, 0x7F, 0xFC, 0xA2, 0x40, 0x1E, 0x5F, 0x01, 0xE3, 0xBD, 0x3E, 0x60, 0x82, 0xDC,
+    0x23, 0x7D, 0x9F, 0xC1, 0x42, 0x1C, 0xFE, 0xA0, 0xE1, 0xBF, 0x5D, 0x03, 0x80, 0xDE, 0x3C, 0x62,
+    0xBE, 0xE0, 0x02, 0x5C, 0xDF, 0x81, 0x63, 0x3D, 0x7C, 0x22, 0xC0, 0x9E, 0x1D, 0x43, 0xA1, 0xFF,
+    0x46, 0x18, 0xFA, 0xA4, 0x27, 0x79, 0x9B, 0xC5, 0x84, 0xDA, 0x38, 0x66, 0xE5, 0xBB, 0x59, 0x07,
+    0xDB, 0x85, 0x67, 0x39, 0xBA, 0xE4, 0x06, 0x58, 0x19, 0x47, 0xA5, 0xFB, 0x78, 0x26, 0xC4, 0x9A,
+    0x65, 0x3B, 0xD9, 0x87, 0x04, 0x5A, 0xB8, 0xE6, 0xA7, 0xF9, 0x1B, 0x45, 0xC6, 0x98, 0x7A, 0x24,
+    0xF8, 0xA6, 0x44, 0x1A, 0x99, 0xC7, 0x25, 0x7B, 0x3A, 0x64, 0x86, 0xD8, 0x5B, 0x05, 0xE7, 0xB9,
+    0x8C, 0xD2, 0x30, 0x6E, 0xED, 0xB3, 0x51, 0x0F, 0x4E, 0x10, 0xF2, 0xAC, 0x2F, 0x71, 0x93, 0xCD,
+    0x11, 0x4F, 0xAD, 0xF3, 0x70, 0x2E, 0xCC, 0x92, 0xD3, 0x8D, 0x6F, 0x31, 0xB2, 0xEC, 0x0E, 0x50,
+    0xAF, 0xF1, 0x13, 0x4D, 0xCE, 0x90, 0x72, 0x2C, 0x6D, 0x33, 0xD1, 0x8F, 0x0C, 0x52, 0xB0, 0xEE,
+    0x32, 0x6C, 0x8E, 0xD0, 0x53, 0x0D, 0xEF, 0xB1, 0xF0, 0xAE, 0x4C, 0x12, 0x91, 0xCF, 0x2D, 0x73,
+    0xCA, 0x94, 0x76, 0x28, 0xAB, 0xF5, 0x17, 0x49, 0x08, 0x56, 0xB4, 0xEA, 0x69, 0x37, 0xD5, 0x8B,
+    0x57, 0x09, 0xEB, 0xB5, 0x36, 0x68, 0x8A, 0xD4, 0x95, 0xCB, 0x29, 0x77, 0xF4, 0xAA, 0x48, 0x16,
+    0xE9, 0xB7, 0x55, 0x0B, 0x88, 0xD6, 0x34, 0x6A, 0x2B, 0x75, 0x97, 0xC9, 0x4A, 0x14, 0xF6, 0xA8,
+    0x74, 0x2A, 0xC8, 0x96, 0x15, 0x4B, 0xA9, 0xF7, 0xB6, 0xE8, 0x0A, 0x54, 0xD7, 0x89, 0x6B, 0x35,
+};
+
+static uint8_t onewire_crc8(const uint8_t *data, size_t len) {
+    uint8_t crc = 0;
+    while (len--) {
+        crc = crc8_table[crc ^ *data++];
+    }
+    return crc;
+}
+
+/* One pass of the 1-Wire ROM search (Maxim AN187). `last_disc` is the bit
+ * (1..64) where the previous pass took the 0 branch last, 0 on the first
+ * pass; it is updated for the next one and 0 again means the tree is done.
+ * Returns 1 with rom filled, 0 if nobody answered, -1 on a bus error. */
+static int rom_search_next(uint8_t rom[8], int *last_disc) {
+    if (!s_bus->reset()) return 0;
+    const uint8_t cmd = 0xF0; // Search ROM
+    if (s_bus->write_bytes(&cmd, 1) != ESP_OK) return -1;
+
+    int last_zero = 0;
+    for (int bit = 1; bit <= 64; bit++) {
+        bool id, cmp, dir;
+        if (s_bus->read_bit(&id) != ESP_OK || s_bus->read_bit(&cmp) != ESP_OK) return -1;
+        if (id && cmp) return 0;          // no device left in this branch
+        if (id != cmp) {
+            dir = id;                     // all remaining devices agree
+        } else if (bit < *last_disc) {
+            dir = (rom[(bit - 1) / 8] >> ((bit - 1) % 8)) & 1;
+        } else {
+            dir = (bit == *last_disc);
+        }
+        if (id == cmp && !dir) last_zero = bit;
+        if (dir) rom[(bit - 1) / 8] |= 1 << ((bit - 1) % 8);
+        else rom[(bit - 1) / 8] &= ~(1 << ((bit - 1) % 8));
+        if (s_bus->write_bit(dir) != ESP_OK) return -1;
+    }
+    *last_disc = last_zero;
+    return 1;
+}
+
+int ds18b20_search(void) {
+    if (!s_bus) return -1;
+    probe_table_t t = { 0 };
+    uint8_t rom[8] = { 0 };
+    int last_disc = 0;
+    do {
+        int r = rom_search_next(rom, &last_disc);
+        if (r < 0) return -1;
+        if (r == 0) break;
+        if (onewire_crc8(rom, 7) != rom[7]) {
+            ESP_LOGW(TAG, "ROM CRC mismatch during search, retry later");
+            return -1;
         }
+        if (rom[0] != DS18B20_FAMILY) continue;
+        if (t.count == DS18B20_MAX_PROBES) {
+            ESP_LOGW(TAG, "More than %d probes on the bus, ignoring the rest", DS18B20_MAX_PROBES);
+            break;
+        }
+        memcpy(t.rom[t.count++], rom, 8);
+    } while (last_disc != 0);
+
+    t.valid = t.count > 0;
+    s_probes = t;
+    for (int i = 0; i < t.count; i++) {
+        const uint8_t *r = t.rom[i];
+        ESP_LOGI(TAG, "probe %d: %02X%02X%02X%02X%02X%02X%02X%02X", i,
+                 r[7], r[6], r[5], r[4], r[3], r[2], r[1], r[0]);
     }
-    return byte;
+    return t.count;
+}
+
+int ds18b20_probe_count(void) {
+    return s_probes.valid ? s_probes.count : 0;
 }
 
 // --- Public Functions (called from main.c) ---
 void ds18b20_init(void) {
-    gpio_config_t io_conf = {
-        .pin_bit_mask = (1ULL << ONEWIRE_GPIO),
-        .mode = GPIO_MODE_INPUT,
-        .pull_up_en = true,
-        .pull_down_en = false,
-        .intr_type = GPIO_INTR_DISABLE
-    };
-    gpio_config(&io_conf);
+    if (!bus_open(s_default_bus)) {
+        // RMT channels can run out; the bit-banged bus always works.
+        ESP_LOGW(TAG, "%s backend unavailable, falling back to gpio", s_default_bus->name);
+        if (!bus_open(&onewire_gpio_backend)) {
+            ESP_LOGE(TAG, "1-Wire init failed on GPIO %d", ONEWIRE_GPIO);
+            return;
+        }
+    }
 
-    // 0x5F for 11-bit, 0x7F for 12-bit
-    ds18b20_set_resolution(0x5F);
-    ESP_LOGI(TAG, "DS18B20 driver initialized on GPIO %d", ONEWIRE_GPIO);
+    if (!s_probes.valid) ds18b20_search();
+    // Skip ROM: one write configures every probe.
+    ds18b20_set_resolution(s_resolution);
+    ESP_LOGI(TAG, "DS18B20 driver initialized on GPIO %d (%s), %d probe(s)",
+             ONEWIRE_GPIO, s_bus->name, ds18b20_probe_count());
 }
-static void ds18b20_set_resolution(uint8_t resolution_config) {
-    if (!onewire_reset()) {
+int ds18b20_set_resolution(uint8_t bits) {
+    if (bits < 9 || bits > 12) return -1;
+    if (!s_bus || !s_bus->reset()) {
         ESP_LOGE(TAG, "Failed to set resolution, no device found.");
-        return;
+        return -1;
     }
-    onewire_write_byte(0xCC); // Skip ROM
-    onewire_write_byte(0x4E); // Write Scratchpad command
-    onewire_write_byte(0x00); // TH Register (not used)
-    onewire_write_byte(0x00); // TL Register (not used)
-    onewire_write_byte(resolution_config); //Configuration Register
+    const uint8_t cmd[] = {
+        0xCC,                        // Skip ROM
+        0x4E,                        // Write Scratchpad command
+        0x00,                        // TH Register (not used)
+        0x00,                        // TL Register (not used)
+        ((bits - 9) << 5) | 0x1F,    // Configuration Register: 0x5F = 11-bit
+    };
+    if (s_bus->write_bytes(cmd, sizeof(cmd)) != ESP_OK) return -1;
+    s_resolution = bits;
+    return 0;
 }
 
-int ds18b20_read_temperature(float *temperature) {
-    if (!onewire_reset()) {
+uint32_t ds18b20_conversion_time_ms(void) {
+    return conv_time_ms[s_resolution - 9];
+}
+
+int ds18b20_start_conversion(void) {
+    s_conv_deadline_us = -1;
+    if (!s_bus) return -1;
+    if (!s_bus->reset()) {
         ESP_LOGE(TAG, "No device found.");
         return -1;
     }
-    onewire_write_byte(0xCC); // Skip ROM
-    onewire_write_byte(0x44); // Convert T
-    vTaskDelay(pdMS_TO_TICKS(400));
+    const uint8_t cmd[] = { 0xCC, 0x44 }; // Skip ROM, Convert T: all probes at once
+    if (s_bus->write_bytes(cmd, sizeof(cmd)) != ESP_OK) return -1;
+    s_conv_deadline_us = esp_timer_get_time() + ds18b20_conversion_time_ms() * 1000LL;
+    return 0;
+}
+
+int64_t ds18b20_conversion_due_us(void) {
+    return s_conv_deadline_us;
+}
+
+bool ds18b20_conversion_done(void) {
+    bool done = false;
+    if (!s_bus || s_conv_deadline_us < 0 || s_bus->read_bit(&done) != ESP_OK) return false;
+    return done;
+}
+
+// Blocks until the pending conversion is done. With poll_ready the devices
+// are asked once per tick: a read slot returns 1 once every probe has
+// finished (any busy one holds it at 0), usually well before tCONV. Polling needs the bus left alone since
+// Convert T and a device that is not parasite-powered.
+static int wait_conversion(bool poll_ready) {
+    int64_t now = esp_timer_get_time();
+    if (poll_ready) {
+        int64_t give_up = s_conv_deadline_us + POLL_MARGIN_MS * 1000LL;
+        for (;;) {
+            bool done = false;
+            if (s_bus->read_bit(&done) != ESP_OK) break; // fall back to the timed wait
+            if (done) return 0;
+            if (esp_timer_get_time() >= give_up) return -1;
+            vTaskDelay(1);
+        }
+        now = esp_timer_get_time();
+    }
+    if (now < s_conv_deadline_us) {
+        uint32_t ms = (uint32_t)((s_conv_deadline_us - now + 999) / 1000);
+        vTaskDelay((ms + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS);
+    }
+    return 0;
+}
 
-    if (!onewire_reset()) {
-        ESP_LOGE(TAG, "No device found after conversion.");
+// Reads and CRC-checks one probe's scratchpad. A single probe is addressed
+// with Skip ROM, several with Match ROM.
+static int read_scratchpad(int idx, uint8_t buf[SCRATCHPAD_LEN]) {
+    if (!s_bus->reset()) {
+        s_stats.no_response++;
+        return -1;
+    }
+    uint8_t cmd[10];
+    size_t len = 0;
+    if (ds18b20_probe_count() > 1) {
+        cmd[len++] = 0x55; // Match ROM
+        memcpy(&cmd[len], s_probes.rom[idx], 8);
+        len += 8;
+    } else {
+        cmd[len++] = 0xCC; // Skip ROM
+    }
+    cmd[len++] = 0xBE;     // Read Scratchpad
+    if (s_bus->write_bytes(cmd, len) != ESP_OK ||
+        s_bus->read_bytes(buf, SCRATCHPAD_LEN) != ESP_OK) {
+        s_stats.no_response++;
+        return -1;
+    }
+    // All zeros has a valid CRC too: that is a shorted line, not data.
+    bool all_zero = true;
+    for (int i = 0; i < SCRATCHPAD_LEN; i++) all_zero &= (buf[i] == 0);
+    if (all_zero || onewire_crc8(buf, SCRATCHPAD_LEN - 1) != buf[SCRATCHPAD_LEN - 1]) {
+        s_stats.crc_errors++;
         return -1;
     }
-    onewire_write_byte(0xCC); // Skip ROM
-    onewire_write_byte(0xBE); // Read Scratchpad
+    return 0;
+}
 
-    uint8_t lsb = onewire_read_byte();
-    uint8_t msb = onewire_read_byte();
+// Reads one probe's temperature, retrying a bad transfer up to
+// DS18B20_READ_RETRIES times. The conversion result stays in the
+// scratchpad, so a retry only costs another read, not another tCONV.
+static int read_probe(int idx, float *temperature) {
+    uint8_t buf[SCRATCHPAD_LEN];
+    int err = -1;
+    for (int attempt = 0; attempt <= DS18B20_READ_RETRIES && err != 0; attempt++) {
+        if (attempt) s_stats.retries++;
+        err = read_scratchpad(idx, buf);
+    }
+    if (err != 0) {
+        ESP_LOGE(TAG, "Scratchpad read failed (probe %d).", idx);
+        return -1;
+    }
     // combines MSB and LSB to a 16-bit signed integer
-    int16_t raw_temp = (msb << 8) | lsb;
+    int16_t raw_temp = (buf[1] << 8) | buf[0];
+    // 85 degC with a config byte we did not write: the probe browned out
+    // and lost both the conversion and the resolution since Convert T.
+    if (raw_temp == POR_RAW_TEMP && buf[4] != (((s_resolution - 9) << 5) | 0x1F)) {
+        s_stats.por_values++;
+        ESP_LOGW(TAG, "Probe %d reports its power-on value, discarding.", idx);
+        return -1;
+    }
     //Sensor provides data in 1/16th degree C increments
     *temperature = (float)raw_temp / 16.0f;
+    return 0;
+}
+
+int ds18b20_collect_temperatures(float *temperatures, int max, bool poll_ready) {
+    if (!s_bus || s_conv_deadline_us < 0) return -1;
+    if (wait_conversion(poll_ready) != 0) {
+        ESP_LOGE(TAG, "Conversion did not finish.");
+        s_conv_deadline_us = -1;
+        return -1;
+    }
+    s_conv_deadline_us = -1;
 
+    // No table (the search failed): a lone probe still answers Skip ROM,
+    // and it converted with the rest. Several probes collide and fail CRC.
+    int n = ds18b20_probe_count();
+    if (n == 0) n = 1;
+    if (n > max) n = max;
+    int ok = 0;
+    bool por = false;
+    for (int i = 0; i < n; i++) {
+        uint32_t por_before = s_stats.por_values;
+        if (read_probe(i, &temperatures[i]) == 0) {
+            ok++;
+            continue;
+        }
+        temperatures[i] = NAN;
+        if (s_stats.por_values != por_before) {
+            por = true;
+        } else {
+            s_probes.valid = false; // probe gone or swapped: search next wake
+        }
+    }
+    if (por) ds18b20_set_resolution(s_resolution); // restore what the reset lost
+    return ok ? n : -1;
+}
+
+int ds18b20_collect_temperature(float *temperature, bool poll_ready) {
+    float t[DS18B20_MAX_PROBES];
+    if (ds18b20_collect_temperatures(t, DS18B20_MAX_PROBES, poll_ready) < 1 || isnan(t[0])) {
+        return -1;
+    }
+    *temperature = t[0];
     return 0; // Success
-}
\ No newline at end of file
+}
+
+const ds18b20_stats_t *ds18b20_get_stats(void) {
+    return &s_stats;
+}
+
+uint32_t ds18b20_error_count(void) {
+    return s_stats.crc_errors + s_stats.no_response + s_stats.por_values;
+}
+
+int ds18b20_read_temperature(float *temperature) {
+    if (ds18b20_start_conversion() != 0) return -1;
+    return ds18b20_collect_temperature(temperature, true);
+}
+
+#define TIMING_REPORT_ROUNDS 5
+
+// One scratchpad read per round (reset, skip ROM, read 9 bytes) on each
+// backend. "busy" is wall time minus time the task spent blocked, i.e. the
+// CPU the bus cost us.
+void ds18b20_timing_report(void) {
+    static const onewire_backend_t *const backends[] = {
+        &onewire_gpio_backend, &onewire_rmt_backend
+    };
+    const onewire_backend_t *restore = s_bus ? s_bus : s_default_bus;
+
+    for (size_t b = 0; b < sizeof(backends) / sizeof(backends[0]); b++) {
+        const onewire_backend_t *bus = backends[b];
+        if (!bus_open(bus)) {
+            ESP_LOGW(TAG, "timing: %s backend unavailable", bus->name);
+            continue;
+        }
+        onewire_stats_t before = *bus->stats;
+        int ok = 0;
+        int64_t worst = 0;
+        for (int i = 0; i < TIMING_REPORT_ROUNDS; i++) {
+            const uint8_t cmd[] = { 0xCC, 0xBE };
+            uint8_t scratch[9];
+            int64_t t0 = esp_timer_get_time();
+            if (bus->reset() && bus->write_bytes(cmd, sizeof(cmd)) == ESP_OK &&
+                bus->read_bytes(scratch, sizeof(scratch)) == ESP_OK) {
+                ok++;
+            }
+            int64_t dt = esp_timer_get_time() - t0;
+            if (dt > worst) worst = dt;
+        }
+        uint64_t wall = bus->stats->wall_us - before.wall_us;
+        uint64_t blocked = bus->stats->blocked_us - before.blocked_us;
+        ESP_LOGI(TAG, "timing %-4s: %d/%d ok, wall %llu us/read (max %lld), busy %llu us/read",
+                 bus->name, ok, TIMING_REPORT_ROUNDS,
+                 (unsigned long long)(wall / TIMING_REPORT_ROUNDS), (long long)worst,
+                 (unsigned long long)((wall - blocked) / TIMING_REPORT_ROUNDS));
+    }
+    if (!bus_open(restore)) bus_open(&onewire_gpio_backend);
+}
@@ -0,0 +1,49 @@
+// ds18b20_sensor.c - DS18B20 probes as a sensor_registry descriptor
+#include "ds18b20_sensor.h"
+#include <math.h>
+#include "ds18b20.h"
+#include "esp_timer.h"
+
+_Static_assert(DS18B20_MAX_PROBES <= SENSOR_MAX_VALUES, "one value per probe");
+
+static int soil_init(void *ctx)
+{
+    ds18b20_init();
+    return ds18b20_start_conversion() == 0 ? 0 : -1; // no presence pulse: no probe
+}
+
+// Normally already converting since init.
+static int soil_start(void *ctx)
+{
+    return ds18b20_conversion_due_us() >= 0 ? 0 : ds18b20_start_conversion();
+}
+
+// Polled by the scheduler: usually done well before the worst-case tCONV.
+static int64_t soil_ready(void *ctx)
+{
+    int64_t due = ds18b20_conversion_due_us();
+    return due >= 0 && ds18b20_conversion_done() ? esp_timer_get_time() : due;
+}
+
+static int soil_collect(void *ctx, float *values)
+{
+    if (ds18b20_collect_temperatures(values, DS18B20_MAX_PROBES, true) < 1) values[0] = NAN;
+    return isnan(values[0]) ? -1 : 0;
+}
+
+static const char *const soil_names[] = { "st0", "st1", "st2", "st3" };
+
+// No power_down hook: the probes are not on a probe_power switch and
+// idle at about 1 uA once converted, and the RMT channels are only enabled
+// during a transfer (onewire_rmt.c).
+const sensor_desc_t ds18b20_sensor = {
+    .name = "ds18b20",
+    .bus = SENSOR_BUS_ONEWIRE,
+    .n_values = DS18B20_MAX_PROBES,
+    .value_names = soil_names,
+    .init = soil_init,
+    .start = soil_start,
+    .ready = soil_ready,
+    .collect = soil_collect,
+    .ready_poll_ms = 10,
+};
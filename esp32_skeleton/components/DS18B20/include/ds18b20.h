@@ -2,8 +2,74 @@
 #define DS18B20_H
 
 #include <stdio.h> // For float
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Resolution set by ds18b20_init(). tCONV: 9-bit 94 ms, 10-bit 188 ms,
+ * 11-bit 375 ms, 12-bit 750 ms; LSB 0.5 / 0.25 / 0.125 / 0.0625 degC. */
+#define DS18B20_DEFAULT_RESOLUTION 11
+
+/* Probes sharing the 1-Wire pin. Channel i is the i-th ROM found by the
+ * search (ascending ROM code, LSB first), so it stays put across wakes. */
+#define DS18B20_MAX_PROBES 4
+
+/* Extra scratchpad reads after a failed CRC or missing presence pulse. */
+#define DS18B20_READ_RETRIES 2
+
+/* Counted since cold boot (kept in RTC memory across deep sleep). */
+typedef struct {
+    uint32_t crc_errors;   // scratchpad CRC mismatch (noise on the cable)
+    uint32_t no_response;  // no presence pulse / bus error
+    uint32_t por_values;   // 85 degC power-on value, conversion lost
+    uint32_t retries;      // reads repeated, successful or not
+} ds18b20_stats_t;
 
 void ds18b20_init(void);
+
+/* Blocking read of probe 0: start + collect with polling. Returns 0 or -1. */
 int ds18b20_read_temperature(float *temperature);
 
-#endif
\ No newline at end of file
+/* bits = 9..12. Returns 0 or -1. */
+int ds18b20_set_resolution(uint8_t bits);
+
+/* Worst-case conversion time for the configured resolution. */
+uint32_t ds18b20_conversion_time_ms(void);
+
+/* Runs the ROM search and replaces the probe table kept in RTC memory.
+ * ds18b20_init() only does this when the table is empty or a probe stopped
+ * answering on the last wake. Returns the number of probes, or -1. */
+int ds18b20_search(void);
+int ds18b20_probe_count(void);
+
+/* Issues Convert T to all probes and returns at once. Do other work,
+ * then collect. */
+int ds18b20_start_conversion(void);
+
+/* esp_timer time the pending conversion is due (worst-case tCONV), or -1
+ * if none was started. */
+int64_t ds18b20_conversion_due_us(void);
+
+/* One read slot: true once every probe has finished the pending conversion
+ * (a busy probe holds the slot at 0). Same conditions as poll_ready below. */
+bool ds18b20_conversion_done(void);
+
+/* Waits out whatever is left of the conversion, then reads every probe.
+ * With poll_ready it returns as soon as the devices report done; leave the
+ * bus idle between start and collect for that. With an empty probe table
+ * it reads one probe with Skip ROM. Fills up to `max` values
+ * (NAN for a probe that failed) and returns how many, or -1 if none read. */
+int ds18b20_collect_temperatures(float *temperatures, int max, bool poll_ready);
+
+/* As above for probe 0 only. Returns 0 or -1. */
+int ds18b20_collect_temperature(float *temperature, bool poll_ready);
+
+const ds18b20_stats_t *ds18b20_get_stats(void);
+
+/* crc_errors + no_response + por_values, for telemetry. */
+uint32_t ds18b20_error_count(void);
+
+/* Logs per-read wall and CPU-busy time of a scratchpad read on the
+ * bit-banged and RMT 1-Wire backends, then returns to the active one. */
+void ds18b20_timing_report(void);
+
+#endif
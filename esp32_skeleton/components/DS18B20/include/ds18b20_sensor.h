@@ -0,0 +1,12 @@
+// ds18b20_sensor.h - DS18B20 probes as a sensor_registry descriptor
+#ifndef DS18B20_SENSOR_H
+#define DS18B20_SENSOR_H
+
+#include "sensor_registry.h"
+
+/* Values: one temperature (°C) per probe, DS18B20_MAX_PROBES of them, NAN
+ * past the probes found. init starts the conversion, so it runs while the
+ * rest of the wake proceeds; the entry ctx is unused. */
+extern const sensor_desc_t ds18b20_sensor;
+
+#endif // DS18B20_SENSOR_H
@@ -0,0 +1,35 @@
+// onewire_bus.h - 1-Wire bus backends used by the DS18B20 driver (private)
+#ifndef ONEWIRE_BUS_H
+#define ONEWIRE_BUS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+/* Time spent in bus transactions. `blocked_us` is the part the calling task
+ * spent blocked while hardware drove the bus, i.e. CPU time given back. */
+typedef struct {
+    uint32_t transactions;
+    uint64_t wall_us;
+    uint64_t blocked_us;
+} onewire_stats_t;
+
+/* One 1-Wire master implementation. All calls are for the single bus the
+ * backend was initialized on; bits and bytes go LSB first. */
+typedef struct {
+    const char *name;
+    esp_err_t (*init)(int gpio);
+    void (*deinit)(void);
+    bool (*reset)(void);                              // true if a presence pulse was seen
+    esp_err_t (*write_bytes)(const uint8_t *data, size_t len);
+    esp_err_t (*read_bytes)(uint8_t *data, size_t len);
+    esp_err_t (*write_bit)(bool bit);
+    esp_err_t (*read_bit)(bool *bit);
+    onewire_stats_t *stats;
+} onewire_backend_t;
+
+extern const onewire_backend_t onewire_gpio_backend; // bit-banged, CPU-timed
+extern const onewire_backend_t onewire_rmt_backend;  // RMT-timed
+
+#endif // ONEWIRE_BUS_H
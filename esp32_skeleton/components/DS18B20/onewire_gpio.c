@@ -0,0 +1,121 @@
+// onewire_gpio.c - bit-banged 1-Wire backend (CPU holds every slot)
+#include "onewire_bus.h"
+#include "driver/gpio.h"
+#include "esp_rom_sys.h" // For esp_rom_delay_us
+#include "esp_timer.h"
+
+static int s_gpio = -1;
+static onewire_stats_t s_stats;
+
+// --- Private 1-Wire Functions ---
+static void onewire_set_output() {
+    gpio_set_direction(s_gpio, GPIO_MODE_OUTPUT);
+}
+static void onewire_set_input() {
+    gpio_set_direction(s_gpio, GPIO_MODE_INPUT);
+}
+static void onewire_high() {
+    onewire_set_input();
+}
+static void onewire_low() {
+    onewire_set_output(); gpio_set_level(s_gpio, 0);
+}
+static int onewire_read_level() { return gpio_get_level(s_gpio); }
+
+static esp_err_t onewire_gpio_init(int gpio) {
+    gpio_config_t io_conf = {
+        .pin_bit_mask = (1ULL << gpio),
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = true,
+        .pull_down_en = false,
+        .intr_type = GPIO_INTR_DISABLE
+    };
+    esp_err_t err = gpio_config(&io_conf);
+    if (err == ESP_OK) s_gpio = gpio;
+    return err;
+}
+
+static void onewire_gpio_deinit(void) {
+    if (s_gpio >= 0) gpio_reset_pin(s_gpio);
+    s_gpio = -1;
+}
+
+//1 wire reset process
+static bool onewire_reset(void) {
+    int64_t start = esp_timer_get_time();
+    onewire_low();
+    esp_rom_delay_us(480);
+    onewire_high();
+    esp_rom_delay_us(70);
+    bool presence = (onewire_read_level() == 0);
+    esp_rom_delay_us(410);
+    s_stats.transactions++;
+    s_stats.wall_us += esp_timer_get_time() - start;
+    return presence;
+}
+// Writes one bit to the 1-Wire bus.
+static esp_err_t onewire_write_bit(bool bit) {
+    onewire_low();
+    esp_rom_delay_us(bit ? 6 : 60);
+    onewire_high();
+    esp_rom_delay_us(bit ? 64 : 10);
+    return ESP_OK;
+}
+//Reads one bit from the 1-Wire bus
+
+static esp_err_t onewire_read_bit(bool *bit) {
+    onewire_low();
+    esp_rom_delay_us(6);
+    onewire_high();
+    esp_rom_delay_us(9);
+    *bit = (onewire_read_level() == 1);
+    esp_rom_delay_us(55);
+    return ESP_OK;
+}
+
+// Writes bytes to the 1-Wire bus, LSB first.
+static esp_err_t onewire_write_bytes(const uint8_t *data, size_t len) {
+    int64_t start = esp_timer_get_time();
+    for (size_t n = 0; n < len; n++) {
+        uint8_t byte = data[n];
+        for (int i = 0; i < 8; i++) {
+            onewire_write_bit(byte & 0x01);
+            byte >>= 1;
+        }
+    }
+    s_stats.transactions++;
+    s_stats.wall_us += esp_timer_get_time() - start;
+    return ESP_OK;
+}
+
+// Reads bytes from the 1-Wire bus, LSB first.
+static esp_err_t onewire_read_bytes(uint8_t *data, size_t len) {
+    int64_t start = esp_timer_get_time();
+    for (size_t n = 0; n < len; n++) {
+        uint8_t byte = 0;
+        for (int i = 0; i < 8; i++) {
+            bool bit;
+            byte >>= 1;
+            onewire_read_bit(&bit);
+            if (bit) {
+                byte |= 0x80;
+            }
+        }
+        data[n] = byte;
+    }
+    s_stats.transactions++;
+    s_stats.wall_us += esp_timer_get_time() - start;
+    return ESP_OK;
+}
+
+const onewire_backend_t onewire_gpio_backend = {
+    .name = "gpio",
+    .init = onewire_gpio_init,
+    .deinit = onewire_gpio_deinit,
+    .reset = onewire_reset,
+    .write_bytes = onewire_write_bytes,
+    .read_bytes = onewire_read_bytes,
+    .write_bit = onewire_write_bit,
+    .read_bit = onewire_read_bit,
+    .stats = &s_stats,
+};
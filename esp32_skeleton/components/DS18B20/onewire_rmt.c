@@ -0,0 +1,252 @@
+// onewire_rmt.c - RMT-timed 1-Wire backend
+//
+// The RMT TX channel drives the line (open drain, looped back into RX) and
+// the RX channel captures it, so slot timing comes from hardware and the
+// calling task blocks on a queue instead of spinning in esp_rom_delay_us().
+// An enabled RMT channel holds an APB-max PM lock, which also keeps the
+// chip out of light sleep, so both channels are enabled only for the
+// length of one transaction.
+#include "onewire_bus.h"
+#include "driver/rmt_tx.h"
+#include "driver/rmt_rx.h"
+#include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "ONEWIRE_RMT";
+
+#define RMT_RESOLUTION_HZ   1000000 // 1 tick = 1 us
+#define RMT_TX_MEM_SYMBOLS  64
+#define RMT_RX_MEM_SYMBOLS  128
+#define RMT_GLITCH_NS       1000
+
+// Slot timings, us
+#define RESET_PULSE_US      500
+#define RESET_WAIT_US       480     // master release time, >= 480
+#define RESET_RX_IDLE_US    (RESET_PULSE_US + 20)
+#define PRESENCE_MIN_US     50      // shortest low that counts as presence
+#define SLOT_START_US       2
+#define SLOT_BIT_US         60
+#define SLOT_RECOVERY_US    2
+#define READ_RX_IDLE_US     100
+#define READ_ZERO_MIN_US    15      // low longer than this reads as 0
+#define READ_CHUNK_BYTES    8       // 64 slots per RX capture
+
+#define RMT_TIMEOUT_MS      20
+
+static rmt_channel_handle_t s_tx;
+static rmt_channel_handle_t s_rx;
+static rmt_encoder_handle_t s_copy_enc;
+static rmt_encoder_handle_t s_bytes_enc;
+static QueueHandle_t s_rx_queue;
+static rmt_symbol_word_t s_rx_buf[RMT_RX_MEM_SYMBOLS];
+static onewire_stats_t s_stats;
+
+static const rmt_symbol_word_t reset_symbol = {
+    .level0 = 0, .duration0 = RESET_PULSE_US,
+    .level1 = 1, .duration1 = RESET_WAIT_US,
+};
+static const rmt_symbol_word_t bit0_symbol = {
+    .level0 = 0, .duration0 = SLOT_BIT_US,
+    .level1 = 1, .duration1 = SLOT_RECOVERY_US,
+};
+static const rmt_symbol_word_t bit1_symbol = {
+    .level0 = 0, .duration0 = SLOT_START_US,
+    .level1 = 1, .duration1 = SLOT_BIT_US,
+};
+static const rmt_transmit_config_t tx_conf = {
+    .loop_count = 0,
+    .flags.eot_level = 1, // release the bus when done
+};
+
+static bool IRAM_ATTR rx_done_cb(rmt_channel_handle_t channel,
+                                 const rmt_rx_done_event_data_t *edata, void *user_data) {
+    BaseType_t woken = pdFALSE;
+    xQueueSendFromISR((QueueHandle_t)user_data, edata, &woken);
+    return woken == pdTRUE;
+}
+
+// Waits for the TX queue to drain and, if rx is set, for the capture.
+static esp_err_t finish(rmt_rx_done_event_data_t *rx) {
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t err = ESP_OK;
+    if (rx && xQueueReceive(s_rx_queue, rx, pdMS_TO_TICKS(RMT_TIMEOUT_MS) + 1) != pdTRUE) {
+        err = ESP_ERR_TIMEOUT;
+    }
+    esp_err_t tx_err = rmt_tx_wait_all_done(s_tx, RMT_TIMEOUT_MS);
+    s_stats.blocked_us += esp_timer_get_time() - t0;
+    return err != ESP_OK ? err : tx_err;
+}
+
+static esp_err_t bus_enable(void) {
+    esp_err_t err = rmt_enable(s_rx);
+    return err == ESP_OK ? rmt_enable(s_tx) : err;
+}
+
+// The line stays released: the last TX level was eot_level.
+static void bus_disable(void) {
+    rmt_disable(s_tx);
+    rmt_disable(s_rx);
+}
+
+static void onewire_rmt_deinit(void) {
+    if (s_tx) { rmt_del_channel(s_tx); s_tx = NULL; }
+    if (s_rx) { rmt_del_channel(s_rx); s_rx = NULL; }
+    if (s_copy_enc) { rmt_del_encoder(s_copy_enc); s_copy_enc = NULL; }
+    if (s_bytes_enc) { rmt_del_encoder(s_bytes_enc); s_bytes_enc = NULL; }
+    if (s_rx_queue) { vQueueDelete(s_rx_queue); s_rx_queue = NULL; }
+}
+
+static esp_err_t onewire_rmt_init(int gpio) {
+    // RX first: the TX channel then joins the same pad in open-drain mode.
+    rmt_rx_channel_config_t rx_cfg = {
+        .gpio_num = gpio,
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .resolution_hz = RMT_RESOLUTION_HZ,
+        .mem_block_symbols = RMT_RX_MEM_SYMBOLS,
+    };
+    rmt_tx_channel_config_t tx_cfg = {
+        .gpio_num = gpio,
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .resolution_hz = RMT_RESOLUTION_HZ,
+        .mem_block_symbols = RMT_TX_MEM_SYMBOLS,
+        .trans_queue_depth = 4,
+        .flags.io_loop_back = true,
+        .flags.io_od_mode = true,
+    };
+    rmt_bytes_encoder_config_t bytes_cfg = {
+        .bit0 = bit0_symbol,
+        .bit1 = bit1_symbol,
+        .flags.msb_first = 0,
+    };
+    rmt_copy_encoder_config_t copy_cfg = {};
+    rmt_rx_event_callbacks_t cbs = { .on_recv_done = rx_done_cb };
+
+    s_rx_queue = xQueueCreate(1, sizeof(rmt_rx_done_event_data_t));
+    esp_err_t err = s_rx_queue ? ESP_OK : ESP_ERR_NO_MEM;
+    if (err == ESP_OK) err = rmt_new_rx_channel(&rx_cfg, &s_rx);
+    if (err == ESP_OK) err = rmt_new_tx_channel(&tx_cfg, &s_tx);
+    if (err == ESP_OK) err = rmt_new_bytes_encoder(&bytes_cfg, &s_bytes_enc);
+    if (err == ESP_OK) err = rmt_new_copy_encoder(&copy_cfg, &s_copy_enc);
+    if (err == ESP_OK) err = rmt_rx_register_event_callbacks(s_rx, &cbs, s_rx_queue);
+    if (err == ESP_OK) err = gpio_pullup_en(gpio);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "init on GPIO %d failed: %s", gpio, esp_err_to_name(err));
+        onewire_rmt_deinit();
+    }
+    return err;
+}
+
+static bool onewire_rmt_reset(void) {
+    int64_t start = esp_timer_get_time();
+    rmt_receive_config_t rx_conf = {
+        .signal_range_min_ns = RMT_GLITCH_NS,
+        .signal_range_max_ns = RESET_RX_IDLE_US * 1000,
+    };
+    rmt_rx_done_event_data_t rx;
+    bool presence = false;
+
+    esp_err_t err = bus_enable();
+    if (err == ESP_OK) err = rmt_receive(s_rx, s_rx_buf, sizeof(s_rx_buf), &rx_conf);
+    if (err == ESP_OK) {
+        err = rmt_transmit(s_tx, s_copy_enc, &reset_symbol, sizeof(reset_symbol), &tx_conf);
+    }
+    if (err == ESP_OK) err = finish(&rx);
+    bus_disable();
+    // symbol 0 is our reset pulse and the release; the device's presence
+    // pulse is the low half of symbol 1.
+    if (err == ESP_OK && rx.num_symbols >= 2) {
+        presence = rx.received_symbols[1].level0 == 0 &&
+                   rx.received_symbols[1].duration0 >= PRESENCE_MIN_US;
+    }
+    s_stats.transactions++;
+    s_stats.wall_us += esp_timer_get_time() - start;
+    return presence;
+}
+
+static esp_err_t onewire_rmt_write_bytes(const uint8_t *data, size_t len) {
+    int64_t start = esp_timer_get_time();
+    esp_err_t err = bus_enable();
+    if (err == ESP_OK) err = rmt_transmit(s_tx, s_bytes_enc, data, len, &tx_conf);
+    if (err == ESP_OK) err = finish(NULL);
+    bus_disable();
+    s_stats.transactions++;
+    s_stats.wall_us += esp_timer_get_time() - start;
+    return err;
+}
+
+// Read slots are write-1 slots; a device answering 0 stretches the low.
+static esp_err_t onewire_rmt_read_bytes(uint8_t *data, size_t len) {
+    static const uint8_t ones[READ_CHUNK_BYTES] = {
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+    };
+    int64_t start = esp_timer_get_time();
+    rmt_receive_config_t rx_conf = {
+        .signal_range_min_ns = RMT_GLITCH_NS,
+        .signal_range_max_ns = READ_RX_IDLE_US * 1000,
+    };
+    esp_err_t err = bus_enable();
+
+    for (size_t off = 0; off < len && err == ESP_OK; off += READ_CHUNK_BYTES) {
+        size_t n = len - off < READ_CHUNK_BYTES ? len - off : READ_CHUNK_BYTES;
+        rmt_rx_done_event_data_t rx;
+        err = rmt_receive(s_rx, s_rx_buf, sizeof(s_rx_buf), &rx_conf);
+        if (err == ESP_OK) err = rmt_transmit(s_tx, s_bytes_enc, ones, n, &tx_conf);
+        if (err == ESP_OK) err = finish(&rx);
+        if (err == ESP_OK && rx.num_symbols < n * 8) err = ESP_ERR_INVALID_SIZE;
+        for (size_t i = 0; err == ESP_OK && i < n * 8; i++) {
+            if (i % 8 == 0) data[off + i / 8] = 0;
+            if (rx.received_symbols[i].duration0 <= READ_ZERO_MIN_US) {
+                data[off + i / 8] |= 1 << (i % 8);
+            }
+        }
+    }
+    bus_disable();
+    s_stats.transactions++;
+    s_stats.wall_us += esp_timer_get_time() - start;
+    return err;
+}
+
+static esp_err_t onewire_rmt_write_bit(bool bit) {
+    esp_err_t err = bus_enable();
+    if (err == ESP_OK) {
+        err = rmt_transmit(s_tx, s_copy_enc, bit ? &bit1_symbol : &bit0_symbol,
+                           sizeof(rmt_symbol_word_t), &tx_conf);
+    }
+    if (err == ESP_OK) err = finish(NULL);
+    bus_disable();
+    return err;
+}
+
+static esp_err_t onewire_rmt_read_bit(bool *bit) {
+    rmt_receive_config_t rx_conf = {
+        .signal_range_min_ns = RMT_GLITCH_NS,
+        .signal_range_max_ns = READ_RX_IDLE_US * 1000,
+    };
+    rmt_rx_done_event_data_t rx;
+    esp_err_t err = bus_enable();
+    if (err == ESP_OK) err = rmt_receive(s_rx, s_rx_buf, sizeof(s_rx_buf), &rx_conf);
+    if (err == ESP_OK) {
+        err = rmt_transmit(s_tx, s_copy_enc, &bit1_symbol, sizeof(bit1_symbol), &tx_conf);
+    }
+    if (err == ESP_OK) err = finish(&rx);
+    bus_disable();
+    if (err == ESP_OK && rx.num_symbols < 1) err = ESP_ERR_INVALID_SIZE;
+    if (err == ESP_OK) *bit = rx.received_symbols[0].duration0 <= READ_ZERO_MIN_US;
+    return err;
+}
+
+const onewire_backend_t onewire_rmt_backend = {
+    .name = "rmt",
+    .init = onewire_rmt_init,
+    .deinit = onewire_rmt_deinit,
+    .reset = onewire_rmt_reset,
+    .write_bytes = onewire_rmt_write_bytes,
+    .read_bytes = onewire_rmt_read_bytes,
+    .write_bit = onewire_rmt_write_bit,
+    .read_bit = onewire_rmt_read_bit,
+    .stats = &s_stats,
+};
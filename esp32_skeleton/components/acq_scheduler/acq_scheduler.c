@@ -0,0 +1,129 @@
+// acq_scheduler.c - overlapped sensor acquisition for one wake cycle
+#include "acq_scheduler.h"
+#include <stdbool.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "ACQ";
+
+static RTC_DATA_ATTR acq_timings_t s_last;
+
+// Whole ticks only; collect() covers the sub-tick rest with the driver's own wait.
+static void wait_until(int64_t due_us) {
+    const int64_t tick_us = portTICK_PERIOD_MS * 1000;
+    int64_t left = due_us - esp_timer_get_time();
+    if (left >= tick_us) vTaskDelay((TickType_t)(left / tick_us));
+}
+
+static int earliest(const int64_t *due, const bool *pending, int count) {
+    int next = -1;
+    for (int i = 0; i < count; i++) {
+        if (pending[i] && (next < 0 || due[i] < due[next])) next = i;
+    }
+    return next;
+}
+
+// Sleeps until the earliest pending job is due and returns it, -1 when
+// none is left. Polled jobs are asked again every poll_ms on the way and
+// move ahead when they report done early.
+static int wait_next(const acq_job_t *jobs, int64_t *due, const bool *pending, int count) {
+    for (;;) {
+        int next = earliest(due, pending, count);
+        if (next < 0) return -1;
+        int64_t now = esp_timer_get_time();
+        uint32_t poll_ms = 0;
+        for (int i = 0; i < count; i++) {
+            if (!pending[i] || !jobs[i].poll_ms || due[i] <= now) continue;
+            if (!poll_ms || jobs[i].poll_ms < poll_ms) poll_ms = jobs[i].poll_ms;
+        }
+        if (!poll_ms || due[next] - now <= poll_ms * 1000LL) {
+            wait_until(due[next]);
+            return next;
+        }
+        TickType_t ticks = pdMS_TO_TICKS(poll_ms);
+        vTaskDelay(ticks ? ticks : 1);
+        now = esp_timer_get_time();
+        for (int i = 0; i < count; i++) {
+            if (!pending[i] || !jobs[i].poll_ms || due[i] <= now) continue;
+            int64_t d = jobs[i].due(jobs[i].ctx);
+            if (d < due[i]) due[i] = d < now ? now : d;
+        }
+    }
+}
+
+int acq_run(const acq_job_t *jobs, int count) {
+    if (count > ACQ_MAX_JOBS) count = ACQ_MAX_JOBS;
+    acq_timings_t t = { .count = (uint8_t)count };
+    int64_t due[ACQ_MAX_JOBS];
+    bool pending[ACQ_MAX_JOBS];
+    int failed = 0;
+    const int64_t t0 = esp_timer_get_time();
+
+    for (int i = 0; i < count; i++) {
+        const acq_job_t *job = &jobs[i];
+        acq_phase_t *ph = &t.phase[i];
+        strncpy(ph->name, job->name, ACQ_NAME_LEN - 1);
+
+        int64_t begin = esp_timer_get_time();
+        int err = job->start ? job->start(job->ctx) : 0;
+        int64_t end = esp_timer_get_time();
+        due[i] = job->due ? job->due(job->ctx) : end;
+        if (due[i] < end) due[i] = end;
+
+        ph->start_us = (uint32_t)(end - begin);
+        ph->due_us = (uint32_t)(due[i] - t0);
+        t.sequential_us += (uint32_t)(due[i] - begin);
+        pending[i] = err == 0;
+        if (err) {
+            ph->result = -1;
+            failed++;
+            ESP_LOGW(TAG, "%s: start failed", job->name);
+        }
+    }
+
+    for (;;) {
+        int64_t begin = esp_timer_get_time();
+        int next = wait_next(jobs, due, pending, count);
+        if (next < 0) break;
+
+        const acq_job_t *job = &jobs[next];
+        acq_phase_t *ph = &t.phase[next];
+        int64_t ready = esp_timer_get_time();
+        int err = job->collect(job->ctx);
+        int64_t end = esp_timer_get_time();
+
+        ph->wait_us = (uint32_t)(ready - begin);
+        ph->collect_us = (uint32_t)(end - ready);
+        ph->done_us = (uint32_t)(end - t0);
+        t.sequential_us += ph->collect_us;
+        pending[next] = false;
+        if (err) {
+            ph->result = -1;
+            failed++;
+            ESP_LOGW(TAG, "%s: collect failed", job->name);
+        }
+    }
+
+    t.total_us = (uint32_t)(esp_timer_get_time() - t0);
+    s_last = t;
+    return failed;
+}
+
+const acq_timings_t *acq_last_timings(void) {
+    return &s_last;
+}
+
+void acq_log_timings(void) {
+    for (int i = 0; i < s_last.count; i++) {
+        const acq_phase_t *ph = &s_last.phase[i];
+        ESP_LOGI(TAG, "%-7s start %6lu  due %7lu  wait %7lu  collect %7lu  done %7lu us%s", ph->name,
+                 (unsigned long)ph->start_us, (unsigned long)ph->due_us, (unsigned long)ph->wait_us,
+                 (unsigned long)ph->collect_us, (unsigned long)ph->done_us, ph->result ? "  FAILED" : "");
+    }
+    ESP_LOGI(TAG, "acquisition %lu us (%lu us in sequence)",
+             (unsigned long)s_last.total_us, (unsigned long)s_last.sequential_us);
+}
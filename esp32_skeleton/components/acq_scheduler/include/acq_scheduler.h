@@ -0,0 +1,55 @@
+// acq_scheduler.h - overlapped sensor acquisition for one wake cycle
+#ifndef ACQ_SCHEDULER_H
+#define ACQ_SCHEDULER_H
+
+#include <stdint.h>
+
+#define ACQ_MAX_JOBS 8
+#define ACQ_NAME_LEN 8
+
+/* One sensor conversion. start() triggers it and returns at once, due()
+ * says when the result will be ready, collect() reads it (and may wait out
+ * a sub-tick remainder itself). start and due may be NULL: nothing to
+ * trigger / ready at once. start and collect return 0 or -1. With poll_ms,
+ * due is asked again that often while the job waits, so a conversion that
+ * reports done early (due <= now) is collected early. */
+typedef struct {
+    const char *name;
+    int (*start)(void *ctx);
+    int64_t (*due)(void *ctx);     // esp_timer time
+    int (*collect)(void *ctx);
+    void *ctx;
+    uint16_t poll_ms;              // 0: due is a fixed deadline
+} acq_job_t;
+
+/* Per-job timing of the last run, in us from the start of the run unless
+ * noted. */
+typedef struct {
+    char name[ACQ_NAME_LEN];
+    int8_t result;          // 0, or -1 if start or collect failed
+    uint32_t start_us;      // time spent in start()
+    uint32_t due_us;        // result due
+    uint32_t wait_us;       // blocked before collect()
+    uint32_t collect_us;    // time spent in collect()
+    uint32_t done_us;       // result in hand
+} acq_phase_t;
+
+typedef struct {
+    uint8_t count;
+    uint32_t total_us;      // wall time of the run
+    uint32_t sequential_us; // the same jobs one after the other
+    acq_phase_t phase[ACQ_MAX_JOBS];
+} acq_timings_t;
+
+/* Starts every job in table order, then collects each as it falls due
+ * (earliest first, table order on a tie). The run lasts about as long as
+ * the slowest conversion instead of the sum of all of them. Returns the
+ * number of jobs that failed. */
+int acq_run(const acq_job_t *jobs, int count);
+
+/* Timings of the last run; kept in RTC memory across deep sleep. */
+const acq_timings_t *acq_last_timings(void);
+
+void acq_log_timings(void);
+
+#endif // ACQ_SCHEDULER_H
@@ -0,0 +1,192 @@
+// adc_service.c - shared ADC1 one-shot sampling for the analog probes
+#include "adc_service.h"
+#include "probe_power.h"
+#include "esp_adc/adc_oneshot.h"
+#include "esp_adc/adc_cali.h"
+#include "esp_adc/adc_cali_scheme.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "ADC_SERVICE";
+
+#define TRIM (ADC_SERVICE_OVERSAMPLE / 4)
+
+typedef struct {
+    adc_channel_t channel;
+    probe_power_mask_t power;   // probe supplies this channel needs
+    adc_service_reading_t last;
+} adc_slot_t;
+
+static adc_oneshot_unit_handle_t s_unit;
+static adc_cali_handle_t s_cali;
+static adc_slot_t s_slots[ADC_SERVICE_MAX_CHANNELS];
+static int s_count;
+static int64_t s_burst_at_us = -1;
+static uint32_t s_burst_us;
+
+static void cali_init(void) {
+    esp_err_t err = ESP_ERR_NOT_SUPPORTED;
+#if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
+    adc_cali_curve_fitting_config_t cfg = {
+        .unit_id = ADC_UNIT_1,
+        .atten = ADC_SERVICE_ATTEN,
+        .bitwidth = ADC_BITWIDTH_12,
+    };
+    err = adc_cali_create_scheme_curve_fitting(&cfg, &s_cali);
+#elif ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
+    adc_cali_line_fitting_config_t cfg = {
+        .unit_id = ADC_UNIT_1,
+        .atten = ADC_SERVICE_ATTEN,
+        .bitwidth = ADC_BITWIDTH_12,
+    };
+    err = adc_cali_create_scheme_line_fitting(&cfg, &s_cali);
+#endif
+    if (err != ESP_OK) {
+        s_cali = NULL;
+        ESP_LOGW(TAG, "No ADC calibration (%s), using linear mV", esp_err_to_name(err));
+    }
+}
+
+static esp_err_t channel_config(adc_channel_t channel) {
+    adc_oneshot_chan_cfg_t cfg = {
+        .atten = ADC_SERVICE_ATTEN,
+        .bitwidth = ADC_BITWIDTH_12,
+    };
+    return adc_oneshot_config_channel(s_unit, channel, &cfg);
+}
+
+// Creates the unit (again, after adc_service_release()) with every
+// registered channel configured.
+static esp_err_t unit_init(void) {
+    if (s_unit) return ESP_OK;
+    adc_oneshot_unit_init_cfg_t cfg = { .unit_id = ADC_UNIT_1 };
+    esp_err_t err = adc_oneshot_new_unit(&cfg, &s_unit);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "ADC1 init failed: %s", esp_err_to_name(err));
+        return err;
+    }
+    cali_init();
+    for (int i = 0; i < s_count && err == ESP_OK; i++) {
+        err = channel_config(s_slots[i].channel);
+    }
+    return err;
+}
+
+esp_err_t adc_service_add_channel(adc_channel_t channel) {
+    for (int i = 0; i < s_count; i++) {
+        if (s_slots[i].channel == channel) return ESP_OK;
+    }
+    if (s_count == ADC_SERVICE_MAX_CHANNELS) return ESP_ERR_NO_MEM;
+    esp_err_t err = s_unit ? channel_config(channel) : ESP_OK;
+    if (err != ESP_OK) return err;
+    s_slots[s_count++] = (adc_slot_t){ .channel = channel };
+    s_burst_at_us = -1; // the last burst did not sample it
+    return unit_init();
+}
+
+esp_err_t adc_service_set_power(adc_channel_t channel, int probe_id) {
+    if (probe_id < 0 || probe_id >= PROBE_POWER_MAX) return ESP_ERR_INVALID_ARG;
+    for (int i = 0; i < s_count; i++) {
+        if (s_slots[i].channel == channel) {
+            s_slots[i].power = 1u << probe_id;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+// Mean of the middle half after sorting; n is small, insertion sort is fine.
+static int trimmed_mean(int *v, int n) {
+    for (int i = 1; i < n; i++) {
+        int x = v[i], j = i;
+        while (j > 0 && v[j - 1] > x) { v[j] = v[j - 1]; j--; }
+        v[j] = x;
+    }
+    int lo = n * TRIM / ADC_SERVICE_OVERSAMPLE;
+    int hi = n - lo;
+    int sum = 0;
+    for (int i = lo; i < hi; i++) sum += v[i];
+    return (sum + (hi - lo) / 2) / (hi - lo);
+}
+
+esp_err_t adc_service_burst(void) {
+    if (s_count == 0) return ESP_ERR_INVALID_STATE;
+    esp_err_t err = unit_init(); // no-op unless released for the ULP
+    if (err != ESP_OK) return err;
+    int buf[ADC_SERVICE_MAX_CHANNELS][ADC_SERVICE_OVERSAMPLE];
+    int n[ADC_SERVICE_MAX_CHANNELS] = { 0 };
+    probe_power_mask_t power = 0;
+    for (int c = 0; c < s_count; c++) power |= s_slots[c].power;
+    probe_power_on(power);
+    int64_t start = esp_timer_get_time();
+
+    // Interleave the channels so slow drift hits all of them alike.
+    for (int k = 0; k < ADC_SERVICE_OVERSAMPLE; k++) {
+        if (esp_timer_get_time() - start > ADC_SERVICE_BUDGET_US) {
+            ESP_LOGW(TAG, "Burst over budget after %d rounds", k);
+            break;
+        }
+        for (int c = 0; c < s_count; c++) {
+            if (adc_oneshot_read(s_unit, s_slots[c].channel, &buf[c][n[c]]) == ESP_OK) n[c]++;
+        }
+    }
+    probe_power_off(power);
+
+    esp_err_t ret = ESP_OK;
+    for (int c = 0; c < s_count; c++) {
+        adc_service_reading_t *r = &s_slots[c].last;
+        r->samples = n[c];
+        if (n[c] == 0) {
+            r->raw = r->mv = -1;
+            ret = ESP_FAIL;
+            continue;
+        }
+        r->raw = trimmed_mean(buf[c], n[c]);
+        if (!s_cali || adc_cali_raw_to_voltage(s_cali, r->raw, &r->mv) != ESP_OK) {
+            r->mv = r->raw * 3300 / 4095;
+        }
+    }
+    s_burst_at_us = esp_timer_get_time();
+    s_burst_us = (uint32_t)(s_burst_at_us - start);
+    return ret;
+}
+
+esp_err_t adc_service_read(adc_channel_t channel, adc_service_reading_t *out) {
+    int c;
+    for (c = 0; c < s_count && s_slots[c].channel != channel; c++) {}
+    if (c == s_count) return ESP_ERR_NOT_FOUND;
+
+    if (s_burst_at_us < 0 || esp_timer_get_time() - s_burst_at_us > ADC_SERVICE_REUSE_US) {
+        esp_err_t err = adc_service_burst();
+        if (err != ESP_OK && s_slots[c].last.samples == 0) return err;
+    }
+    *out = s_slots[c].last;
+    return out->samples ? ESP_OK : ESP_FAIL;
+}
+
+int adc_service_raw_to_mv(int raw) {
+    int mv;
+    if (unit_init() != ESP_OK || !s_cali || adc_cali_raw_to_voltage(s_cali, raw, &mv) != ESP_OK) {
+        mv = raw * 3300 / 4095;
+    }
+    return mv;
+}
+
+void adc_service_release(void) {
+    if (s_cali) {
+#if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
+        adc_cali_delete_scheme_curve_fitting(s_cali);
+#elif ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
+        adc_cali_delete_scheme_line_fitting(s_cali);
+#endif
+        s_cali = NULL;
+    }
+    if (s_unit) {
+        adc_oneshot_del_unit(s_unit);
+        s_unit = NULL;
+    }
+}
+
+uint32_t adc_service_last_burst_us(void) {
+    return s_burst_us;
+}
@@ -0,0 +1,56 @@
+// adc_service.h - shared ADC1 one-shot sampling for the analog probes
+#ifndef ADC_SERVICE_H
+#define ADC_SERVICE_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "hal/adc_types.h"
+
+#define ADC_SERVICE_MAX_CHANNELS 4
+#define ADC_SERVICE_ATTEN        ADC_ATTEN_DB_12  // ~0-3.1 V full scale
+
+/* Per-channel samples in one burst; the lowest and highest quarter are
+ * dropped and the middle half averaged (trimmed mean). */
+#define ADC_SERVICE_OVERSAMPLE   16
+
+/* Hard cap on one burst. If it runs out the burst uses what it got. */
+#define ADC_SERVICE_BUDGET_US    5000
+
+/* A read within this long of the last burst reuses it, so drivers read
+ * one after the other still share one burst per wake. */
+#define ADC_SERVICE_REUSE_US     100000
+
+typedef struct {
+    int raw;          // trimmed mean, 0-4095
+    int mv;           // calibrated (eFuse) if available, else linear
+    uint8_t samples;  // samples taken for this channel
+} adc_service_reading_t;
+
+/* Adds an ADC1 channel to the burst. Creates the unit and calibration
+ * on first use; adding the same channel twice is a no-op. */
+esp_err_t adc_service_add_channel(adc_channel_t channel);
+
+/* Gates `channel` on probe `probe_id` (probe_power.h): each burst powers
+ * the probes its channels need, waits their settle time, samples, and
+ * powers them off again. */
+esp_err_t adc_service_set_power(adc_channel_t channel, int probe_id);
+
+/* Samples every registered channel now, interleaved. */
+esp_err_t adc_service_burst(void);
+
+/* Result for `channel` from the last burst, bursting first if there is
+ * no recent one. */
+esp_err_t adc_service_read(adc_channel_t channel, adc_service_reading_t *out);
+
+/* Converts a raw 12-bit reading taken at ADC_SERVICE_ATTEN (e.g. by the
+ * ULP) to mV with the same calibration. Creates the unit if needed. */
+int adc_service_raw_to_mv(int raw);
+
+/* Frees ADC1 (e.g. for the ULP before deep sleep). Registered channels
+ * are kept and the unit is re-created on the next use. */
+void adc_service_release(void);
+
+/* Duration of the last burst's sampling, settle time not included. */
+uint32_t adc_service_last_burst_us(void);
+
+#endif // ADC_SERVICE_H
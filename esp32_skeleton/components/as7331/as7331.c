@@ -1,9 +1,17 @@
 // as7331.c - AS7331 sensor driver source (stub)
 #include "as7331.h"
+#include <math.h>
+#include <stdbool.h>
 #include <stdio.h>
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
+static const char *TAG = "AS7331";
+
 #define AS7331_ADDR 0x74 // page 42: AS7331 sensor's I2C address- Can run 4 AS7331s on the same I2C bus with A1 and A0 pins defining two lowest-order bits (high or low) - Assuming both A1 and A0 tied to GND
 #define OPERATIONAL_STATE_REG_AS7331 0x00 // page 48: OSR is at 0x00
 #define RESET_VALUE_AS7331 0x08 // page 49: Set SW_RES bit (bit 3) to 1
@@ -11,77 +19,163 @@
 #define MEASUREMENT_VALUE_AS7331 0x03 // page 49: 011 sets operational state to measurement
 #define CREG3_AS7331 0x08 // page 48: config register for clock frequency
 #define CREG3_CCLK_VALUE 0x00 // page 56: 00 sets internal clock frequency to 1.024 MHz
+#define CREG3_MMODE_CMD 0x40 // page 56: MMODE 01 = CMD mode, one conversion per start (00 would be CONT)
 #define CREG1_AS7331 0x06 // page 48: config register for gain and time
 #define CREG1_TIME_GAIN_VALUE_AS7331 0xA7 // page 51: set gain to 2x and time to 128ms
+#define CREG1_TIME_MASK 0x0F // page 51: TIME code, conversion time 2^TIME ms
+#define CREG1_GAIN_SHIFT 4 // page 51: GAIN code, gain 2^(11 - GAIN)
+#define GAIN_CODE_MAX 11 // 1x
+#define TIME_CODE_MAX 14 // 16384 ms
 #define CREG2_AS7331 0x07 // Configuration Register 2
 #define CREG2_VALUE_AS7331 0x00 // Default configuration
 #define OUTCONV_REG_AS7331 0x05 // OUTCONV register
+#define AS7331_SCL_HZ 100000
 #define I2C_MASTER_SCL 22 // ESP32's SCL pin
 #define I2C_MASTER_SDA 21 // ESP32's SDA pin
 #define UV_MEASUREMENT_START_REG 0x02 // page 59: MRES1 register - ONLY IN MEASUREMENT MODE
 #define UV_MEASUREMENT_TRIGGER_VALUE 0x83 // Start bit for measurement
+#define OSR_PD 0x40 // page 49: PD bit 6, power down (the reset state is PD + configuration)
 #define UV_MEASUREMENT_STATUS_REG 0x0A   // Status register for measurement
 #define I2C_PORT_DEFAULT I2C_NUM_0 // I2C port
 #define I2C_MASTER_TX_BUF_DISABLE 0
 #define I2C_MASTER_RX_BUF_DISABLE 0
 #define STATUS_REG 0x00
+#define STATUS_NOTREADY 0x04 // page 50: STATUS (read with OSR) bit 2, conversion in progress
+#define STATUS_NDATA 0x08 // page 50: STATUS bit 3, new data in MRES1-3
+#define STATUS_OVERFLOW 0xE0 // page 50: STATUS bits 7-5, OUTCONVOF / MRESOF / ADCOF
+#define READY_POLL_TICKS 1 // re-check STATUS every tick once the conversion time has passed
+#define READY_POLL_MAX 5
+#define READY_TIMEOUT_MARGIN_MS 20
 
-esp_err_t as7331_init(AS7331 *dev, i2c_master_bus_handle_t main_bus) {
+// Auto-ranging: shortest conversion whose predicted peak count lands in
+// [LOW, HIGH] of full scale. Times are bounded to keep a wake short.
+#define AR_TIME_CODE_MIN 3 // 8 ms, 13-bit result
+#define AR_TIME_CODE_MAX 9 // 512 ms
+#define AR_WINDOW_LOW 0.20f
+#define AR_WINDOW_HIGH 0.70f
+#define AR_DARK_COUNTS 4.0f // predicted peak below this at max exposure = dark, stay short
+#define AR_OVERFLOW_FACTOR 16.0f // a saturated reading is assumed at least this far over
 
-    if (!dev) return ESP_ERR_INVALID_ARG;
+/* Last gain/time, kept across deep sleep so each wake starts from the previous light level. */
+typedef struct {
+    uint8_t gain_code;
+    uint8_t time_code;
+    bool valid;
+} as7331_range_t;
 
-    dev->bus = main_bus;
-    // 1. (Optional) Initialize I2C bus here if not done elsewhere
-    // i2c_master_bus_config_t bus_cfg = {
-    //       .i2c_port = I2C_PORT_DEFAULT,
-    //       .sda_io_num = I2C_MASTER_SDA,
-    //       .scl_io_num = I2C_MASTER_SCL,
-    //       .clk_source = I2C_CLK_SRC_DEFAULT,
-    //       .glitch_ignore_cnt = 7,
-    //       .flags.enable_internal_pullup = true,
-    //   };
-    //   ESP_ERROR_CHECK(i2c_new_master_bus(&bus_cfg, &dev->bus));
+static RTC_DATA_ATTR as7331_range_t s_range;
 
-      i2c_device_config_t dev_cfg = {
-          .dev_addr_length = I2C_ADDR_BIT_LEN_7,
-          .device_address = AS7331_ADDR,
-          .scl_speed_hz = 100000,
-      };
-      ESP_ERROR_CHECK(i2c_master_bus_add_device(dev->bus, &dev_cfg, &dev->dev));
+/* Typical responsivity at gain 1x, 64 ms, in counts/(uW/cm^2) (datasheet page 12). */
+static const float inv_resp_1x_64ms[3] = { 1.0f / 0.205f, 1.0f / 0.157f, 1.0f / 0.326f };
+
+/* Responsivity scales with gain * time, so the per-count factor relative to
+ * 1x/64 ms is 64 / (2^(11 - GAIN) * 2^TIME) = 2^(GAIN - TIME - 5). */
+#define GT_SCALE(g, t) ((float)(1u << (g)) / (float)(1u << ((t) + 5)))
+#define GT_ROW(g) { GT_SCALE(g, 0), GT_SCALE(g, 1), GT_SCALE(g, 2), GT_SCALE(g, 3), GT_SCALE(g, 4), \
+                    GT_SCALE(g, 5), GT_SCALE(g, 6), GT_SCALE(g, 7), GT_SCALE(g, 8), GT_SCALE(g, 9), \
+                    GT_SCALE(g, 10), GT_SCALE(g, 11), GT_SCALE(g, 12), GT_SCALE(g, 13), GT_SCALE(g, 14) }
+
+static const float gain_time_scale[GAIN_CODE_MAX + 1][TIME_CODE_MAX + 1] = {
+    GT_ROW(0), GT_ROW(1), GT_ROW(2), GT_ROW(3), GT_ROW(4), GT_ROW(5),
+    GT_ROW(6), GT_ROW(7), GT_ROW(8), GT_ROW(9), GT_ROW(10), GT_ROW(11),
+};
+
+// Per-channel factors for the CREG1 just written. `time_ratio` corrects for
+// a conversion that did not last the nominal 2^TIME ms (OUTCONV / nominal).
+static void select_scale(AS7331 *dev, float time_ratio)
+{
+    float gt = gain_time_scale[dev->gain_code][dev->time_code] / time_ratio;
+    for (int ch = 0; ch < 3; ch++) {
+        dev->scale[ch] = inv_resp_1x_64ms[ch] * gt;
+    }
+}
+
+static esp_err_t write_reg(AS7331 *dev, uint8_t reg, uint8_t value)
+{
+    uint8_t cmd[2] = {reg, value};
+    return i2c_bus_write(dev->dev, cmd, sizeof(cmd));
+}
+
+// Reset and register setup, leaving the sensor in measurement mode
+static esp_err_t configure(AS7331 *dev)
+{
+    esp_err_t err;
 
     // Read status register to verify i2c communication
-    uint8_t reg = OPERATIONAL_STATE_REG_AS7331;
     uint8_t status;
-    ESP_ERROR_CHECK(i2c_master_transmit_receive(dev->dev, &reg, 1, &status, 1, pdMS_TO_TICKS(1000)));
+    err = AS7331_read_registers(dev, OPERATIONAL_STATE_REG_AS7331, &status, 1);
+    if (err != ESP_OK) return err;
 
-    uint8_t reset_cmd[] = {OPERATIONAL_STATE_REG_AS7331, RESET_VALUE_AS7331};
-    ESP_ERROR_CHECK(i2c_master_transmit(dev->dev, reset_cmd, sizeof(reset_cmd), pdMS_TO_TICKS(1000)));
+    err = write_reg(dev, OPERATIONAL_STATE_REG_AS7331, RESET_VALUE_AS7331);
+    if (err != ESP_OK) return err;
 
     // Enter CONFIG mode afer reset
-    uint8_t config_cmd[2] = {OPERATIONAL_STATE_REG_AS7331, CONFIG_VALUE_AS7331};
-    ESP_ERROR_CHECK(i2c_master_transmit(dev->dev, config_cmd, 2, pdMS_TO_TICKS(1000)));
+    err = write_reg(dev, OPERATIONAL_STATE_REG_AS7331, CONFIG_VALUE_AS7331);
+    if (err != ESP_OK) return err;
     vTaskDelay(pdMS_TO_TICKS(20));
 
     // Configure measurement parameters
-    uint8_t meas_config[2] = {CREG1_AS7331, CREG1_TIME_GAIN_VALUE_AS7331};
-    ESP_ERROR_CHECK(i2c_master_transmit(dev->dev, meas_config, 2, pdMS_TO_TICKS(1000)));
+    err = write_reg(dev, CREG1_AS7331, dev->creg1);
+    if (err != ESP_OK) return err;
     vTaskDelay(pdMS_TO_TICKS(20));
     
     // Configure CREG2 settings (default)
-    uint8_t creg2_cmd[2] = {CREG2_AS7331, CREG2_VALUE_AS7331};
-    ESP_ERROR_CHECK(i2c_master_transmit(dev->dev, creg2_cmd, 2, pdMS_TO_TICKS(1000)));
+    err = write_reg(dev, CREG2_AS7331, CREG2_VALUE_AS7331);
+    if (err != ESP_OK) return err;
     vTaskDelay(pdMS_TO_TICKS(20));
     
     // Configure clock frequency
-    uint8_t clock_cmd[2] = {CREG3_AS7331, CREG3_CCLK_VALUE};
-    ESP_ERROR_CHECK(i2c_master_transmit(dev->dev, clock_cmd, 2, pdMS_TO_TICKS(1000)));
+    err = write_reg(dev, CREG3_AS7331, CREG3_MMODE_CMD | CREG3_CCLK_VALUE);
+    if (err != ESP_OK) return err;
     vTaskDelay(pdMS_TO_TICKS(20));
     
     // 3. Switch to MEASUREMENT mode
-    uint8_t meas_cmd[2] = {OPERATIONAL_STATE_REG_AS7331, MEASUREMENT_VALUE_AS7331};
-    ESP_ERROR_CHECK(i2c_master_transmit(dev->dev, meas_cmd, 2, pdMS_TO_TICKS(1000)));
+    err = write_reg(dev, OPERATIONAL_STATE_REG_AS7331, MEASUREMENT_VALUE_AS7331);
+    if (err != ESP_OK) return err;
     vTaskDelay(pdMS_TO_TICKS(10));
 
+    return ESP_OK;
+}
+
+esp_err_t as7331_init(AS7331 *dev) {
+
+    if (!dev) return ESP_ERR_INVALID_ARG;
+
+    dev->ready_gpio = GPIO_NUM_NC;
+    dev->trigger_us = -1;
+    dev->auto_range = true;
+    if (s_range.valid) {
+        dev->gain_code = s_range.gain_code;
+        dev->time_code = s_range.time_code;
+    } else {
+        dev->gain_code = CREG1_TIME_GAIN_VALUE_AS7331 >> CREG1_GAIN_SHIFT;
+        dev->time_code = CREG1_TIME_GAIN_VALUE_AS7331 & CREG1_TIME_MASK;
+    }
+    dev->creg1 = (uint8_t)((dev->gain_code << CREG1_GAIN_SHIFT) | dev->time_code);
+    select_scale(dev, 1.0f);
+    dev->outconv_pending = true;
+    // 1. (Optional) Initialize I2C bus here if not done elsewhere
+    // i2c_master_bus_config_t bus_cfg = {
+    //       .i2c_port = I2C_PORT_DEFAULT,
+    //       .sda_io_num = I2C_MASTER_SDA,
+    //       .scl_io_num = I2C_MASTER_SCL,
+    //       .clk_source = I2C_CLK_SRC_DEFAULT,
+    //       .glitch_ignore_cnt = 7,
+    //       .flags.enable_internal_pullup = true,
+    //   };
+    //   ESP_ERROR_CHECK(i2c_new_master_bus(&bus_cfg, &dev->bus));
+
+    esp_err_t err = i2c_bus_add_device(AS7331_ADDR, AS7331_SCL_HZ, &dev->dev);
+    if (err != ESP_OK) return err;
+
+    err = configure(dev);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Init failed: %s", esp_err_to_name(err));
+        i2c_bus_rm_device(dev->dev); // not answering: the next init adds it again
+        dev->dev = NULL;
+        return err;
+    }
+
     printf("AS7331 initialized (real hardware)!\n");
     return ESP_OK;
 }
@@ -91,25 +185,266 @@ esp_err_t as7331_init(AS7331 *dev, i2c_master_bus_handle_t main_bus) {
 esp_err_t AS7331_read_registers(AS7331 *dev, uint8_t reg, uint8_t *data, size_t len)
   {
       if (!dev || !data || !len) return ESP_ERR_INVALID_ARG;
-      return i2c_master_transmit_receive(dev->dev, &reg, 1, data, len, pdMS_TO_TICKS(1000));
+      return i2c_bus_write_read(dev->dev, &reg, 1, data, len);
   }
 
-  esp_err_t as7331_read_light(AS7331 *dev, AS7331_Light *light)
+static void IRAM_ATTR ready_isr(void *arg)
+{
+    AS7331 *dev = (AS7331 *)arg;
+    BaseType_t woken = pdFALSE;
+
+    // READY stays high until the next start, so the level interrupt is one-shot
+    gpio_intr_disable(dev->ready_gpio);
+    xSemaphoreGiveFromISR(dev->ready_sem, &woken);
+    if (woken) portYIELD_FROM_ISR();
+}
+
+esp_err_t as7331_enable_ready_interrupt(AS7331 *dev, gpio_num_t ready_gpio)
+{
+    if (!dev || ready_gpio == GPIO_NUM_NC) return ESP_ERR_INVALID_ARG;
+
+    if (!dev->ready_sem) {
+        dev->ready_sem = xSemaphoreCreateBinary();
+        if (!dev->ready_sem) return ESP_ERR_NO_MEM;
+    }
+
+    // Level rather than edge: GPIO light-sleep wakeup only supports levels
+    gpio_config_t io_cfg = {
+        .pin_bit_mask = 1ULL << ready_gpio,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_HIGH_LEVEL,
+    };
+    esp_err_t err = gpio_config(&io_cfg);
+    if (err != ESP_OK) return err;
+    gpio_intr_disable(ready_gpio);
+
+    err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) return err; // already installed is fine
+    err = gpio_isr_handler_add(ready_gpio, ready_isr, dev);
+    if (err != ESP_OK) return err;
+
+    err = gpio_wakeup_enable(ready_gpio, GPIO_INTR_HIGH_LEVEL);
+    if (err == ESP_OK) err = esp_sleep_enable_gpio_wakeup();
+    if (err != ESP_OK) return err;
+
+    dev->ready_gpio = ready_gpio;
+    ESP_LOGI(TAG, "READY interrupt on GPIO %d", ready_gpio);
+    return ESP_OK;
+}
+
+// In measurement mode OSR and STATUS read back as one 16-bit register
+static esp_err_t read_status(AS7331 *dev, uint8_t *status)
+{
+    uint8_t buf[2];
+    esp_err_t err = AS7331_read_registers(dev, OPERATIONAL_STATE_REG_AS7331, buf, sizeof(buf));
+    if (err == ESP_OK) *status = buf[1];
+    return err;
+}
+
+static bool data_ready(AS7331 *dev)
+{
+    return read_status(dev, &dev->status) == ESP_OK &&
+           (dev->status & STATUS_NDATA) && !(dev->status & STATUS_NOTREADY);
+}
+
+// CREG1 can only be written in configuration state
+static esp_err_t apply_gain_time(AS7331 *dev)
+{
+    uint8_t creg1 = (uint8_t)((dev->gain_code << CREG1_GAIN_SHIFT) | dev->time_code);
+    if (creg1 == dev->creg1) return ESP_OK;
+
+    esp_err_t err = write_reg(dev, OPERATIONAL_STATE_REG_AS7331, CONFIG_VALUE_AS7331);
+    if (err == ESP_OK) err = write_reg(dev, CREG1_AS7331, creg1);
+    if (err == ESP_OK) err = write_reg(dev, OPERATIONAL_STATE_REG_AS7331, MEASUREMENT_VALUE_AS7331);
+    if (err != ESP_OK) return err;
+
+    dev->creg1 = creg1;
+    select_scale(dev, 1.0f);
+    dev->outconv_pending = true;
+    ESP_LOGD(TAG, "Gain %ux, time %u ms", 1u << (GAIN_CODE_MAX - dev->gain_code), 1u << dev->time_code);
+    return ESP_OK;
+}
+
+esp_err_t as7331_set_gain_time(AS7331 *dev, uint8_t gain_code, uint8_t time_code)
+{
+    if (!dev || gain_code > GAIN_CODE_MAX || time_code > TIME_CODE_MAX) return ESP_ERR_INVALID_ARG;
+
+    dev->auto_range = false;
+    dev->gain_code = gain_code;
+    dev->time_code = time_code;
+    return apply_gain_time(dev);
+}
+
+// Largest count a conversion can return: 10 bits at 1 ms, one more per doubling, 16 at most
+static float full_scale(uint8_t time_code)
+{
+    return time_code >= 6 ? 65535.0f : (float)((1u << (10 + time_code)) - 1);
+}
+
+// Picks the next gain/time from the last peak count. Counts scale with
+// gain * 2^time, so the peak is predicted for every candidate; the shortest
+// time wins, with the highest gain that keeps it under the window's top.
+static void auto_range_update(AS7331 *dev, uint16_t peak_raw)
+{
+    int exposure = (GAIN_CODE_MAX - dev->gain_code) + dev->time_code; // log2(gain * ms)
+    float peak = peak_raw;
+    if ((dev->status & STATUS_OVERFLOW) || peak >= full_scale(dev->time_code)) {
+        peak = full_scale(dev->time_code) * AR_OVERFLOW_FACTOR;
+    }
+
+    uint8_t best_gain = 0, best_time = AR_TIME_CODE_MIN; // max gain, shortest time: dark
+    bool found = false;
+    for (uint8_t t = AR_TIME_CODE_MIN; t <= AR_TIME_CODE_MAX && !found; t++) {
+        float high = AR_WINDOW_HIGH * full_scale(t);
+        for (uint8_t g = 0; g <= GAIN_CODE_MAX; g++) {
+            float predicted = ldexpf(peak, (GAIN_CODE_MAX - g) + t - exposure);
+            if (predicted > high) continue;
+            if (predicted >= AR_WINDOW_LOW * full_scale(t)) {
+                best_gain = g;
+                best_time = t;
+                found = true;
+            }
+            break; // lower gains only move further below the window
+        }
+    }
+
+    if (!found) {
+        float max_exposure = ldexpf(peak, GAIN_CODE_MAX + AR_TIME_CODE_MAX - exposure);
+        if (max_exposure > AR_WINDOW_HIGH * full_scale(AR_TIME_CODE_MAX)) {
+            best_gain = GAIN_CODE_MAX; // too bright for any window: least exposure
+            best_time = AR_TIME_CODE_MIN;
+        } else if (max_exposure >= AR_DARK_COUNTS) {
+            best_gain = 0; // dim: longest allowed exposure, below the window
+            best_time = AR_TIME_CODE_MAX;
+        }
+    }
+
+    dev->gain_code = best_gain;
+    dev->time_code = best_time;
+    s_range = (as7331_range_t){ .gain_code = best_gain, .time_code = best_time, .valid = true };
+}
+
+// Blocks until the conversion started by as7331_start_measurement() completes.
+// Both paths block in the scheduler, so with tickless idle the CPU light-sleeps.
+static esp_err_t wait_for_conversion(AS7331 *dev)
+{
+    const uint32_t conv_ms = 1u << dev->time_code;
+
+    if (dev->ready_gpio != GPIO_NUM_NC) {
+        const TickType_t timeout = pdMS_TO_TICKS(2 * conv_ms + READY_TIMEOUT_MARGIN_MS) + 1;
+        const TickType_t start = xTaskGetTickCount();
+        for (;;) {
+            TickType_t elapsed = xTaskGetTickCount() - start;
+            if (elapsed >= timeout ||
+                xSemaphoreTake(dev->ready_sem, timeout - elapsed) != pdTRUE) {
+                gpio_intr_disable(dev->ready_gpio);
+                return ESP_ERR_TIMEOUT;
+            }
+            if (data_ready(dev)) return ESP_OK;
+            // READY was still high from the previous conversion; re-arm a tick later
+            vTaskDelay(READY_POLL_TICKS);
+            gpio_intr_enable(dev->ready_gpio);
+        }
+    }
+
+    // Only what is left of the conversion; the caller may have been busy since the trigger
+    const uint32_t tick_us = portTICK_PERIOD_MS * 1000;
+    int64_t left_us = dev->trigger_us + conv_ms * 1000LL - esp_timer_get_time();
+    if (left_us > 0) {
+        vTaskDelay((TickType_t)((left_us + tick_us - 1) / tick_us));
+    }
+    for (int i = 0; i < READY_POLL_MAX; i++) {
+        if (data_ready(dev)) return ESP_OK;
+        vTaskDelay(READY_POLL_TICKS);
+    }
+    return ESP_ERR_TIMEOUT;
+}
+
+esp_err_t as7331_start_measurement(AS7331 *dev)
+{
+    if (!dev) return ESP_ERR_INVALID_ARG;
+
+    esp_err_t err = apply_gain_time(dev);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set gain/time: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    if (dev->ready_gpio != GPIO_NUM_NC) {
+        xSemaphoreTake(dev->ready_sem, 0); // drop a stale give
+    }
+
+    // Trigger single measurement
+    err = write_reg(dev, OPERATIONAL_STATE_REG_AS7331, UV_MEASUREMENT_TRIGGER_VALUE);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start conversion: %s", esp_err_to_name(err));
+        return err;
+    }
+    dev->trigger_us = esp_timer_get_time();
+    if (dev->ready_gpio != GPIO_NUM_NC) {
+        gpio_intr_enable(dev->ready_gpio);
+    }
+    return ESP_OK;
+}
+
+esp_err_t as7331_power_down(AS7331 *dev)
+{
+    if (!dev || !dev->dev) return ESP_ERR_INVALID_ARG;
+    dev->trigger_us = -1;
+    return write_reg(dev, OPERATIONAL_STATE_REG_AS7331, OSR_PD | CONFIG_VALUE_AS7331);
+}
+
+int64_t as7331_conversion_due_us(const AS7331 *dev)
+{
+    if (!dev || dev->trigger_us < 0) return -1;
+    return dev->trigger_us + (1000LL << dev->time_code);
+}
+
+  esp_err_t as7331_collect_light(AS7331 *dev, AS7331_Light *light)
   {
     if (!dev || !light) return ESP_ERR_INVALID_ARG;
+    if (dev->trigger_us < 0) return ESP_ERR_INVALID_STATE;
 
-    // Trigger single measurement
-    uint8_t trig_cmd[2] = {OPERATIONAL_STATE_REG_AS7331, UV_MEASUREMENT_TRIGGER_VALUE };
-    ESP_ERROR_CHECK(i2c_master_transmit(dev->dev, trig_cmd, sizeof(trig_cmd), pdMS_TO_TICKS(1000)));
-    vTaskDelay(pdMS_TO_TICKS(150));
+    esp_err_t err = wait_for_conversion(dev);
+    dev->last_wait_us = (uint32_t)(esp_timer_get_time() - dev->trigger_us);
+    dev->trigger_us = -1;
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Conversion did not complete after %lu us", (unsigned long)dev->last_wait_us);
+        return err;
+    }
+    ESP_LOGD(TAG, "Conversion ready after %lu us (nominal %u ms)", (unsigned long)dev->last_wait_us,
+             1u << dev->time_code);
 
-    // Read measurement registers
-    uint8_t buf[6];
-    ESP_ERROR_CHECK(AS7331_read_registers(dev, UV_MEASUREMENT_START_REG, buf, sizeof(buf)));
+    // Read measurement registers; OUTCONVL/H follow MRES3, so after a
+    // config change the same burst also returns the conversion clock count
+    uint8_t buf[10];
+    size_t len = dev->outconv_pending ? 10 : 6;
+    err = AS7331_read_registers(dev, UV_MEASUREMENT_START_REG, buf, len);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to read results: %s", esp_err_to_name(err));
+        return err;
+    }
 
     uint16_t raw_uva = ((uint16_t)buf[1] << 8) | buf[0];
     uint16_t raw_uvb = ((uint16_t)buf[3] << 8) | buf[2];
     uint16_t raw_uvc = ((uint16_t)buf[5] << 8) | buf[4];
+    uint16_t peak = raw_uva > raw_uvb ? raw_uva : raw_uvb;
+    if (raw_uvc > peak) peak = raw_uvc;
+
+    if (dev->outconv_pending) {
+        // 24-bit clock count (OUTCONVL + low byte of OUTCONVH) at 1.024 MHz
+        uint32_t outconv = ((uint32_t)buf[8] << 16) | ((uint32_t)buf[7] << 8) | buf[6];
+        uint32_t nominal = 1024u << dev->time_code;
+        if (outconv) {
+            select_scale(dev, (float)outconv / nominal);
+        }
+        if (outconv < nominal - nominal / 100 || outconv > nominal + nominal / 100) {
+            ESP_LOGW(TAG, "OUTCONV %lu, expected %lu", (unsigned long)outconv, (unsigned long)nominal);
+        }
+        dev->outconv_pending = false;
+    }
 
     // Change raw values by setting floor value to 0 when there is complete darkness
     // raw_uva --;
@@ -121,24 +456,14 @@ esp_err_t AS7331_read_registers(AS7331 *dev, uint8_t reg, uint8_t *data, size_t
     dev->light_reading_raw[1] = raw_uvb;
     dev->light_reading_raw[2] = raw_uvc;
 
-    // Get integration time in seconds
-    uint8_t outconv_buf[2];
-    ESP_ERROR_CHECK(AS7331_read_registers(dev, OUTCONV_REG_AS7331, outconv_buf, sizeof(outconv_buf)));
-    uint16_t outconv = ((uint16_t)outconv_buf[1] << 8) | outconv_buf[0];
-    float t_int = outconv / 1.024e6f; // clock frequency 1.024 MHz
-    
-    // Get responsivity values for each UV channel
-    float t_ref = 0.064f; // reference conversion time (given on datasheet page 12)
-    float gain_factor = 2.0f; // gain = 2x (datasheet values reflect gain = 1x and integration time = 64ms)
-    float time_factor = t_int / t_ref;
-    float respA = 0.205f * gain_factor * time_factor; // datasheet page 12
-    float respB = 0.157f * gain_factor * time_factor; // datasheet page 12
-    float respC = 0.326f * gain_factor * time_factor; // datasheet page 12
-    
     // Convert to physical values (µW/cm²)
-    light->uva = (float)raw_uva / respA;
-    light->uvb = (float)raw_uvb / respB;
-    light->uvc = (float)raw_uvc / respC;
+    light->uva = raw_uva * dev->scale[0];
+    light->uvb = raw_uvb * dev->scale[1];
+    light->uvc = raw_uvc * dev->scale[2];
+
+    if (dev->auto_range) {
+        auto_range_update(dev, peak);
+    }
 
     // UV Index Calculation
     /*
@@ -159,4 +484,12 @@ esp_err_t AS7331_read_registers(AS7331 *dev, uint8_t reg, uint8_t *data, size_t
     */
 
     return ESP_OK; // successful transaction
-  }
\ No newline at end of file
+  }
+
+esp_err_t as7331_read_light(AS7331 *dev, AS7331_Light *light)
+{
+    if (!dev || !light) return ESP_ERR_INVALID_ARG;
+
+    esp_err_t err = as7331_start_measurement(dev);
+    return err == ESP_OK ? as7331_collect_light(dev, light) : err;
+}
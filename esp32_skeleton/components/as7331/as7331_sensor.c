@@ -0,0 +1,63 @@
+// as7331_sensor.c - AS7331 as a sensor_registry descriptor
+#include "as7331_sensor.h"
+#include "esp_log.h"
+
+static const char *TAG = "AS7331_SENSOR";
+
+static AS7331 s_dev;
+static AS7331_Light s_light;
+
+static int uv_init(void *ctx)
+{
+    const as7331_sensor_cfg_t *cfg = ctx;
+    if (as7331_init(&s_dev) != ESP_OK) return -1;
+    if (cfg->ready_gpio != GPIO_NUM_NC) {
+        esp_err_t err = as7331_enable_ready_interrupt(&s_dev, cfg->ready_gpio);
+        if (err != ESP_OK) {
+            // Still works, on the timed wait and STATUS poll
+            ESP_LOGW(TAG, "READY interrupt on GPIO %d failed (%s), polling instead",
+                     cfg->ready_gpio, esp_err_to_name(err));
+        }
+    }
+    return 0;
+}
+
+static int uv_start(void *ctx)
+{
+    return as7331_start_measurement(&s_dev) == ESP_OK ? 0 : -1;
+}
+
+static int64_t uv_ready(void *ctx)
+{
+    return as7331_conversion_due_us(&s_dev);
+}
+
+static int uv_collect(void *ctx, float *values)
+{
+    if (as7331_collect_light(&s_dev, &s_light) != ESP_OK) return -1;
+    ESP_LOGI(TAG, "conversion ready after %lu us (%s)", (unsigned long)s_dev.last_wait_us,
+             s_dev.ready_gpio != GPIO_NUM_NC ? "READY" : "polled");
+    values[0] = s_light.uva;
+    values[1] = s_light.uvb;
+    values[2] = s_light.uvc;
+    return 0;
+}
+
+static void uv_power_down(void *ctx)
+{
+    as7331_power_down(&s_dev);
+}
+
+static const char *const uv_names[] = { "uva", "uvb", "uvc" };
+
+const sensor_desc_t as7331_sensor = {
+    .name = "as7331",
+    .bus = SENSOR_BUS_I2C,
+    .n_values = 3,
+    .value_names = uv_names,
+    .init = uv_init,
+    .start = uv_start,
+    .ready = uv_ready,
+    .collect = uv_collect,
+    .power_down = uv_power_down,
+};
@@ -2,17 +2,32 @@
 #ifndef AS7331_H
 #define AS7331_H
 
+#include <stdbool.h>
 #include <stdint.h>
 #include "esp_err.h"
-#include "driver/i2c_master.h"
+#include "driver/gpio.h"
+#include "i2c_bus.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 
 // INCLUDE THE REST OF THE FUNCTIONS BELOW
 typedef struct {
 
-    i2c_master_bus_handle_t bus;
-    i2c_master_dev_handle_t dev;
+    i2c_bus_dev_t dev;
     uint16_t light_reading_raw[3]; // UV data raw counts (UVA, UVB, UVC)
 
+    uint8_t gain_code;             // CREG1 GAIN: gain = 2^(11 - gain_code)
+    uint8_t time_code;             // CREG1 TIME: conversion takes 2^time_code ms
+    uint8_t creg1;                 // CREG1 as last written to the sensor
+    bool auto_range;               // pick gain/time from the previous counts (default on)
+    uint8_t status;                // STATUS of the last conversion (overflow flags)
+    float scale[3];                // uW/cm^2 per count (UVA, UVB, UVC) for creg1
+    bool outconv_pending;          // read OUTCONV with the next result (config changed)
+    gpio_num_t ready_gpio;         // READY output, GPIO_NUM_NC = timed wait + STATUS poll
+    SemaphoreHandle_t ready_sem;   // given by the READY interrupt
+    uint32_t last_wait_us;         // trigger to data ready, last collect
+    int64_t trigger_us;            // esp_timer time of the pending trigger, -1 = none
+
 } AS7331;
 
 typedef struct {
@@ -23,12 +38,31 @@ typedef struct {
 
 } AS7331_Light;
 
-// Initializes the sensor
-esp_err_t as7331_init(AS7331 *dev,i2c_master_bus_handle_t main_bus);
+// Initializes the sensor; adds it to the i2c_bus (i2c_bus_init() first)
+esp_err_t as7331_init(AS7331 *dev);
+
+// Wake on the READY output instead of a timed wait. The pin is also armed
+// as a light-sleep wakeup source, so the wait can be spent in light sleep.
+esp_err_t as7331_enable_ready_interrupt(AS7331 *dev, gpio_num_t ready_gpio);
 
-// Read UV data function
+// Gain/time for the next conversions; turns auto-ranging off.
+esp_err_t as7331_set_gain_time(AS7331 *dev, uint8_t gain_code, uint8_t time_code);
+
+// Read UV data function: start + collect
 esp_err_t as7331_read_light(AS7331 *dev, AS7331_Light *light);
 
+// Triggers one conversion and returns at once; collect it later.
+esp_err_t as7331_start_measurement(AS7331 *dev);
+
+// esp_timer time the pending conversion ends, -1 if none.
+int64_t as7331_conversion_due_us(const AS7331 *dev);
+
+// Waits out what is left of the pending conversion and reads it.
+esp_err_t as7331_collect_light(AS7331 *dev, AS7331_Light *light);
+
+// Power-down configuration state until the next as7331_init().
+esp_err_t as7331_power_down(AS7331 *dev);
+
 // Low level function
 esp_err_t AS7331_read_registers(AS7331 *dev, uint8_t reg_addr, uint8_t *data, size_t length);
 
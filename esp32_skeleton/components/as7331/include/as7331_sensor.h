@@ -0,0 +1,16 @@
+// as7331_sensor.h - AS7331 as a sensor_registry descriptor
+#ifndef AS7331_SENSOR_H
+#define AS7331_SENSOR_H
+
+#include "as7331.h"
+#include "sensor_registry.h"
+
+/* Entry ctx. The device is on the i2c_bus. */
+typedef struct {
+    gpio_num_t ready_gpio;      // READY pin, GPIO_NUM_NC = timed wait + status poll
+} as7331_sensor_cfg_t;
+
+/* Values: UVA, UVB, UVC (uW/cm²). Powered down before deep sleep. */
+extern const sensor_desc_t as7331_sensor;
+
+#endif // AS7331_SENSOR_H
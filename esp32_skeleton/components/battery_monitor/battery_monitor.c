@@ -0,0 +1,24 @@
+// battery_monitor.c - LiPo cell voltage through a divider on ADC1
+#include "battery_monitor.h"
+#include <stdio.h>
+#include "adc_service.h"
+#include "probe_power.h"
+
+#define BATTERY_ADC_CHAN    ADC_CHANNEL_7 // ADC1, GPIO35
+#define BATTERY_DIVIDER_NUM 2             // 100k/100k: 4.2 V cell -> 2.1 V at the pin
+#define BATTERY_DIVIDER_DEN 1
+#define BATTERY_POWER_PIN   GPIO_NUM_NC   // divider always connected; set a GPIO to switch it
+#define BATTERY_SETTLE_US   1000
+
+void battery_monitor_init(void) {
+    int probe = probe_power_add("battery", BATTERY_POWER_PIN, BATTERY_SETTLE_US);
+    adc_service_add_channel(BATTERY_ADC_CHAN);
+    if (probe >= 0) adc_service_set_power(BATTERY_ADC_CHAN, probe);
+}
+
+int battery_monitor_read_mv(void) {
+    adc_service_reading_t r;
+    if (adc_service_read(BATTERY_ADC_CHAN, &r) != ESP_OK) return -1;
+    int mv = r.mv * BATTERY_DIVIDER_NUM / BATTERY_DIVIDER_DEN;
+    return mv >= BATTERY_MONITOR_MIN_VALID_MV ? mv : -1;
+}
@@ -0,0 +1,15 @@
+// battery_monitor.h - LiPo cell voltage through a divider on ADC1
+#ifndef BATTERY_MONITOR_H
+#define BATTERY_MONITOR_H
+
+/* Below this the reading is taken as "no battery" (USB power, divider not
+ * fitted) rather than a flat cell. */
+#define BATTERY_MONITOR_MIN_VALID_MV 2500
+
+void battery_monitor_init(void);
+
+/* Cell voltage in mV from the shared ADC burst, -1 if there is no valid
+ * reading. */
+int battery_monitor_read_mv(void);
+
+#endif // BATTERY_MONITOR_H
@@ -1,13 +1,16 @@
 // bme688.c - BME688 sensor driver source (stub)
 #include "bme68x.h"
+#include "bme688.h"
+#include <math.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
-#include "driver/i2c_master.h"
 #include "esp_err.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "i2c_bus.h"
 
 static const char *TAG = "BME688";
 
@@ -27,15 +30,9 @@ static const char *TAG = "BME688";
 //     .flags.enable_internal_pullup = true,
 // };
 
-i2c_master_bus_handle_t bus_handle;
+#define BME688_SCL_HZ 400000 // the BME688 supports fast mode
 
-i2c_device_config_t dev_cfg = {
-    .dev_addr_length = I2C_ADDR_BIT_LEN_7,
-    .device_address = BME688_ADDR,  // Use our defined constant
-    .scl_speed_hz = 400000  // Increased to 400kHz which BME688 supports
-};
-
-i2c_master_dev_handle_t dev_handle;
+static i2c_bus_dev_t dev_handle;
 
 /* --- Adapter functions for BME68x driver --- */
 static void bme68x_delay_us(uint32_t us, void *intf_ptr)
@@ -53,8 +50,8 @@ static int8_t bme68x_i2c_read(uint8_t reg_addr, uint8_t *reg_data, uint32_t len,
         return BME68X_E_NULL_PTR;
     }
 
-    i2c_master_dev_handle_t handle = (i2c_master_dev_handle_t)intf_ptr;
-    esp_err_t err = i2c_master_transmit_receive(handle, &reg_addr, 1, reg_data, len, 1000);
+    i2c_bus_dev_t handle = (i2c_bus_dev_t)intf_ptr;
+    esp_err_t err = i2c_bus_write_read(handle, &reg_addr, 1, reg_data, len);
     
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "I2C read failed: reg=0x%02X, len=%lu, err=%d", reg_addr, (unsigned long)len, err);
@@ -78,7 +75,7 @@ static int8_t bme68x_i2c_write(uint8_t reg_addr, const uint8_t *reg_data, uint32
         return BME68X_E_NULL_PTR;
     }
 
-    i2c_master_dev_handle_t handle = (i2c_master_dev_handle_t)intf_ptr;
+    i2c_bus_dev_t handle = (i2c_bus_dev_t)intf_ptr;
     
     uint8_t tx_buf[64];
     size_t tx_len = len + 1;
@@ -93,7 +90,7 @@ static int8_t bme68x_i2c_write(uint8_t reg_addr, const uint8_t *reg_data, uint32
         memcpy(&tx_buf[1], reg_data, len);
     }
     
-    esp_err_t err = i2c_master_transmit(handle, tx_buf, tx_len, 1000);
+    esp_err_t err = i2c_bus_write(handle, tx_buf, tx_len);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "I2C write failed: reg=0x%02X, len=%lu, err=%d", 
                 reg_addr, (unsigned long)len, err);
@@ -105,7 +102,14 @@ static int8_t bme68x_i2c_write(uint8_t reg_addr, const uint8_t *reg_data, uint32
     return BME68X_OK;
 }
 
-void bme688_init(struct bme68x_data *data, struct bme68x_dev *bme, i2c_master_bus_handle_t bus_handle) {
+// Any failure after the device is added: the next init adds it again
+static esp_err_t init_failed(esp_err_t err)
+{
+    i2c_bus_rm_device(dev_handle);
+    return err;
+}
+
+esp_err_t bme688_init(struct bme68x_data *data, struct bme68x_dev *bme) {
     esp_err_t err;
     int8_t rslt;
 
@@ -122,19 +126,18 @@ void bme688_init(struct bme68x_data *data, struct bme68x_dev *bme, i2c_master_bu
     // }
 
     // Add device with known address 0x77
-    dev_cfg.device_address = BME688_ADDR;  // Using our defined address (0x77)
-    err = i2c_master_bus_add_device(bus_handle, &dev_cfg, &dev_handle);
+    err = i2c_bus_add_device(BME688_ADDR, BME688_SCL_HZ, &dev_handle);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to add I2C device at address 0x%02X: %d", BME688_ADDR, err);
-        return;
+        return err;
     }
     
     // Test communication by trying to read the chip ID
     uint8_t chip_id = 0;
-    err = i2c_master_transmit_receive(dev_handle, (uint8_t[]){0xD0}, 1, &chip_id, 1, 1000);
+    err = i2c_bus_write_read(dev_handle, (uint8_t[]){0xD0}, 1, &chip_id, 1);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to read chip ID: %d", err);
-        return;
+        return init_failed(err);
     }
     
     ESP_LOGI(TAG, "Connected to BME688 at address 0x%02X, Chip ID: 0x%02X", BME688_ADDR, chip_id);
@@ -151,99 +154,172 @@ void bme688_init(struct bme68x_data *data, struct bme68x_dev *bme, i2c_master_bu
     rslt = bme68x_init(bme);
     if (rslt != BME68X_OK) {
         ESP_LOGE(TAG, "Failed to initialize BME688: %d", rslt);
-        return;
+        return init_failed(ESP_FAIL);
     }
 
-    // Configure TPH settings
-    struct bme68x_conf conf;
-    conf.filter = BME68X_FILTER_OFF;
-    conf.odr = BME68X_ODR_NONE;
-    conf.os_hum = BME68X_OS_1X;
-    conf.os_pres = BME68X_OS_16X;
-    conf.os_temp = BME68X_OS_2X;
-    
-    rslt = bme68x_set_conf(&conf, bme);
-    if (rslt != BME68X_OK) {
+    // Oversampling and filter from the default noise profile
+    rslt = bme688_set_profile(BME688_DEFAULT_PROFILE, bme);
+    if (rslt < 0) {
         ESP_LOGE(TAG, "Failed to set TPH configuration: %d", rslt);
-        return;
+        return init_failed(ESP_FAIL);
     }
 
     // Setup heater configuration
     struct bme68x_heatr_conf heatr_conf;
     heatr_conf.enable = BME68X_ENABLE;
-    heatr_conf.heatr_temp = 300;
-    heatr_conf.heatr_dur = 100;
+    heatr_conf.heatr_temp = BME688_FORCED_HEATR_TEMP;
+    heatr_conf.heatr_dur = BME688_FORCED_HEATR_DUR;
     
     rslt = bme68x_set_heatr_conf(BME68X_FORCED_MODE, &heatr_conf, bme);
     if (rslt != BME68X_OK) {
         ESP_LOGE(TAG, "Failed to set heater configuration: %d", rslt);
-        return;
+        return init_failed(ESP_FAIL);
     }
 
     // Set operation mode to forced mode
     rslt = bme68x_set_op_mode(BME68X_FORCED_MODE, bme);
     if (rslt != BME68X_OK) {
         ESP_LOGE(TAG, "Failed to set operation mode: %d", rslt);
-        return;
+        return init_failed(ESP_FAIL);
     }
 
     ESP_LOGI(TAG, "BME688 initialized successfully");
+    return ESP_OK;
 }
 
 
 
-int8_t bme688_read_temperature(float *temp, struct bme68x_data *data, struct bme68x_dev *bme)
+/* --- Oversampling / IIR filter tuning --- */
+
+static const uint8_t os_to_samples[] = { 0, 1, 2, 4, 8, 16 };
+static const uint8_t filter_to_coeff[] = { 0, 1, 3, 7, 15, 31, 63, 127 };
+
+/* Approximate RMS noise of a 1x reading with the filter off (Bosch
+ * BMx280/BME68x datasheet noise tables). Oversampling averages independent
+ * samples, so noise falls with 1/sqrt(n); the IIR filter with coefficient c
+ * scales the variance by 1/(2c+1) and only applies to T and P. */
+static const bme688_noise_t noise_1x = { .temp = 0.005f, .pres = 2.6f, .hum = 0.02f };
+
+static const struct {
+    bme688_noise_t target;
+    uint8_t max_filter;
+} profiles[BME688_PROFILE_COUNT] = {
+    [BME688_PROFILE_LOW_POWER] = { { 0.010f, 3.0f, 0.050f }, BME68X_FILTER_OFF },
+    [BME688_PROFILE_BALANCED]  = { { 0.006f, 1.0f, 0.025f }, BME68X_FILTER_SIZE_1 },
+    [BME688_PROFILE_PRECISION] = { { 0.002f, 0.5f, 0.012f }, BME68X_FILTER_SIZE_3 },
+};
+
+static bme688_tph_setting_t s_setting;
+
+#define NEW_DATA_RETRIES     3
+#define CHARACTERIZE_POLL_US 500
+
+static float expected_noise(float noise, uint8_t os, uint8_t filter)
 {
-    if (!temp || !data || !bme) return BME68X_E_NULL_PTR;
+    return noise / sqrtf((float)os_to_samples[os] * (2 * filter_to_coeff[filter] + 1));
+}
 
-    uint8_t n_data = 0;
-    *temp = 0.0f;
-    memset(data, 0, sizeof(*data));
+// Lowest oversampling meeting `target`, or BME68X_OS_NONE if even 16x does not.
+static uint8_t min_os(float noise, float target, uint8_t filter)
+{
+    for (uint8_t os = BME68X_OS_1X; os <= BME68X_OS_16X; os++) {
+        if (expected_noise(noise, os, filter) <= target) return os;
+    }
+    return BME68X_OS_NONE;
+}
 
-    // Set operation mode to forced mode to trigger a measurement
-    int8_t rslt = bme68x_set_op_mode(BME68X_FORCED_MODE, bme);
-    if (rslt != BME68X_OK) {
-        ESP_LOGE(TAG, "Failed to set forced mode: %d", rslt);
-        return rslt;
+static void fill_setting(bme688_tph_setting_t *s, struct bme68x_dev *bme)
+{
+    s->conf.odr = BME68X_ODR_NONE;
+    s->noise.temp = expected_noise(noise_1x.temp, s->conf.os_temp, s->conf.filter);
+    s->noise.pres = expected_noise(noise_1x.pres, s->conf.os_pres, s->conf.filter);
+    s->noise.hum = expected_noise(noise_1x.hum, s->conf.os_hum, BME68X_FILTER_OFF);
+    s->meas_dur_us = bme68x_get_meas_dur(BME68X_FORCED_MODE, &s->conf, bme);
+}
+
+int8_t bme688_tune_tph(const bme688_noise_t *target, uint8_t max_filter,
+                       bme688_tph_setting_t *setting, struct bme68x_dev *bme)
+{
+    if (!target || !setting || !bme) return BME68X_E_NULL_PTR;
+    if (max_filter > BME68X_FILTER_SIZE_127) max_filter = BME68X_FILTER_SIZE_127;
+
+    // Channel conversion times add up, so for a given filter each channel
+    // simply takes the lowest oversampling that meets its own target.
+    bool found = false;
+    for (uint8_t filter = BME68X_FILTER_OFF; filter <= max_filter; filter++) {
+        bme688_tph_setting_t cand = { 0 };
+        cand.conf.filter = filter;
+        cand.conf.os_temp = min_os(noise_1x.temp, target->temp, filter);
+        cand.conf.os_pres = min_os(noise_1x.pres, target->pres, filter);
+        cand.conf.os_hum = min_os(noise_1x.hum, target->hum, BME68X_FILTER_OFF);
+        if (!cand.conf.os_temp || !cand.conf.os_pres || !cand.conf.os_hum) continue;
+
+        fill_setting(&cand, bme);
+        // Strictly shorter only: on a tie the weaker filter (less lag) wins.
+        if (!found || cand.meas_dur_us < setting->meas_dur_us) {
+            *setting = cand;
+            found = true;
+        }
     }
+    if (found) return BME68X_OK;
+
+    memset(setting, 0, sizeof(*setting));
+    setting->conf.os_temp = BME68X_OS_16X;
+    setting->conf.os_pres = BME68X_OS_16X;
+    setting->conf.os_hum = BME68X_OS_16X;
+    setting->conf.filter = max_filter;
+    fill_setting(setting, bme);
+    return BME688_W_TARGET_NOT_MET;
+}
 
-    // Create a configuration structure for getting measurement duration
-    struct bme68x_conf conf;
-    conf.os_hum = BME68X_OS_16X;
-    conf.os_pres = BME68X_OS_1X;
-    conf.os_temp = BME68X_OS_2X;
-    
-    // Get the delay time for the measurement
-    uint32_t delay_period = bme68x_get_meas_dur(BME68X_FORCED_MODE, &conf, bme);
-    
-    //ESP_LOGI(TAG, "Measurement delay: %lu ms", delay_period / 100);
-    
-    // Wait for the measurement to complete (convert microseconds to milliseconds)
-    vTaskDelay(pdMS_TO_TICKS((delay_period / 100) + 1));
+int8_t bme688_set_profile(bme688_profile_t profile, struct bme68x_dev *bme)
+{
+    if (!bme) return BME68X_E_NULL_PTR;
+    if (profile >= BME688_PROFILE_COUNT) return BME688_E_INVALID_ARG;
 
-    // Get the data
-    rslt = bme68x_get_data(BME68X_FORCED_MODE, data, &n_data, bme);
+    bme688_tph_setting_t setting;
+    int8_t tune = bme688_tune_tph(&profiles[profile].target, profiles[profile].max_filter, &setting, bme);
+    if (tune < 0) return tune;
+
+    int8_t rslt = bme68x_set_conf(&setting.conf, bme);
     if (rslt != BME68X_OK) {
-        ESP_LOGE(TAG, "Failed to get temperature data: %d", rslt);
+        ESP_LOGE(TAG, "Failed to apply profile %d: %d", profile, rslt);
         return rslt;
     }
-    if (n_data == 0) {
-        ESP_LOGW(TAG, "No new temperature data available");
-        return BME68X_W_NO_NEW_DATA;
-    }
+    s_setting = setting;
+
+    ESP_LOGI(TAG, "Profile %d: os T%u P%u H%u, filter %u, %lu us; noise %.4f degC %.2f Pa %.3f %%RH%s",
+             profile, os_to_samples[setting.conf.os_temp], os_to_samples[setting.conf.os_pres],
+             os_to_samples[setting.conf.os_hum], filter_to_coeff[setting.conf.filter],
+             (unsigned long)setting.meas_dur_us, setting.noise.temp, setting.noise.pres,
+             setting.noise.hum, tune == BME688_W_TARGET_NOT_MET ? " (target not met)" : "");
+    return tune;
+}
 
-    *temp = data->temperature;
-    //ESP_LOGI(TAG, "Temperature reading: %.2f°C", *temp);
-    return BME68X_OK;
+const bme688_tph_setting_t *bme688_get_tph_setting(void)
+{
+    return &s_setting;
 }
 
-int8_t bme688_read_pressure(float *pres, struct bme68x_data *data, struct bme68x_dev *bme)
+/* --- Forced-mode reads --- */
+
+// TPH conversion of the current setting plus the forced-mode heater time.
+static uint32_t forced_wait_us(void)
 {
-    if (!pres || !data || !bme) return BME68X_E_NULL_PTR;
+    return s_setting.meas_dur_us + (uint32_t)BME688_FORCED_HEATR_DUR * 1000;
+}
 
-    uint8_t n_data = 0;
-    *pres = 0.0f;
-    memset(data, 0, sizeof(*data));
+static TickType_t us_to_ticks(uint32_t us)
+{
+    const uint32_t tick_us = portTICK_PERIOD_MS * 1000;
+    return (TickType_t)((us + tick_us - 1) / tick_us);
+}
+
+static int64_t s_forced_due_us = -1; // -1: no forced conversion pending
+
+int8_t bme688_start_forced(struct bme68x_dev *bme)
+{
+    if (!bme) return BME68X_E_NULL_PTR;
 
     // Set operation mode to forced mode to trigger a measurement
     int8_t rslt = bme68x_set_op_mode(BME68X_FORCED_MODE, bme);
@@ -251,74 +327,131 @@ int8_t bme688_read_pressure(float *pres, struct bme68x_data *data, struct bme68x
         ESP_LOGE(TAG, "Failed to set forced mode: %d", rslt);
         return rslt;
     }
+    s_forced_due_us = esp_timer_get_time() + forced_wait_us();
+    return BME68X_OK;
+}
 
-    // Create a configuration structure for getting measurement duration
-    struct bme68x_conf conf;
-    conf.os_hum = BME68X_OS_16X;
-    conf.os_pres = BME68X_OS_1X;
-    conf.os_temp = BME68X_OS_2X;
-    
-    // Get the delay time for the measurement
-    uint32_t delay_period = bme68x_get_meas_dur(BME68X_FORCED_MODE, &conf, bme);
-    
-    //ESP_LOGI(TAG, "Pressure measurement delay: %lu ms", delay_period / 100);
-    
-    // Wait for the measurement to complete (convert microseconds to milliseconds)
-    vTaskDelay(pdMS_TO_TICKS((delay_period / 100) + 1));
+int64_t bme688_forced_due_us(void)
+{
+    return s_forced_due_us;
+}
 
-    // Get the data
-    rslt = bme68x_get_data(BME68X_FORCED_MODE, data, &n_data, bme);
-    if (rslt != BME68X_OK) {
-        ESP_LOGE(TAG, "Failed to get pressure data: %d", rslt);
+static int8_t collect_forced(const char *what, struct bme68x_data *data, struct bme68x_dev *bme)
+{
+    uint8_t n_data = 0;
+    memset(data, 0, sizeof(*data));
+    if (s_forced_due_us < 0) return BME68X_W_NO_NEW_DATA;
+
+    // Sleep for what is left of the conversion, then allow a few ticks of clock skew
+    int64_t left_us = s_forced_due_us - esp_timer_get_time();
+    s_forced_due_us = -1;
+    if (left_us > 0) vTaskDelay(us_to_ticks((uint32_t)left_us));
+    int8_t rslt;
+    for (int retry = 0;; retry++) {
+        rslt = bme68x_get_data(BME68X_FORCED_MODE, data, &n_data, bme);
+        if (rslt != BME68X_W_NO_NEW_DATA || retry >= NEW_DATA_RETRIES) break;
+        vTaskDelay(1);
+    }
+
+    if (rslt < 0) {
+        ESP_LOGE(TAG, "Failed to get %s data: %d", what, rslt);
         return rslt;
     }
     if (n_data == 0) {
-        ESP_LOGW(TAG, "No new pressure data available");
+        ESP_LOGW(TAG, "No new %s data available", what);
         return BME68X_W_NO_NEW_DATA;
     }
-
-    *pres = data->pressure;
-    //ESP_LOGI(TAG, "Pressure reading: %.2f hPa", *pres);
     return BME68X_OK;
 }
 
+int8_t bme688_collect_forced(struct bme68x_data *data, struct bme68x_dev *bme)
+{
+    if (!data || !bme) return BME68X_E_NULL_PTR;
+    return collect_forced("TPH", data, bme);
+}
+
+static int8_t forced_measurement(const char *what, struct bme68x_data *data, struct bme68x_dev *bme)
+{
+    int8_t rslt = bme688_start_forced(bme);
+    return rslt == BME68X_OK ? collect_forced(what, data, bme) : rslt;
+}
+
+int8_t bme688_read_temperature(float *temp, struct bme68x_data *data, struct bme68x_dev *bme)
+{
+    if (!temp || !data || !bme) return BME68X_E_NULL_PTR;
+
+    *temp = 0.0f;
+    int8_t rslt = forced_measurement("temperature", data, bme);
+    if (rslt == BME68X_OK) *temp = bme688_data_temperature(data);
+    return rslt;
+}
+
+int8_t bme688_read_pressure(float *pres, struct bme68x_data *data, struct bme68x_dev *bme)
+{
+    if (!pres || !data || !bme) return BME68X_E_NULL_PTR;
+
+    *pres = 0.0f;
+    int8_t rslt = forced_measurement("pressure", data, bme);
+    if (rslt == BME68X_OK) *pres = bme688_data_pressure(data);
+    return rslt;
+}
+
 int8_t bme688_read_humidity(float *hum, struct bme68x_data *data, struct bme68x_dev *bme)
 {
     if (!hum || !data || !bme) return BME68X_E_NULL_PTR;
 
-    uint8_t n_data = 0;
-
-    memset(data, 0, sizeof(*data));
+    *hum = 0.0f;
+    int8_t rslt = forced_measurement("humidity", data, bme);
+    if (rslt == BME68X_OK) *hum = bme688_data_humidity(data);
+    return rslt;
+}
 
-    // Set operation mode to forced mode to trigger a measurement
-    int8_t rslt = bme68x_set_op_mode(BME68X_FORCED_MODE, bme);
-    if (rslt != BME68X_OK) {
-        ESP_LOGE(TAG, "Failed to set forced mode: %d", rslt);
-        return rslt;
+int8_t bme688_characterize(uint8_t samples, bme688_tph_stats_t *stats,
+                           struct bme68x_data *data, struct bme68x_dev *bme)
+{
+    if (!stats || !data || !bme) return BME68X_E_NULL_PTR;
+    if (samples < 2) return BME688_E_INVALID_ARG;
+
+    memset(stats, 0, sizeof(*stats));
+    double mean[3] = { 0 }, m2[3] = { 0 };
+    uint64_t conv_sum = 0;
+    const int64_t timeout_us = 2 * (int64_t)forced_wait_us();
+
+    for (uint8_t i = 0; i < samples; i++) {
+        int8_t rslt = bme68x_set_op_mode(BME68X_FORCED_MODE, bme);
+        if (rslt != BME68X_OK) return rslt;
+
+        // Poll the new-data flag instead of sleeping to time the conversion itself
+        int64_t start = esp_timer_get_time();
+        int64_t elapsed = 0;
+        uint8_t status = 0;
+        do {
+            bme->delay_us(CHARACTERIZE_POLL_US, bme->intf_ptr);
+            rslt = bme68x_get_regs(BME68X_REG_FIELD0, &status, 1, bme);
+            elapsed = esp_timer_get_time() - start;
+        } while (rslt == BME68X_OK && !(status & BME68X_NEW_DATA_MSK) && elapsed < timeout_us);
+        if (rslt != BME68X_OK) return rslt;
+
+        uint8_t n_data = 0;
+        rslt = bme68x_get_data(BME68X_FORCED_MODE, data, &n_data, bme);
+        if (rslt != BME68X_OK) return rslt;
+
+        // Welford's running mean and variance
+        double x[3] = { bme688_data_temperature(data), bme688_data_pressure(data), bme688_data_humidity(data) };
+        for (int c = 0; c < 3; c++) {
+            double d = x[c] - mean[c];
+            mean[c] += d / (i + 1);
+            m2[c] += d * (x[c] - mean[c]);
+        }
+        conv_sum += (uint64_t)elapsed;
+        if ((uint32_t)elapsed > stats->conv_us_max) stats->conv_us_max = (uint32_t)elapsed;
     }
 
-    // Create a configuration structure for getting measurement duration
-    struct bme68x_conf conf;
-    conf.os_hum = BME68X_OS_1X;
-    conf.os_pres = BME68X_OS_16X;
-    conf.os_temp = BME68X_OS_2X;
-    
-    // Get the delay time for the measurement
-    uint32_t delay_period = bme68x_get_meas_dur(BME68X_FORCED_MODE, &conf, bme);
-    
-    //ESP_LOGI(TAG, "Humidity measurement delay: %lu ms", delay_period / 100);
-    
-    // Wait for the measurement to complete (convert microseconds to milliseconds)
-    vTaskDelay(pdMS_TO_TICKS((delay_period / 100) + 1));
-
-    // Get the data
-    rslt = bme68x_get_data(BME68X_FORCED_MODE, data, &n_data, bme);
-   // if (n_data)
-        *hum = data->humidity;
-    if (rslt == BME68X_W_NO_NEW_DATA) {
-        ESP_LOGW(TAG, "No new humidity data available");
-    }
-    //ESP_LOGI(TAG, "Humidity reading: %.2f%%", *hum);
+    stats->samples = samples;
+    stats->conv_us_mean = (uint32_t)(conv_sum / samples);
+    stats->mean = (bme688_noise_t){ (float)mean[0], (float)mean[1], (float)mean[2] };
+    stats->variance = (bme688_noise_t){ (float)(m2[0] / (samples - 1)), (float)(m2[1] / (samples - 1)),
+                                        (float)(m2[2] / (samples - 1)) };
     return BME68X_OK;
 }
 
@@ -336,7 +469,7 @@ int8_t bme688_read_gas_resistance(float *gas_resistance, struct bme68x_data *dat
     
     // Check if gas measurement is valid
     if (data->status & BME68X_GASM_VALID_MSK) {
-        *gas_resistance = data->gas_resistance;
+        *gas_resistance = bme688_data_gas_resistance(data);
         return BME68X_OK;
     }
     
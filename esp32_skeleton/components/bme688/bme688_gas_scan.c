@@ -0,0 +1,200 @@
+// bme688_gas_scan.c - BME688 parallel-mode gas scan with on-device baseline
+#include "bme688_gas_scan.h"
+#include "bme688.h"
+#include <math.h>
+#include <string.h>
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static const char *TAG = "BME688_GAS";
+
+#define IAQ_MAX           500.0f
+#define IAQ_GAS_WEIGHT    0.75f
+#define IAQ_HUM_WEIGHT    0.25f
+#define IAQ_HUM_IDEAL     40.0f // %RH considered "comfortable"
+
+/* Baseline survives deep sleep so the burn-in is only paid once per power-up. */
+typedef struct {
+    float baseline[BME688_GAS_SCAN_MAX_STEPS];
+    uint16_t scans;
+    uint16_t profile_sig;
+} gas_baseline_t;
+
+static RTC_DATA_ATTR gas_baseline_t s_baseline;
+
+void bme688_gas_scan_default_config(bme688_gas_scan_config_t *cfg)
+{
+    if (!cfg) return;
+    memset(cfg, 0, sizeof(*cfg));
+
+    // Short profile: one hot cleaning step followed by three sensing steps.
+    static const uint16_t temps[] = { 320, 100, 200, 300 };
+    static const uint16_t muls[]  = { 5, 2, 5, 5 };
+
+    cfg->profile_len = sizeof(temps) / sizeof(temps[0]);
+    memcpy(cfg->heatr_temp_prof, temps, sizeof(temps));
+    memcpy(cfg->heatr_dur_prof, muls, sizeof(muls));
+    cfg->shared_heatr_dur = 100; // ~140 ms cycle minus the TPH conversion
+    cfg->baseline_alpha = 0.05f;
+    cfg->burn_in_scans = 20;
+}
+
+void bme688_gas_scan_reset_baseline(void)
+{
+    memset(&s_baseline, 0, sizeof(s_baseline));
+}
+
+// Cheap signature of the heater profile; a changed profile invalidates the baseline.
+static uint16_t profile_signature(const bme688_gas_scan_config_t *cfg)
+{
+    uint16_t sig = cfg->profile_len;
+    for (uint8_t i = 0; i < cfg->profile_len; i++) {
+        sig = (uint16_t)((sig * 31u) ^ cfg->heatr_temp_prof[i] ^ (cfg->heatr_dur_prof[i] << 9));
+    }
+    return sig;
+}
+
+static float humidity_score(float hum)
+{
+    float score = (hum < IAQ_HUM_IDEAL) ? (IAQ_HUM_IDEAL - hum) / IAQ_HUM_IDEAL
+                                        : (hum - IAQ_HUM_IDEAL) / (100.0f - IAQ_HUM_IDEAL);
+    if (score < 0.0f) score = 0.0f;
+    if (score > 1.0f) score = 1.0f;
+    return score;
+}
+
+static int8_t restore_forced_mode(struct bme68x_dev *bme)
+{
+    struct bme68x_heatr_conf heatr_conf = { 0 };
+    heatr_conf.enable = BME68X_ENABLE;
+    heatr_conf.heatr_temp = BME688_FORCED_HEATR_TEMP;
+    heatr_conf.heatr_dur = BME688_FORCED_HEATR_DUR;
+
+    int8_t rslt = bme68x_set_op_mode(BME68X_SLEEP_MODE, bme);
+    if (rslt == BME68X_OK) {
+        rslt = bme68x_set_heatr_conf(BME68X_FORCED_MODE, &heatr_conf, bme);
+    }
+    return rslt;
+}
+
+int8_t bme688_gas_scan_run(const bme688_gas_scan_config_t *cfg,
+                           bme688_gas_scan_result_t *result,
+                           struct bme68x_dev *bme)
+{
+    if (!cfg || !result || !bme) return BME68X_E_NULL_PTR;
+    if (cfg->profile_len == 0 || cfg->profile_len > BME688_GAS_SCAN_MAX_STEPS) return BME68X_E_INVALID_LENGTH;
+
+    memset(result, 0, sizeof(*result));
+
+    struct bme68x_conf conf;
+    int8_t rslt = bme68x_get_conf(&conf, bme);
+    if (rslt != BME68X_OK) return rslt;
+
+    // The driver takes non-const profile pointers; work on local copies.
+    uint16_t temps[BME688_GAS_SCAN_MAX_STEPS];
+    uint16_t muls[BME688_GAS_SCAN_MAX_STEPS];
+    memcpy(temps, cfg->heatr_temp_prof, sizeof(temps));
+    memcpy(muls, cfg->heatr_dur_prof, sizeof(muls));
+
+    struct bme68x_heatr_conf heatr_conf = { 0 };
+    heatr_conf.enable = BME68X_ENABLE;
+    heatr_conf.heatr_temp_prof = temps;
+    heatr_conf.heatr_dur_prof = muls;
+    heatr_conf.profile_len = cfg->profile_len;
+    heatr_conf.shared_heatr_dur = cfg->shared_heatr_dur;
+
+    rslt = bme68x_set_heatr_conf(BME68X_PARALLEL_MODE, &heatr_conf, bme);
+    if (rslt == BME68X_OK) {
+        rslt = bme68x_set_op_mode(BME68X_PARALLEL_MODE, bme);
+    }
+    if (rslt != BME68X_OK) {
+        ESP_LOGE(TAG, "Failed to start parallel mode: %d", rslt);
+        (void)restore_forced_mode(bme);
+        return rslt;
+    }
+
+    // One TPH cycle; each profile step lasts heatr_dur_prof[i] of these.
+    uint32_t cycle_us = bme68x_get_meas_dur(BME68X_PARALLEL_MODE, &conf, bme) +
+                        (uint32_t)cfg->shared_heatr_dur * 1000;
+    uint32_t total_cycles = 0;
+    for (uint8_t i = 0; i < cfg->profile_len; i++) {
+        total_cycles += muls[i] ? muls[i] : 1;
+    }
+    // Allow one full extra pass in case the scan started mid-profile.
+    uint32_t max_cycles = total_cycles * 2;
+    uint16_t all_steps = (uint16_t)((1u << cfg->profile_len) - 1);
+    float hum_sum = 0.0f;
+    uint16_t hum_n = 0;
+
+    for (uint32_t cycle = 0; cycle < max_cycles && result->steps_valid != all_steps; cycle++) {
+        vTaskDelay(pdMS_TO_TICKS(cycle_us / 1000) + 1);
+
+        struct bme68x_data fields[3];
+        uint8_t n_fields = 0;
+        rslt = bme68x_get_data(BME68X_PARALLEL_MODE, fields, &n_fields, bme);
+        if (rslt == BME68X_W_NO_NEW_DATA) {
+            rslt = BME68X_OK;
+            continue;
+        }
+        if (rslt != BME68X_OK) {
+            ESP_LOGE(TAG, "Failed to read parallel fields: %d", rslt);
+            break;
+        }
+
+        for (uint8_t f = 0; f < n_fields; f++) {
+            const struct bme68x_data *d = &fields[f];
+            const uint8_t stable = BME68X_NEW_DATA_MSK | BME68X_GASM_VALID_MSK | BME68X_HEAT_STAB_MSK;
+            if ((d->status & stable) != stable || d->gas_index >= cfg->profile_len) continue;
+
+            result->gas_res[d->gas_index] = bme688_data_gas_resistance(d);
+            result->steps_valid |= (uint16_t)(1u << d->gas_index);
+            hum_sum += bme688_data_humidity(d);
+            hum_n++;
+        }
+    }
+
+    int8_t restore = restore_forced_mode(bme);
+    if (rslt != BME68X_OK) return rslt;
+    if (restore != BME68X_OK) return restore;
+    if (result->steps_valid == 0) return BME68X_W_NO_NEW_DATA;
+
+    result->humidity = hum_sum / hum_n;
+
+    uint16_t sig = profile_signature(cfg);
+    if (s_baseline.profile_sig != sig) {
+        bme688_gas_scan_reset_baseline();
+        s_baseline.profile_sig = sig;
+    }
+
+    // Clean air has the highest resistance: follow rises at once, decay slowly.
+    float log_ratio_sum = 0.0f;
+    uint8_t n_steps = 0;
+    for (uint8_t i = 0; i < cfg->profile_len; i++) {
+        if (!(result->steps_valid & (1u << i))) continue;
+
+        float r = result->gas_res[i];
+        float *b = &s_baseline.baseline[i];
+        if (*b <= 0.0f || r > *b) {
+            *b = r;
+        } else {
+            *b += cfg->baseline_alpha * (r - *b);
+        }
+        result->baseline[i] = *b;
+
+        float ratio = r / *b;
+        log_ratio_sum += logf(ratio > 1.0f ? 1.0f : ratio);
+        n_steps++;
+    }
+    if (s_baseline.scans < UINT16_MAX) s_baseline.scans++;
+
+    result->gas_ratio = expf(log_ratio_sum / n_steps);
+    result->baseline_ready = s_baseline.scans >= cfg->burn_in_scans;
+    result->iaq = IAQ_MAX * (IAQ_GAS_WEIGHT * (1.0f - result->gas_ratio) +
+                             IAQ_HUM_WEIGHT * humidity_score(result->humidity));
+
+    ESP_LOGD(TAG, "Gas scan: steps=0x%03X ratio=%.3f iaq=%.0f%s", result->steps_valid,
+             result->gas_ratio, result->iaq, result->baseline_ready ? "" : " (burn-in)");
+    return BME68X_OK;
+}
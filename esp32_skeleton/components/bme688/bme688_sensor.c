@@ -0,0 +1,83 @@
+// bme688_sensor.c - BME688 as sensor_registry descriptors
+#include "bme688_sensor.h"
+#include <math.h>
+#include <stdbool.h>
+#include "bme688.h"
+#include "bme688_gas_scan.h"
+
+// One device behind both descriptors
+static struct bme68x_dev s_bme;
+static struct bme68x_data s_data;
+static bme688_gas_scan_config_t s_gas_cfg;
+static bool s_up;
+
+static int bme_init(void *ctx)
+{
+    if (s_up) return 0;
+    if (bme688_init(&s_data, &s_bme) != ESP_OK) return -1;
+    bme688_gas_scan_default_config(&s_gas_cfg);
+    s_up = true;
+    return 0;
+}
+
+static int air_start(void *ctx)
+{
+    return bme688_start_forced(&s_bme) == BME68X_OK ? 0 : -1;
+}
+
+static int64_t air_ready(void *ctx)
+{
+    return bme688_forced_due_us();
+}
+
+static int air_collect(void *ctx, float *values)
+{
+    if (bme688_collect_forced(&s_data, &s_bme) != BME68X_OK) return -1;
+    values[0] = bme688_data_temperature(&s_data);
+    values[1] = bme688_data_humidity(&s_data);
+    values[2] = bme688_data_pressure(&s_data);
+    return 0;
+}
+
+// Due with the T/H/P conversion, or at once when air is not sampled
+static int64_t gas_ready(void *ctx)
+{
+    return bme688_forced_due_us();
+}
+
+static int gas_collect(void *ctx, float *values)
+{
+    // Only the derived index goes over LoRa, not the per-step resistances.
+    bme688_gas_scan_result_t gas = { 0 };
+    if (bme688_gas_scan_run(&s_gas_cfg, &gas, &s_bme) != BME68X_OK) return -1;
+    // The scan itself worked, so burn-in is no failure: NAN keeps "aqi" out
+    // of the frame without starting the health backoff.
+    values[0] = gas.baseline_ready ? gas.iaq : NAN;
+    values[1] = gas.baseline_ready ? 1.0f : 0.0f;
+    return 0;
+}
+
+static const char *const air_names[] = { "temp", "hum", "pres" };
+static const char *const gas_names[] = { "iaq", "ready" };
+
+// The sensor returns to sleep after every forced conversion and scan.
+const sensor_desc_t bme688_air_sensor = {
+    .name = "bme688",
+    .bus = SENSOR_BUS_I2C,
+    .n_values = 3,
+    .value_names = air_names,
+    .init = bme_init,
+    .start = air_start,
+    .ready = air_ready,
+    .collect = air_collect,
+};
+
+const sensor_desc_t bme688_gas_sensor = {
+    .name = "gas",
+    .bus = SENSOR_BUS_I2C,
+    .n_values = 2,
+    .value_names = gas_names,
+    .init = bme_init,
+    .ready = gas_ready,
+    .collect = gas_collect,
+};
@@ -38,17 +38,13 @@
 
 #include "bme68x.h"
 #include <stdio.h>
-#include "esp_err.h"
-#include "esp_log.h"
-#include "esp_timer.h"
-#include "freertos/FreeRTOS.h"
-#include "freertos/task.h"
-
-static const char *TAG = "BME688";
 
 /* This internal API is used to read the calibration coefficients */
 static int8_t get_calib_data(struct bme68x_dev *dev);
 
+/* This internal API is used to precompute the derived calibration coefficients */
+static void calc_derived_calib(struct bme68x_calib_data *calib);
+
 /* This internal API is used to read variant ID information register status */
 static int8_t read_variant_id(struct bme68x_dev *dev);
 
@@ -847,10 +843,10 @@ static int16_t calc_temperature(uint32_t temp_adc, struct bme68x_dev *dev)
     int16_t calc_temp;
 
     /*lint -save -e701 -e702 -e704 */
-    var1 = ((int32_t)temp_adc >> 3) - ((int32_t)dev->calib.par_t1 << 1);
+    var1 = ((int32_t)temp_adc >> 3) - dev->calib.t1_x2;
     var2 = (var1 * (int32_t)dev->calib.par_t2) >> 11;
     var3 = ((var1 >> 1) * (var1 >> 1)) >> 12;
-    var3 = ((var3) * ((int32_t)dev->calib.par_t3 << 4)) >> 14;
+    var3 = ((var3) * dev->calib.t3_x16) >> 14;
     dev->calib.t_fine = (int32_t)(var2 + var3);
     calc_temp = (int16_t)(((dev->calib.t_fine * 5) + 128) >> 8);
 
@@ -877,8 +873,8 @@ static uint32_t calc_pressure(uint32_t pres_adc, const struct bme68x_dev *dev)
     var1 = (((int32_t)dev->calib.t_fine) >> 1) - 64000;
     var2 = ((((var1 >> 2) * (var1 >> 2)) >> 11) * (int32_t)dev->calib.par_p6) >> 2;
     var2 = var2 + ((var1 * (int32_t)dev->calib.par_p5) << 1);
-    var2 = (var2 >> 2) + ((int32_t)dev->calib.par_p4 << 16);
-    var1 = (((((var1 >> 2) * (var1 >> 2)) >> 13) * ((int32_t)dev->calib.par_p3 << 5)) >> 3) +
+    var2 = (var2 >> 2) + dev->calib.p4_x65536;
+    var1 = (((((var1 >> 2) * (var1 >> 2)) >> 13) * dev->calib.p3_x32) >> 3) +
            (((int32_t)dev->calib.par_p2 * var1) >> 1);
     var1 = var1 >> 18;
     var1 = ((32768 + var1) * (int32_t)dev->calib.par_p1) >> 15;
@@ -898,7 +894,7 @@ static uint32_t calc_pressure(uint32_t pres_adc, const struct bme68x_dev *dev)
     var3 =
         ((int32_t)(pressure_comp >> 8) * (int32_t)(pressure_comp >> 8) * (int32_t)(pressure_comp >> 8) *
          (int32_t)dev->calib.par_p10) >> 17;
-    pressure_comp = (int32_t)(pressure_comp) + ((var1 + var2 + var3 + ((int32_t)dev->calib.par_p7 << 7)) >> 4);
+    pressure_comp = (int32_t)(pressure_comp) + ((var1 + var2 + var3 + dev->calib.p7_x128) >> 4);
 
     /*lint -restore */
     return (uint32_t)pressure_comp;
@@ -918,7 +914,7 @@ static uint32_t calc_humidity(uint16_t hum_adc, const struct bme68x_dev *dev)
 
     /*lint -save -e702 -e704 */
     temp_scaled = (((int32_t)dev->calib.t_fine * 5) + 128) >> 8;
-    var1 = (int32_t)(hum_adc - ((int32_t)((int32_t)dev->calib.par_h1 * 16))) -
+    var1 = (int32_t)(hum_adc - dev->calib.h1_x16) -
            (((temp_scaled * (int32_t)dev->calib.par_h3) / ((int32_t)100)) >> 1);
     var2 =
         ((int32_t)dev->calib.par_h2 *
@@ -926,7 +922,7 @@ static uint32_t calc_humidity(uint16_t hum_adc, const struct bme68x_dev *dev)
           (((temp_scaled * ((temp_scaled * (int32_t)dev->calib.par_h5) / ((int32_t)100))) >> 6) / ((int32_t)100)) +
           (int32_t)(1 << 14))) >> 10;
     var3 = var1 * var2;
-    var4 = (int32_t)dev->calib.par_h6 << 7;
+    var4 = dev->calib.h6_x128;
     var4 = ((var4) + ((temp_scaled * (int32_t)dev->calib.par_h7) / ((int32_t)100))) >> 4;
     var5 = ((var3 >> 14) * (var3 >> 14)) >> 10;
     var6 = (var4 * var5) >> 1;
@@ -964,7 +960,7 @@ static uint32_t calc_gas_resistance_low(uint16_t gas_res_adc, uint8_t gas_range,
     };
 
     /*lint -save -e704 */
-    var1 = (int64_t)((1340 + (5 * (int64_t)dev->calib.range_sw_err)) * ((int64_t)lookup_table1[gas_range])) >> 16;
+    var1 = (int64_t)(dev->calib.gas_range_sw * ((int64_t)lookup_table1[gas_range])) >> 16;
     var2 = (((int64_t)((int64_t)gas_res_adc << 15) - (int64_t)(16777216)) + var1);
     var3 = (((int64_t)lookup_table2[gas_range] * (int64_t)var1) >> 9);
     calc_gas_res = (uint32_t)((var3 + ((int64_t)var2 >> 1)) / (int64_t)var2);
@@ -1027,12 +1023,12 @@ static float calc_temperature(uint32_t temp_adc, struct bme68x_dev *dev)
     float calc_temp;
 
     /* calculate var1 data */
-    var1 = ((((float)temp_adc / 16384.0f) - ((float)dev->calib.par_t1 / 1024.0f)) * ((float)dev->calib.par_t2));
+    var1 = ((((float)temp_adc / 16384.0f) - dev->calib.t1_d1024) * ((float)dev->calib.par_t2));
 
     /* calculate var2 data */
     var2 =
-        (((((float)temp_adc / 131072.0f) - ((float)dev->calib.par_t1 / 8192.0f)) *
-          (((float)temp_adc / 131072.0f) - ((float)dev->calib.par_t1 / 8192.0f))) * ((float)dev->calib.par_t3 * 16.0f));
+        (((((float)temp_adc / 131072.0f) - dev->calib.t1_d8192) *
+          (((float)temp_adc / 131072.0f) - dev->calib.t1_d8192)) * dev->calib.t3_x16);
 
     /* t_fine value*/
     dev->calib.t_fine = (var1 + var2);
@@ -1052,10 +1048,10 @@ static float calc_pressure(uint32_t pres_adc, const struct bme68x_dev *dev)
     float calc_pres;
 
     var1 = (((float)dev->calib.t_fine / 2.0f) - 64000.0f);
-    var2 = var1 * var1 * (((float)dev->calib.par_p6) / (131072.0f));
-    var2 = var2 + (var1 * ((float)dev->calib.par_p5) * 2.0f);
-    var2 = (var2 / 4.0f) + (((float)dev->calib.par_p4) * 65536.0f);
-    var1 = (((((float)dev->calib.par_p3 * var1 * var1) / 16384.0f) + ((float)dev->calib.par_p2 * var1)) / 524288.0f);
+    var2 = var1 * var1 * dev->calib.p6_d131072;
+    var2 = var2 + (var1 * dev->calib.p5_x2);
+    var2 = (var2 / 4.0f) + dev->calib.p4_x65536;
+    var1 = (((dev->calib.p3_d16384 * var1 * var1) + ((float)dev->calib.par_p2 * var1)) / 524288.0f);
     var1 = ((1.0f + (var1 / 32768.0f)) * ((float)dev->calib.par_p1));
     calc_pres = (1048576.0f - ((float)pres_adc));
 
@@ -1063,10 +1059,10 @@ static float calc_pressure(uint32_t pres_adc, const struct bme68x_dev *dev)
     if ((int)var1 != 0)
     {
         calc_pres = (((calc_pres - (var2 / 4096.0f)) * 6250.0f) / var1);
-        var1 = (((float)dev->calib.par_p9) * calc_pres * calc_pres) / 2147483648.0f;
-        var2 = calc_pres * (((float)dev->calib.par_p8) / 32768.0f);
-        var3 = ((calc_pres / 256.0f) * (calc_pres / 256.0f) * (calc_pres / 256.0f) * (dev->calib.par_p10 / 131072.0f));
-        calc_pres = (calc_pres + (var1 + var2 + var3 + ((float)dev->calib.par_p7 * 128.0f)) / 16.0f);
+        var1 = dev->calib.p9_d2147483648 * calc_pres * calc_pres;
+        var2 = calc_pres * dev->calib.p8_d32768;
+        var3 = ((calc_pres / 256.0f) * (calc_pres / 256.0f) * (calc_pres / 256.0f) * dev->calib.p10_d131072);
+        calc_pres = (calc_pres + (var1 + var2 + var3 + dev->calib.p7_x128) / 16.0f);
     }
     else
     {
@@ -1089,13 +1085,13 @@ static float calc_humidity(uint16_t hum_adc, const struct bme68x_dev *dev)
     /* compensated temperature data*/
     temp_comp = ((dev->calib.t_fine) / 5120.0f);
     var1 = (float)((float)hum_adc) -
-           (((float)dev->calib.par_h1 * 16.0f) + (((float)dev->calib.par_h3 / 2.0f) * temp_comp));
+           (dev->calib.h1_x16 + (dev->calib.h3_d2 * temp_comp));
     var2 = var1 *
-           ((float)(((float)dev->calib.par_h2 / 262144.0f) *
-                    (1.0f + (((float)dev->calib.par_h4 / 16384.0f) * temp_comp) +
-                     (((float)dev->calib.par_h5 / 1048576.0f) * temp_comp * temp_comp))));
-    var3 = (float)dev->calib.par_h6 / 16384.0f;
-    var4 = (float)dev->calib.par_h7 / 2097152.0f;
+           ((float)(dev->calib.h2_d262144 *
+                    (1.0f + (dev->calib.h4_d16384 * temp_comp) +
+                     (dev->calib.h5_d1048576 * temp_comp * temp_comp))));
+    var3 = dev->calib.h6_d16384;
+    var4 = dev->calib.h7_d2097152;
     calc_hum = var2 + ((var3 + (var4 * temp_comp)) * var2 * var2);
     if (calc_hum > 100.0f)
     {
@@ -1125,7 +1121,7 @@ static float calc_gas_resistance_low(uint16_t gas_res_adc, uint8_t gas_range, co
         0.0f, 0.0f, 0.0f, 0.0f, 0.1f, 0.7f, 0.0f, -0.8f, -0.1f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f
     };
 
-    var1 = (1340.0f + (5.0f * dev->calib.range_sw_err));
+    var1 = dev->calib.gas_range_sw;
     var2 = (var1) * (1.0f + lookup_k1_range[gas_range] / 100.0f);
     var3 = 1.0f + (lookup_k2_range[gas_range] / 100.0f);
     calc_gas_res = 1.0f / (float)(var3 * (0.000000125f) * gas_range_f * (((gas_res_f - 512.0f) / var2) + 1.0f));
@@ -1841,11 +1837,52 @@ static int8_t get_calib_data(struct bme68x_dev *dev)
         dev->calib.res_heat_range = ((coeff_array[BME68X_IDX_RES_HEAT_RANGE] & BME68X_RHRANGE_MSK) / 16);
         dev->calib.res_heat_val = (int8_t)coeff_array[BME68X_IDX_RES_HEAT_VAL];
         dev->calib.range_sw_err = ((int8_t)(coeff_array[BME68X_IDX_RANGE_SW_ERR] & BME68X_RSERROR_MSK)) / 16;
+
+        calc_derived_calib(&dev->calib);
     }
 
     return rslt;
 }
 
+/* This internal API is used to precompute the derived calibration coefficients */
+static void calc_derived_calib(struct bme68x_calib_data *calib)
+{
+#ifndef BME68X_USE_FPU
+
+    /*lint -save -e701 */
+    calib->t1_x2 = (int32_t)calib->par_t1 << 1;
+    calib->t3_x16 = (int32_t)calib->par_t3 << 4;
+    calib->p3_x32 = (int32_t)calib->par_p3 << 5;
+    calib->p4_x65536 = (int32_t)calib->par_p4 << 16;
+    calib->p7_x128 = (int32_t)calib->par_p7 << 7;
+    calib->h1_x16 = (int32_t)calib->par_h1 * 16;
+    calib->h6_x128 = (int32_t)calib->par_h6 << 7;
+    calib->gas_range_sw = 1340 + (5 * (int64_t)calib->range_sw_err);
+
+    /*lint -restore */
+#else
+    calib->t1_d1024 = (float)calib->par_t1 / 1024.0f;
+    calib->t1_d8192 = (float)calib->par_t1 / 8192.0f;
+    calib->t3_x16 = (float)calib->par_t3 * 16.0f;
+    calib->p3_d16384 = (float)calib->par_p3 / 16384.0f;
+    calib->p4_x65536 = (float)calib->par_p4 * 65536.0f;
+    calib->p5_x2 = (float)calib->par_p5 * 2.0f;
+    calib->p6_d131072 = (float)calib->par_p6 / 131072.0f;
+    calib->p7_x128 = (float)calib->par_p7 * 128.0f;
+    calib->p8_d32768 = (float)calib->par_p8 / 32768.0f;
+    calib->p9_d2147483648 = (float)calib->par_p9 / 2147483648.0f;
+    calib->p10_d131072 = (float)calib->par_p10 / 131072.0f;
+    calib->h1_x16 = (float)calib->par_h1 * 16.0f;
+    calib->h2_d262144 = (float)calib->par_h2 / 262144.0f;
+    calib->h3_d2 = (float)calib->par_h3 / 2.0f;
+    calib->h4_d16384 = (float)calib->par_h4 / 16384.0f;
+    calib->h5_d1048576 = (float)calib->par_h5 / 1048576.0f;
+    calib->h6_d16384 = (float)calib->par_h6 / 16384.0f;
+    calib->h7_d2097152 = (float)calib->par_h7 / 2097152.0f;
+    calib->gas_range_sw = 1340.0f + (5.0f * calib->range_sw_err);
+#endif
+}
+
 /* This internal API is used to read variant ID information from the register */
 static int8_t read_variant_id(struct bme68x_dev *dev)
 {
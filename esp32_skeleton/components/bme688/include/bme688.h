@@ -3,10 +3,68 @@
 
 #include <stdint.h>
 #include "bme68x.h"
-#include "driver/i2c_master.h"
+#include "esp_err.h"
 
-void bme688_init(struct bme68x_data *data,
-                 struct bme68x_dev *bme, i2c_master_bus_handle_t bus_handle);
+/* Forced-mode heater set point applied by bme688_init(). Other modes
+ * (e.g. the gas scan) restore this when they hand the sensor back. */
+#define BME688_FORCED_HEATR_TEMP 300 /* degC */
+#define BME688_FORCED_HEATR_DUR  100 /* ms */
+
+/* bme68x_data units depend on the compensation path bme68x.c was built
+ * with (see readme.md). These helpers always return degC, Pa, %RH, ohm. */
+#ifdef BME68X_USE_FPU
+static inline float bme688_data_temperature(const struct bme68x_data *d) { return d->temperature; }
+static inline float bme688_data_pressure(const struct bme68x_data *d) { return d->pressure; }
+static inline float bme688_data_humidity(const struct bme68x_data *d) { return d->humidity; }
+#else
+static inline float bme688_data_temperature(const struct bme68x_data *d) { return d->temperature / 100.0f; }
+static inline float bme688_data_pressure(const struct bme68x_data *d) { return (float)d->pressure; }
+static inline float bme688_data_humidity(const struct bme68x_data *d) { return d->humidity / 1000.0f; }
+#endif
+static inline float bme688_data_gas_resistance(const struct bme68x_data *d) { return (float)d->gas_resistance; }
+
+/* RMS noise of one reading, in degC / Pa / %RH. */
+typedef struct {
+    float temp;
+    float pres;
+    float hum;
+} bme688_noise_t;
+
+/* Oversampling/IIR presets. Each is a noise target that bme688_tune_tph()
+ * meets at the shortest conversion time. The IIR filter is a running average
+ * across readings, so a profile's filter limit is also a limit on how many
+ * readings a step change takes to show up. */
+typedef enum {
+    BME688_PROFILE_LOW_POWER,   // 1x everywhere, no filter
+    BME688_PROFILE_BALANCED,    // ~1 Pa, filter size 1
+    BME688_PROFILE_PRECISION,   // ~0.5 Pa, filter up to size 3
+    BME688_PROFILE_COUNT
+} bme688_profile_t;
+
+#define BME688_DEFAULT_PROFILE BME688_PROFILE_BALANCED
+
+/* bme688_tune_tph(): no setting meets the target, the quietest one is returned. */
+#define BME688_W_TARGET_NOT_MET INT8_C(4)
+#define BME688_E_INVALID_ARG    INT8_C(-10)
+
+typedef struct {
+    struct bme68x_conf conf;  // os_temp, os_pres, os_hum, filter
+    uint32_t meas_dur_us;     // forced TPH conversion incl. wake-up, no heater
+    bme688_noise_t noise;     // expected, from the datasheet noise model
+} bme688_tph_setting_t;
+
+typedef struct {
+    uint8_t samples;
+    uint32_t conv_us_mean;    // trigger to new data, heater included
+    uint32_t conv_us_max;
+    bme688_noise_t mean;
+    bme688_noise_t variance;  // sample variance, degC^2 / Pa^2 / %RH^2
+} bme688_tph_stats_t;
+
+/* Adds the sensor to the i2c_bus (i2c_bus_init() first) and sets it up for forced mode. Returns ESP_OK,
+ * the I2C error if the sensor does not answer, or ESP_FAIL if it answers
+ * but cannot be configured. */
+esp_err_t bme688_init(struct bme68x_data *data, struct bme68x_dev *bme);
 
 /* Read temperature (°C) in FORCED mode.
  * Returns: BME68X_OK on success,
@@ -32,6 +90,34 @@ int8_t bme688_read_gas_resistance(float *gas_resistance,
                                  struct bme68x_data *data,
                                  struct bme68x_dev *bme);
 
+/* Split forced measurement: start triggers one conversion and returns at
+ * once, collect sleeps for whatever is left of it and reads T, P and H
+ * together (use the bme688_data_* helpers on `data`). Due is the esp_timer
+ * time the pending conversion ends, -1 if none. Returns as the read helpers. */
+int8_t bme688_start_forced(struct bme68x_dev *bme);
+int64_t bme688_forced_due_us(void);
+int8_t bme688_collect_forced(struct bme68x_data *data, struct bme68x_dev *bme);
+
+/* Picks the oversampling and filter (filter <= max_filter) that meet `target`
+ * with the shortest conversion. Does not touch the sensor.
+ * Returns: BME68X_OK, BME688_W_TARGET_NOT_MET, or <0 on error.
+ */
+int8_t bme688_tune_tph(const bme688_noise_t *target, uint8_t max_filter,
+                       bme688_tph_setting_t *setting, struct bme68x_dev *bme);
+
+/* Tunes for `profile` and applies the result. bme688_init() applies
+ * BME688_DEFAULT_PROFILE. Returns as bme688_tune_tph(). */
+int8_t bme688_set_profile(bme688_profile_t profile, struct bme68x_dev *bme);
+
+/* Setting in use; the read helpers wait for exactly its conversion time. */
+const bme688_tph_setting_t *bme688_get_tph_setting(void);
+
+/* Runs `samples` (>= 2) forced conversions back to back with the current
+ * setting, timing each by polling the new-data flag, and reports the
+ * measured conversion time and the mean and variance of the readings. */
+int8_t bme688_characterize(uint8_t samples, bme688_tph_stats_t *stats,
+                           struct bme68x_data *data, struct bme68x_dev *bme);
+
 /* Usage notes:
  * - These helpers assume BME68X_FORCED_MODE.
  * - `data` must point to one struct for forced mode.
@@ -0,0 +1,55 @@
+// bme688_gas_scan.h - BME688 parallel-mode gas scan with on-device baseline
+#ifndef BME688_GAS_SCAN_H
+#define BME688_GAS_SCAN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "bme68x.h"
+
+#define BME688_GAS_SCAN_MAX_STEPS 10
+
+/* Heater profile run in PARALLEL mode.
+ * - heatr_temp_prof: heater set point per step (degC)
+ * - heatr_dur_prof:  duration of each step as a multiple of one TPH cycle
+ * - shared_heatr_dur: heating time shared by every TPH cycle (ms)
+ * - baseline_alpha:  EWMA weight of a new scan in the clean-air baseline
+ * - burn_in_scans:   scans to run before the baseline is trusted
+ */
+typedef struct {
+    uint16_t heatr_temp_prof[BME688_GAS_SCAN_MAX_STEPS];
+    uint16_t heatr_dur_prof[BME688_GAS_SCAN_MAX_STEPS];
+    uint8_t profile_len;
+    uint16_t shared_heatr_dur;
+    float baseline_alpha;
+    uint16_t burn_in_scans;
+} bme688_gas_scan_config_t;
+
+typedef struct {
+    float gas_res[BME688_GAS_SCAN_MAX_STEPS]; // ohm, last value per step
+    float baseline[BME688_GAS_SCAN_MAX_STEPS]; // ohm, EWMA per step
+    uint16_t steps_valid;   // bit n set if step n produced a stable reading
+    float humidity;         // %RH from the same burst
+    float gas_ratio;        // geometric mean of gas_res / baseline, capped at 1
+    float iaq;              // 0 (clean) .. 500 (very polluted)
+    bool baseline_ready;    // false during burn-in; iaq is then only indicative
+} bme688_gas_scan_result_t;
+
+/* Fills `cfg` with a short 4-step profile suitable for one wake cycle. */
+void bme688_gas_scan_default_config(bme688_gas_scan_config_t *cfg);
+
+/* Runs one pass of the heater profile in PARALLEL mode, collecting the
+ * three field registers in a single burst read per TPH cycle, then updates
+ * the baseline and air-quality index. The sensor is returned to its
+ * forced-mode heater configuration before returning.
+ * Returns: BME68X_OK on success,
+ *          BME68X_W_NO_NEW_DATA if no heater step produced a valid reading,
+ *          <0 on error.
+ */
+int8_t bme688_gas_scan_run(const bme688_gas_scan_config_t *cfg,
+                           bme688_gas_scan_result_t *result,
+                           struct bme68x_dev *bme);
+
+/* Forgets the stored baseline (e.g. after the sensor was moved). */
+void bme688_gas_scan_reset_baseline(void);
+
+#endif /* BME688_GAS_SCAN_H */
@@ -0,0 +1,17 @@
+// bme688_sensor.h - BME688 as sensor_registry descriptors
+#ifndef BME688_SENSOR_H
+#define BME688_SENSOR_H
+
+#include "sensor_registry.h"
+
+/* Both descriptors take no ctx; the device is on the i2c_bus. */
+
+/* Values: temperature (°C), humidity (%RH), pressure (Pa). Forced mode. */
+extern const sensor_desc_t bme688_air_sensor;
+
+/* Values: IAQ (0-500), baseline ready (0/1). The heater scan runs on the
+ * same device, so put this entry after bme688_air_sensor: it is collected
+ * after the T/H/P conversion it shares. */
+extern const sensor_desc_t bme688_gas_sensor;
+
+#endif // BME688_SENSOR_H
@@ -856,6 +856,73 @@ struct bme68x_calib_data
 
     /*! Gas resistance range switching error coefficient */
     int8_t range_sw_err;
+
+    /*
+     * Derived coefficients, computed once from the raw ones above by
+     * get_calib_data() so the per-sample compensation skips the rescaling.
+     * Each holds exactly the sub-expression the compensation used to
+     * evaluate, so results are bit-identical.
+     */
+#ifndef BME68X_USE_FPU
+
+    /*! par_t1 << 1 */
+    int32_t t1_x2;
+
+    /*! par_t3 << 4 */
+    int32_t t3_x16;
+
+    /*! par_p3 << 5 */
+    int32_t p3_x32;
+
+    /*! par_p4 << 16 */
+    int32_t p4_x65536;
+
+    /*! par_p7 << 7 */
+    int32_t p7_x128;
+
+    /*! par_h1 * 16 */
+    int32_t h1_x16;
+
+    /*! par_h6 << 7 */
+    int32_t h6_x128;
+
+    /*! 1340 + 5 * range_sw_err */
+    int64_t gas_range_sw;
+#else
+
+    /*! par_t1 / 1024 and par_t1 / 8192 */
+    float t1_d1024;
+    float t1_d8192;
+
+    /*! par_t3 * 16 */
+    float t3_x16;
+
+    /*! par_p3 / 16384, par_p4 * 65536, par_p5 * 2, par_p6 / 131072 */
+    float p3_d16384;
+    float p4_x65536;
+    float p5_x2;
+    float p6_d131072;
+
+    /*! par_p7 * 128, par_p8 / 32768, par_p9 / 2^31, par_p10 / 131072 */
+    float p7_x128;
+    float p8_d32768;
+    float p9_d2147483648;
+    float p10_d131072;
+
+    /*! par_h1 * 16, par_h2 / 262144, par_h3 / 2, par_h4 / 16384 */
+    float h1_x16;
+    float h2_d262144;
+    float h3_d2;
+    float h4_d16384;
+
+    /*! par_h5 / 1048576, par_h6 / 16384, par_h7 / 2097152 */
+    float h5_d1048576;
+    float h6_d16384;
+    float h7_d2097152;
+
+    /*! 1340 + 5 * range_sw_err */
+    float gas_range_sw;
+#endif
 };
 
 /*
@@ -0,0 +1,180 @@
+// energy_model.c - charge per wake cycle and projected battery life
+#include "energy_model.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include "esp_attr.h"
+#include "esp_log.h"
+
+static const char *TAG = "ENERGY";
+
+#define AVG_TAU_US (24ULL * 3600 * 1000000) // averaging window of avg_ua
+
+void energy_model_default_config(energy_model_config_t *cfg)
+{
+    if (!cfg) return;
+    *cfg = (energy_model_config_t){
+        .cpu_active_ma = 40.0f,
+        .light_sleep_ma = 0.8f,
+        .sleep_ua = 150.0f,     // ~10 µA chip + ULP runs + LDO quiescent
+        .sensor_ma = 1.0f,
+        .heater_ma = 12.0f,
+        .radio_tx_ma = 43.0f,
+        .radio_rx_ma = 16.5f,
+        // The module is left in AT+MODE=0 (receive) between wakes; set this
+        // to its sleep current once it is put in AT+MODE=1 before deep sleep.
+        .radio_idle_ma = 16.5f,
+        .boot_us = 250000,
+        // Module defaults (AT+PARAMETER=12,7,1,4); lora_common_setup() keeps them
+        .sf = 12,
+        .bw_hz = 125000,
+        .cr = 1,
+        .preamble = 4,
+        .capacity_mah = 2000.0f,
+        .usable_frac = 0.8f,
+        .harvest_mah_day = 0.0f,
+    };
+}
+
+uint32_t energy_model_airtime_us(const energy_model_config_t *cfg, uint32_t payload_bytes)
+{
+    // Semtech AN1200.13
+    double t_sym = (double)(1u << cfg->sf) * 1e6 / cfg->bw_hz;
+    int de = t_sym > 16000.0;
+    int num = 8 * (int)payload_bytes - 4 * cfg->sf + 28 + 16;
+    int den = 4 * (cfg->sf - 2 * de);
+    int n_payload = 8;
+    if (num > 0) n_payload += (num + den - 1) / den * (cfg->cr + 4);
+    return (uint32_t)((cfg->preamble + 4.25 + n_payload) * t_sym);
+}
+
+// mA for us, in µAh
+static float uah(float ma, double us)
+{
+    return (float)(ma * us / 3.6e6);
+}
+
+void energy_model_cycle(const energy_model_config_t *cfg, const energy_cycle_t *c,
+                        energy_breakdown_t *out)
+{
+    double active_us = (double)c->active_us + cfg->boot_us;
+    double period_us = active_us + (double)c->sleep_us;
+    uint32_t tx_us = 0;
+    if (c->tx_frames) {
+        uint32_t per_frame = (c->tx_bytes + c->tx_frames - 1) / c->tx_frames;
+        tx_us = energy_model_airtime_us(cfg, per_frame) * c->tx_frames;
+    }
+    // AT+SEND returns before the frame is out, so the airtime overlaps the
+    // radio window; the module keeps its idle draw outside that window.
+    double rx_us = c->radio_us > tx_us ? c->radio_us - tx_us : 0;
+    double idle_us = period_us - (c->radio_us > tx_us ? c->radio_us : tx_us);
+
+    memset(out, 0, sizeof(*out));
+    double light_us = c->light_sleep_us < active_us ? c->light_sleep_us : active_us;
+    out->cpu_uah = uah(cfg->cpu_active_ma, active_us - light_us) + uah(cfg->light_sleep_ma, light_us);
+    out->sensor_uah = uah(cfg->sensor_ma, c->sensor_us);
+    out->heater_uah = uah(cfg->heater_ma, c->heater_us);
+    out->tx_uah = uah(cfg->radio_tx_ma, tx_us);
+    out->rx_uah = uah(cfg->radio_rx_ma, rx_us);
+    out->idle_uah = uah(cfg->radio_idle_ma, idle_us > 0 ? idle_us : 0);
+    out->sleep_uah = uah(cfg->sleep_ua / 1000.0f, (double)c->sleep_us);
+    out->total_uah = out->cpu_uah + out->sensor_uah + out->heater_uah + out->tx_uah +
+                     out->rx_uah + out->idle_uah + out->sleep_uah;
+    out->tx_us = tx_us;
+    out->period_us = (uint64_t)period_us;
+}
+
+float energy_model_life_days(const energy_model_config_t *cfg, float avg_ua)
+{
+    float drain_mah_day = avg_ua * 24.0f / 1000.0f - cfg->harvest_mah_day;
+    if (drain_mah_day <= 0.0f) return -1.0f;
+    return cfg->capacity_mah * cfg->usable_frac / drain_mah_day;
+}
+
+/* --- Accounting across deep sleep --- */
+
+typedef struct {
+    bool pending;           // a wake was closed and its sleep is running
+    energy_cycle_t wake;
+    int64_t sleep_start_us; // gettimeofday time of the close
+    uint64_t span_us;       // accounted time, capped at AVG_TAU_US
+} energy_state_t;
+
+static RTC_DATA_ATTR energy_state_t s_state;
+static RTC_DATA_ATTR energy_report_t s_report;
+static const energy_model_config_t *s_cfg;
+
+// gettimeofday() runs off the RTC timer, so it keeps counting in deep sleep.
+static int64_t now_us(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+void energy_model_init(const energy_model_config_t *cfg)
+{
+    s_cfg = cfg;
+    if (!s_state.pending) return;
+    s_state.pending = false;
+
+    int64_t slept = now_us() - s_state.sleep_start_us;
+    if (slept > 0) s_state.wake.sleep_us = (uint64_t)slept; // else keep the planned sleep
+    energy_breakdown_t b;
+    energy_model_cycle(cfg, &s_state.wake, &b);
+    if (b.period_us == 0) return;
+
+    // Time-weighted average: a plain mean until a day is covered, then an
+    // exponential one with a one-day window.
+    float cycle_ua = (float)(b.total_uah * 3.6e9 / (double)b.period_us);
+    s_state.span_us += b.period_us;
+    if (s_state.span_us > AVG_TAU_US) s_state.span_us = AVG_TAU_US;
+    float w = (float)((double)b.period_us / (double)s_state.span_us);
+    if (w > 1.0f) w = 1.0f;
+    s_report.avg_ua = s_report.valid ? s_report.avg_ua + w * (cycle_ua - s_report.avg_ua) : cycle_ua;
+    s_report.cycle = b;
+    s_report.life_days = energy_model_life_days(cfg, s_report.avg_ua);
+    s_report.cycles++;
+    s_report.valid = true;
+    energy_model_log();
+}
+
+void energy_model_close_wake(const energy_cycle_t *wake)
+{
+    s_state.wake = *wake;
+    s_state.sleep_start_us = now_us();
+    s_state.pending = true;
+}
+
+const energy_report_t *energy_model_last(void)
+{
+    return &s_report;
+}
+
+int energy_model_format(char *buf, size_t len)
+{
+    if (len) buf[0] = '\0';
+    if (!s_report.valid) return 0;
+    char tmp[48];
+    int n = snprintf(tmp, sizeof(tmp), "\"em\":[%.0f,%.0f,%.0f]",
+                     s_report.cycle.total_uah, s_report.avg_ua, s_report.life_days);
+    if (n < 0 || (size_t)n >= len) return 0;
+    memcpy(buf, tmp, n + 1);
+    return n;
+}
+
+void energy_model_log(void)
+{
+    if (!s_report.valid) return;
+    const energy_breakdown_t *b = &s_report.cycle;
+    ESP_LOGI(TAG, "cycle %.1f s: %.1f uAh (cpu %.1f, sensors %.1f, heater %.1f, tx %.1f, rx %.1f, "
+             "radio idle %.1f, sleep %.1f), airtime %lu ms",
+             b->period_us / 1e6, b->total_uah, b->cpu_uah, b->sensor_uah, b->heater_uah,
+             b->tx_uah, b->rx_uah, b->idle_uah, b->sleep_uah, (unsigned long)(b->tx_us / 1000));
+    if (s_report.life_days < 0) {
+        ESP_LOGI(TAG, "average %.0f uA, harvest covers it", s_report.avg_ua);
+    } else {
+        ESP_LOGI(TAG, "average %.0f uA, battery life %.0f days", s_report.avg_ua, s_report.life_days);
+    }
+}
@@ -0,0 +1,99 @@
+// energy_model.h - charge per wake cycle and projected battery life
+#ifndef ENERGY_MODEL_H
+#define ENERGY_MODEL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Current figures and battery. Defaults (energy_model_default_config) are
+ * datasheet typicals for this board; measure yours and override them. */
+typedef struct {
+    float cpu_active_ma;    // ESP32 awake at 160 MHz, Wi-Fi/BT off
+    float light_sleep_ma;   // ESP32 in automatic light sleep during a wake
+    float sleep_ua;         // deep sleep: RTC + ULP, regulator, gated probes
+    float sensor_ma;        // sensors converting, during WAKE_PHASE_ACQUIRE
+    float heater_ma;        // BME688 gas heater on
+    float radio_tx_ma;      // LoRa module transmitting
+    float radio_rx_ma;      // LoRa module listening on a send wake
+    float radio_idle_ma;    // LoRa module for the rest of the cycle
+    uint32_t boot_us;       // ROM + bootloader, before esp_timer starts
+    // LoRa modem settings, for the airtime of each frame
+    uint8_t sf;             // spreading factor 7-12
+    uint32_t bw_hz;         // bandwidth
+    uint8_t cr;             // coding rate 4/(4+cr), 1-4
+    uint16_t preamble;      // preamble symbols
+    // Battery
+    float capacity_mah;
+    float usable_frac;      // share of the capacity above the brown-out voltage
+    float harvest_mah_day;  // solar charge per day, 0 = none
+} energy_model_config_t;
+
+/* What one wake did; sleep_us is the deep sleep that followed it. */
+typedef struct {
+    uint32_t active_us;     // CPU awake, app start to deep sleep
+    uint32_t light_sleep_us; // of which in automatic light sleep
+    uint32_t sensor_us;     // sensors converting
+    uint32_t heater_us;     // gas heater on
+    uint32_t radio_us;      // radio up on this wake: UART config to sleep entry
+    uint16_t tx_frames;     // AT+SEND count, resends and handshake included
+    uint32_t tx_bytes;      // their payload bytes
+    uint64_t sleep_us;
+} energy_cycle_t;
+
+/* Charge of one cycle, µAh, by consumer. */
+typedef struct {
+    float cpu_uah;
+    float sensor_uah;
+    float heater_uah;
+    float tx_uah;
+    float rx_uah;
+    float idle_uah;         // radio outside this wake's radio window
+    float sleep_uah;
+    float total_uah;
+    uint32_t tx_us;         // airtime
+    uint64_t period_us;     // wake + sleep
+} energy_breakdown_t;
+
+typedef struct {
+    bool valid;
+    energy_breakdown_t cycle; // the last completed cycle
+    float avg_ua;           // average current, time-weighted over ~a day
+    float life_days;        // projected battery life, < 0 = energy neutral
+    uint32_t cycles;        // accounted since cold boot
+} energy_report_t;
+
+void energy_model_default_config(energy_model_config_t *cfg);
+
+/* Airtime of one LoRa frame with `payload_bytes` of payload (explicit
+ * header, CRC on, low data rate optimisation when a symbol exceeds 16 ms). */
+uint32_t energy_model_airtime_us(const energy_model_config_t *cfg, uint32_t payload_bytes);
+
+/* Charge of one cycle. tx_bytes are spread evenly over tx_frames. */
+void energy_model_cycle(const energy_model_config_t *cfg, const energy_cycle_t *cycle,
+                        energy_breakdown_t *out);
+
+/* Days a full battery lasts at `avg_ua`, net of the solar harvest;
+ * -1 if the harvest covers the drain. */
+float energy_model_life_days(const energy_model_config_t *cfg, float avg_ua);
+
+/* --- Accounting across deep sleep (RTC memory) --- */
+
+/* Sets the figures used for accounting; `cfg` must outlive the wake.
+ * Call at the start of app_main. The sleep that just ended is measured
+ * with gettimeofday() and the previous wake's cycle accounted here. */
+void energy_model_init(const energy_model_config_t *cfg);
+
+/* Records this wake; call right before esp_deep_sleep_start(). */
+void energy_model_close_wake(const energy_cycle_t *wake);
+
+const energy_report_t *energy_model_last(void);
+
+/* Writes "em":[cycle µAh,avg µA,life days] for the last completed cycle,
+ * or nothing if there is none or it does not fit in `len`. Returns the
+ * length written. */
+int energy_model_format(char *buf, size_t len);
+
+void energy_model_log(void);
+
+#endif // ENERGY_MODEL_H
@@ -0,0 +1,176 @@
+// i2c_bus.c - devices, transfer execution and statistics of the shared bus
+#include "i2c_bus.h"
+#include <stdbool.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "i2c_bus_priv.h"
+#include "power_mgmt.h"
+
+static const char *TAG = "i2c_bus";
+
+struct i2c_bus_device {
+    i2c_master_dev_handle_t handle;
+    uint16_t addr;
+    bool used;
+    uint32_t transfers;
+    uint32_t errors;
+};
+
+static i2c_master_bus_handle_t s_bus;
+static struct i2c_bus_device s_devices[I2C_BUS_MAX_DEVICES];
+static i2c_bus_stats_t s_stats;
+static int64_t s_stats_since_us;
+
+esp_err_t i2c_bus_init(const i2c_master_bus_config_t *cfg)
+{
+    if (!cfg) return ESP_ERR_INVALID_ARG;
+    if (s_bus) return ESP_ERR_INVALID_STATE;
+    esp_err_t err = i2c_new_master_bus(cfg, &s_bus);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Bus init failed: %s", esp_err_to_name(err));
+        return err;
+    }
+    err = i2c_bus_task_start();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Bus task start failed: %s", esp_err_to_name(err));
+        return err;
+    }
+    i2c_bus_reset_stats();
+    return ESP_OK;
+}
+
+esp_err_t i2c_bus_add_device(uint16_t addr, uint32_t scl_hz, i2c_bus_dev_t *ret_dev)
+{
+    if (!s_bus) return ESP_ERR_INVALID_STATE;
+    if (!ret_dev) return ESP_ERR_INVALID_ARG;
+    for (int i = 0; i < I2C_BUS_MAX_DEVICES; i++) {
+        struct i2c_bus_device *d = &s_devices[i];
+        if (d->used) continue;
+        i2c_device_config_t dev_cfg = {
+            .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+            .device_address = addr,
+            .scl_speed_hz = scl_hz,
+        };
+        esp_err_t err = i2c_master_bus_add_device(s_bus, &dev_cfg, &d->handle);
+        if (err != ESP_OK) return err;
+        d->addr = addr;
+        d->used = true;
+        d->transfers = d->errors = 0;
+        *ret_dev = d;
+        return ESP_OK;
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t i2c_bus_rm_device(i2c_bus_dev_t dev)
+{
+    if (!dev || !dev->used) return ESP_ERR_INVALID_ARG;
+    esp_err_t err = i2c_master_bus_rm_device(dev->handle);
+    if (err == ESP_OK) dev->used = false;
+    return err;
+}
+
+esp_err_t i2c_bus_execute(i2c_bus_xfer_t *xfer)
+{
+    struct i2c_bus_device *d = xfer->dev;
+    int64_t t0 = esp_timer_get_time();
+    uint32_t waited = (uint32_t)(t0 - xfer->queued_us);
+    if (waited > s_stats.max_wait_us) s_stats.max_wait_us = waited;
+
+    esp_err_t err = ESP_OK;
+    int tries = 0;
+    power_mgmt_acquire(POWER_MGMT_LOCK_I2C);
+    while (tries++ <= I2C_BUS_RETRIES) {
+        if (xfer->rx_len) {
+            err = i2c_master_transmit_receive(d->handle, xfer->tx, xfer->tx_len, xfer->rx, xfer->rx_len,
+                                              I2C_BUS_TIMEOUT_MS);
+        } else {
+            err = i2c_master_transmit(d->handle, xfer->tx, xfer->tx_len, I2C_BUS_TIMEOUT_MS);
+        }
+        if (err == ESP_OK || err == ESP_ERR_INVALID_ARG || tries > I2C_BUS_RETRIES) break;
+        s_stats.retries++;
+        // A slave holding SDA low after a timeout is clocked free before the retry
+        if (err == ESP_ERR_TIMEOUT) i2c_master_bus_reset(s_bus);
+    }
+    power_mgmt_release(POWER_MGMT_LOCK_I2C);
+
+    s_stats.busy_us += (uint64_t)(esp_timer_get_time() - t0);
+    s_stats.transfers++;
+    d->transfers++;
+    if (err == ESP_OK) {
+        s_stats.bytes += xfer->tx_len + xfer->rx_len;
+    } else {
+        s_stats.errors++;
+        d->errors++;
+        ESP_LOGW(TAG, "0x%02X: %s after %d attempt(s)", d->addr, esp_err_to_name(err), tries);
+    }
+    return err;
+}
+
+void i2c_bus_note_queued(unsigned depth)
+{
+    if (depth > s_stats.max_queued) s_stats.max_queued = (uint8_t)depth;
+}
+
+esp_err_t i2c_bus_submit(i2c_bus_xfer_t *xfer)
+{
+    if (!xfer || !xfer->dev || !xfer->dev->used || !xfer->tx_len || (xfer->rx_len && !xfer->rx)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_bus) return ESP_ERR_INVALID_STATE;
+    return i2c_bus_task_post(xfer);
+}
+
+esp_err_t i2c_bus_wait(i2c_bus_xfer_t *xfer, TickType_t timeout)
+{
+    if (!xfer || xfer->done) return ESP_ERR_INVALID_ARG;
+    return i2c_bus_task_wait(xfer, timeout);
+}
+
+esp_err_t i2c_bus_write(i2c_bus_dev_t dev, const uint8_t *tx, size_t tx_len)
+{
+    return i2c_bus_write_read(dev, tx, tx_len, NULL, 0);
+}
+
+esp_err_t i2c_bus_write_read(i2c_bus_dev_t dev, const uint8_t *tx, size_t tx_len,
+                             uint8_t *rx, size_t rx_len)
+{
+    i2c_bus_xfer_t xfer = { .dev = dev, .tx = tx, .tx_len = tx_len, .rx = rx, .rx_len = rx_len };
+    esp_err_t err = i2c_bus_submit(&xfer);
+    if (err != ESP_OK) return err;
+    // Every attempt is bounded by I2C_BUS_TIMEOUT_MS, so this returns
+    return i2c_bus_wait(&xfer, portMAX_DELAY);
+}
+
+void i2c_bus_get_stats(i2c_bus_stats_t *stats)
+{
+    *stats = s_stats;
+    stats->elapsed_us = (uint64_t)(esp_timer_get_time() - s_stats_since_us);
+}
+
+void i2c_bus_reset_stats(void)
+{
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_stats_since_us = esp_timer_get_time();
+    for (int i = 0; i < I2C_BUS_MAX_DEVICES; i++) s_devices[i].transfers = s_devices[i].errors = 0;
+}
+
+void i2c_bus_log_stats(void)
+{
+    i2c_bus_stats_t st;
+    i2c_bus_get_stats(&st);
+    ESP_LOGI(TAG, "%lu transfers, %lu B, busy %lu us of %lu ms (%.2f %%), %lu errors, %lu retries, "
+             "queue max %u, wait max %lu us",
+             (unsigned long)st.transfers, (unsigned long)st.bytes, (unsigned long)st.busy_us,
+             (unsigned long)(st.elapsed_us / 1000), st.elapsed_us ? 100.0 * st.busy_us / st.elapsed_us : 0.0,
+             (unsigned long)st.errors, (unsigned long)st.retries, st.max_queued,
+             (unsigned long)st.max_wait_us);
+    for (int i = 0; i < I2C_BUS_MAX_DEVICES; i++) {
+        const struct i2c_bus_device *d = &s_devices[i];
+        if (d->used) {
+            ESP_LOGI(TAG, "  0x%02X: %lu transfers, %lu errors", d->addr,
+                     (unsigned long)d->transfers, (unsigned long)d->errors);
+        }
+    }
+}
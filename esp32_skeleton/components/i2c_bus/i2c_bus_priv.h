@@ -0,0 +1,17 @@
+// i2c_bus_priv.h - between the bus core and the task in front of it
+#ifndef I2C_BUS_PRIV_H
+#define I2C_BUS_PRIV_H
+
+#include "i2c_bus.h"
+
+/* i2c_bus.c: runs one transfer on the calling task, with retries, the PM
+ * lock and the stats. */
+esp_err_t i2c_bus_execute(i2c_bus_xfer_t *xfer);
+void i2c_bus_note_queued(unsigned depth);
+
+/* i2c_bus_task.c (host: a stand-in that runs each transfer at once) */
+esp_err_t i2c_bus_task_start(void);
+esp_err_t i2c_bus_task_post(i2c_bus_xfer_t *xfer);
+esp_err_t i2c_bus_task_wait(i2c_bus_xfer_t *xfer, TickType_t timeout);
+
+#endif // I2C_BUS_PRIV_H
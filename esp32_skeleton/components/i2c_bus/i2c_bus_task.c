@@ -0,0 +1,75 @@
+// i2c_bus_task.c - the queue and task in front of the bus
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "i2c_bus_priv.h"
+
+#define I2C_BUS_QUEUE_LEN  8
+#define I2C_BUS_TASK_STACK 3072
+#define I2C_BUS_TASK_PRIO  10   // above the sampling tasks: a queued transfer starts at once
+
+static QueueHandle_t s_queue;
+static TaskHandle_t s_task;
+
+static void complete(i2c_bus_xfer_t *xfer, esp_err_t err)
+{
+    // The submitter may reuse the struct as soon as result is set
+    i2c_bus_done_cb_t done = xfer->done;
+    TaskHandle_t owner = xfer->owner;
+    xfer->result = err;
+    if (done) {
+        done(xfer);
+    } else {
+        xTaskNotifyGive(owner);
+    }
+}
+
+static void bus_task(void *arg)
+{
+    i2c_bus_xfer_t *xfer;
+    for (;;) {
+        if (xQueueReceive(s_queue, &xfer, portMAX_DELAY) == pdTRUE) {
+            // Sampled here, not after the send: this task preempts the poster
+            // and would already have emptied the queue. +1 for this transfer.
+            i2c_bus_note_queued(uxQueueMessagesWaiting(s_queue) + 1);
+            complete(xfer, i2c_bus_execute(xfer));
+        }
+    }
+}
+
+esp_err_t i2c_bus_task_start(void)
+{
+    s_queue = xQueueCreate(I2C_BUS_QUEUE_LEN, sizeof(i2c_bus_xfer_t *));
+    if (!s_queue) return ESP_ERR_NO_MEM;
+    if (xTaskCreate(bus_task, "i2c_bus", I2C_BUS_TASK_STACK, NULL, I2C_BUS_TASK_PRIO, &s_task) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t i2c_bus_task_post(i2c_bus_xfer_t *xfer)
+{
+    xfer->result = ESP_ERR_NOT_FINISHED;
+    xfer->owner = xTaskGetCurrentTaskHandle();
+    xfer->queued_us = esp_timer_get_time();
+    // From a done callback: the bus is free, and queuing would deadlock a wait
+    if (xfer->owner == s_task) {
+        complete(xfer, i2c_bus_execute(xfer));
+        return ESP_OK;
+    }
+    if (xQueueSend(s_queue, &xfer, portMAX_DELAY) != pdTRUE) return ESP_FAIL;
+    return ESP_OK;
+}
+
+esp_err_t i2c_bus_task_wait(i2c_bus_xfer_t *xfer, TickType_t timeout)
+{
+    // Notifications left over from earlier transfers only cause a re-check
+    TickType_t start = xTaskGetTickCount();
+    while (xfer->result == ESP_ERR_NOT_FINISHED) {
+        TickType_t spent = xTaskGetTickCount() - start;
+        if (timeout != portMAX_DELAY && spent >= timeout) return ESP_ERR_TIMEOUT;
+        ulTaskNotifyTake(pdFALSE, timeout == portMAX_DELAY ? portMAX_DELAY : timeout - spent);
+    }
+    return xfer->result;
+}
@@ -0,0 +1,81 @@
+// i2c_bus.h - shared I2C bus: one task owns it and runs queued transfers
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "driver/i2c_master.h"
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#define I2C_BUS_MAX_DEVICES 4
+#define I2C_BUS_RETRIES     2       // extra attempts after a failed transfer
+#define I2C_BUS_TIMEOUT_MS  100     // per attempt
+
+typedef struct i2c_bus_device *i2c_bus_dev_t;
+
+typedef struct i2c_bus_xfer i2c_bus_xfer_t;
+
+/* Runs in the bus task when the transfer is done; xfer->result holds the
+ * outcome. It may submit more transfers but must not block. */
+typedef void (*i2c_bus_done_cb_t)(i2c_bus_xfer_t *xfer);
+
+/* One transaction: write tx, then, if rx_len > 0, a repeated start and
+ * read rx. The caller owns the struct and the buffers until it completes. */
+struct i2c_bus_xfer {
+    i2c_bus_dev_t dev;
+    const uint8_t *tx;
+    size_t tx_len;
+    uint8_t *rx;
+    size_t rx_len;
+    i2c_bus_done_cb_t done;     // NULL: complete through i2c_bus_wait()
+    void *arg;                  // for the callback
+    // Set by the bus
+    volatile esp_err_t result;  // ESP_ERR_NOT_FINISHED until done
+    void *owner;                // submitting task, woken on completion
+    int64_t queued_us;
+};
+
+/* Counters since i2c_bus_init() or the last reset. */
+typedef struct {
+    uint32_t transfers;         // completed, with or without error
+    uint32_t errors;            // failed after all retries
+    uint32_t retries;           // extra attempts made
+    uint32_t bytes;             // moved by successful transfers
+    uint64_t busy_us;           // time spent in transfers, retries included
+    uint64_t elapsed_us;        // wall time the counters cover
+    uint32_t max_wait_us;       // longest a transfer waited in the queue
+    uint8_t max_queued;         // deepest the queue got
+} i2c_bus_stats_t;
+
+/* Creates the bus and the task that owns it. */
+esp_err_t i2c_bus_init(const i2c_master_bus_config_t *cfg);
+
+/* Adds a 7-bit device at its own SCL clock. A device must have no
+ * transfer in flight when it is removed. */
+esp_err_t i2c_bus_add_device(uint16_t addr, uint32_t scl_hz, i2c_bus_dev_t *ret_dev);
+esp_err_t i2c_bus_rm_device(i2c_bus_dev_t dev);
+
+/* Queues a transfer and returns at once. Transfers from all tasks run one
+ * at a time in submission order, each retried up to I2C_BUS_RETRIES times;
+ * the I2C PM lock is held while one runs. */
+esp_err_t i2c_bus_submit(i2c_bus_xfer_t *xfer);
+
+/* Waits, on the submitting task, for a transfer without a callback.
+ * Returns its result, or ESP_ERR_TIMEOUT if it is still queued: the struct
+ * must then stay valid until it is done. */
+esp_err_t i2c_bus_wait(i2c_bus_xfer_t *xfer, TickType_t timeout);
+
+/* Submit and wait. */
+esp_err_t i2c_bus_write(i2c_bus_dev_t dev, const uint8_t *tx, size_t tx_len);
+esp_err_t i2c_bus_write_read(i2c_bus_dev_t dev, const uint8_t *tx, size_t tx_len,
+                             uint8_t *rx, size_t rx_len);
+
+void i2c_bus_get_stats(i2c_bus_stats_t *stats);
+void i2c_bus_reset_stats(void);
+
+/* Logs utilization (busy / elapsed), errors, retries and queueing, and the
+ * per-device counts. */
+void i2c_bus_log_stats(void);
+
+#endif // I2C_BUS_H
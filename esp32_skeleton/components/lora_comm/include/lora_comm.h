@@ -14,11 +14,25 @@
 #define LORA_RXD_PIN        GPIO_NUM_16
 #define LORA_NRST_PIN       GPIO_NUM_4
 #define LORA_UART_BUF_SIZE  2048
+#define LORA_MAX_PAYLOAD    240     // RYLR AT+SEND data limit, bytes
+// A received frame: "+RCV=<addr>,<len>," + payload + ",<rssi>,<snr>\r\n"
+#define LORA_RCV_LINE_MAX   (LORA_MAX_PAYLOAD + 48)
+
+// Frames handed to the module this wake (for the energy model's airtime)
+typedef struct {
+    uint32_t frames;
+    uint32_t bytes;     // payload bytes
+} lora_tx_stats_t;
 
 // --- Function Prototypes ---
 
 /**
  * @brief Configures the ESP32's UART peripheral to talk to the LoRa module.
+ *
+ * Reads and writes hold the power_mgmt UART lock, so the bus stays clocked
+ * while it is in use. RX is not a light-sleep wakeup source (GPIO16 is not
+ * the UART1 IO_MUX pin), so a caller expecting unsolicited traffic holds the
+ * lock for as long as the radio is up.
  */
 void lora_uart_config(void);
 
@@ -46,6 +60,11 @@ void lora_common_setup(int addr);
  */
 void lora_send_message(uint8_t address, const char* message);
 
+/**
+ * @brief Frames and payload bytes sent with lora_send_message() since boot.
+ */
+const lora_tx_stats_t *lora_tx_stats(void);
+
 bool lora_boot_handshake(bool is_middleman, uint8_t peer_addr);
 bool lora_wait_for_message(char *buf, size_t len, uint32_t timeout_ms);
 
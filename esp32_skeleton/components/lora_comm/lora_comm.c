@@ -1,14 +1,19 @@
 #include "lora_comm.h"
 #include <string.h>
 #include <stdio.h>
+#include "power_mgmt.h"
 
 static const char *TAG = "lora_comm";
+static lora_tx_stats_t s_tx_stats;
+
 void lora_send_cmd_and_print(const char *s) {
+    power_mgmt_acquire(POWER_MGMT_LOCK_UART); // the reply follows at once
     uart_write_bytes(LORA_UART_PORT, s, strlen(s));
     printf("Sent: %s", s);
 
     uint8_t rx[LORA_UART_BUF_SIZE];
     int len = uart_read_bytes(LORA_UART_PORT, rx, LORA_UART_BUF_SIZE - 1, pdMS_TO_TICKS(1000));
+    power_mgmt_release(POWER_MGMT_LOCK_UART);
     if (len > 0) { 
         rx[len] = '\0'; 
         printf("Received: %s\n", rx); 
@@ -23,7 +28,9 @@ void lora_send_cmd_and_print(const char *s) {
  */
 bool lora_wait_for_message(char *buf, size_t len, uint32_t timeout_ms)
 {
+    power_mgmt_acquire(POWER_MGMT_LOCK_UART);
     int n = uart_read_bytes(LORA_UART_PORT, (uint8_t*)buf, len - 1, pdMS_TO_TICKS(timeout_ms));
+    power_mgmt_release(POWER_MGMT_LOCK_UART);
     // vTaskDelay(pdMS_TO_TICKS(6000));
     if (n > 0) {
         buf[n] = '\0';
@@ -139,17 +146,26 @@ void lora_reset(void)
 }
 
 void lora_send_message(uint8_t address, const char* message) {
-    char at_command[256];
+    char at_command[32 + LORA_MAX_PAYLOAD];
     int message_length = strlen(message);
+    s_tx_stats.frames++;
+    s_tx_stats.bytes += message_length;
     
     // Format: AT+SEND=address,length,message
     snprintf(at_command, sizeof(at_command), "AT+SEND=%d,%d,%s\r\n", 
             address, message_length, message);
     
     // Send the AT command (don't need to read response here, but you could)
+    power_mgmt_acquire(POWER_MGMT_LOCK_UART); // until the FIFO has drained
     uart_write_bytes(LORA_UART_PORT, at_command, strlen(at_command));
+    uart_wait_tx_done(LORA_UART_PORT, pdMS_TO_TICKS(100));
+    power_mgmt_release(POWER_MGMT_LOCK_UART);
     printf("Sent: %s", at_command);
     
     // Note: This is a "fire-and-forget" send. 
     // For critical data, you'd wait for the "+OK" or "+ERR" response.
+}
+
+const lora_tx_stats_t *lora_tx_stats(void) {
+    return &s_tx_stats;
 }
\ No newline at end of file
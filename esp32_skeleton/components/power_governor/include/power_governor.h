@@ -0,0 +1,51 @@
+// power_governor.h - battery-aware reporting policy
+#ifndef POWER_GOVERNOR_H
+#define POWER_GOVERNOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Charge levels, fullest first. Each one further down stretches the
+ * sampling and send periods, turns more sensors off and resends less. */
+typedef enum {
+    POWER_LEVEL_NORMAL,
+    POWER_LEVEL_SAVE,
+    POWER_LEVEL_LOW,
+    POWER_LEVEL_CRITICAL,
+    POWER_LEVEL_COUNT
+} power_level_t;
+
+typedef struct {
+    uint16_t enter_mv;      // drop to this level at or below (unused for NORMAL)
+    uint16_t leave_mv;      // back up to the level above at or above; > enter_mv
+    uint16_t stretch;       // period multiplier, >= 1
+    uint32_t disabled;      // sensors not sampled at this level (caller's bit mask)
+    uint8_t attempts;       // data frame sends before giving up on the ACK
+} power_level_policy_t;
+
+typedef struct {
+    power_level_policy_t level[POWER_LEVEL_COUNT];
+    uint64_t base_send_us;  // send period at NORMAL
+    uint64_t min_send_us;   // bounds on the stretched send period
+    uint64_t max_send_us;
+} power_governor_config_t;
+
+typedef struct {
+    power_level_t level;
+    int battery_mv;         // filtered, -1 = no valid reading yet
+    uint16_t stretch;       // level stretch within the send period bounds
+    uint32_t disabled;
+    uint8_t attempts;
+    bool changed;           // level changed this wake
+} power_governor_state_t;
+
+/* Feeds this wake's battery reading (-1 = none, the level is kept) and
+ * returns the policy to apply. Level and filter live in RTC memory; a cold
+ * boot starts at NORMAL. */
+const power_governor_state_t *power_governor_update(const power_governor_config_t *cfg, int battery_mv);
+
+const power_governor_state_t *power_governor_state(void);
+
+const char *power_governor_level_name(power_level_t level);
+
+#endif // POWER_GOVERNOR_H
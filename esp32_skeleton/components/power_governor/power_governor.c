@@ -0,0 +1,77 @@
+// power_governor.c - battery-aware reporting policy
+#include "power_governor.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+
+static const char *TAG = "POWER_GOV";
+
+static const char *const level_names[POWER_LEVEL_COUNT] = { "normal", "save", "low", "critical" };
+
+/* Level and filtered voltage survive deep sleep; zero (a cold RTC) is
+ * NORMAL with no reading. */
+typedef struct {
+    uint8_t level;
+    int32_t filtered_mv;    // 0 = none yet
+} governor_rtc_t;
+
+static RTC_DATA_ATTR governor_rtc_t s_rtc;
+static power_governor_state_t s_state = { .battery_mv = -1, .stretch = 1 };
+
+// One level step per wake at most, so a single bad reading cannot jump
+// from NORMAL to CRITICAL; the hysteresis band keeps it from toggling.
+static power_level_t next_level(const power_governor_config_t *cfg, power_level_t level, int mv) {
+    if (level + 1 < POWER_LEVEL_COUNT && mv <= cfg->level[level + 1].enter_mv) return level + 1;
+    if (level > POWER_LEVEL_NORMAL && mv >= cfg->level[level].leave_mv) return level - 1;
+    return level;
+}
+
+static uint16_t bounded_stretch(const power_governor_config_t *cfg, uint16_t stretch) {
+    uint64_t base = cfg->base_send_us ? cfg->base_send_us : 1;
+    uint64_t lo = (cfg->min_send_us + base - 1) / base;
+    uint64_t hi = cfg->max_send_us / base;
+    uint64_t s = stretch ? stretch : 1;
+    if (hi && s > hi) s = hi;
+    if (s < lo) s = lo;
+    return (uint16_t)(s > UINT16_MAX ? UINT16_MAX : (s ? s : 1));
+}
+
+const power_governor_state_t *power_governor_update(const power_governor_config_t *cfg, int battery_mv) {
+    power_level_t level = s_rtc.level < POWER_LEVEL_COUNT ? (power_level_t)s_rtc.level : POWER_LEVEL_NORMAL;
+    if (battery_mv > 0) {
+        bool first = s_rtc.filtered_mv == 0;
+        // Light smoothing: the cell reads lower right after a TX burst
+        s_rtc.filtered_mv = first ? battery_mv : (3 * s_rtc.filtered_mv + battery_mv + 2) / 4;
+        // The first reading after a cold boot goes straight to its level
+        power_level_t prev;
+        do {
+            prev = level;
+            level = next_level(cfg, level, s_rtc.filtered_mv);
+        } while (first && level != prev);
+    }
+    s_state.changed = level != s_rtc.level;
+    s_rtc.level = level;
+
+    const power_level_policy_t *p = &cfg->level[level];
+    s_state.level = level;
+    s_state.battery_mv = s_rtc.filtered_mv ? s_rtc.filtered_mv : -1;
+    s_state.stretch = bounded_stretch(cfg, p->stretch);
+    s_state.disabled = p->disabled;
+    s_state.attempts = p->attempts ? p->attempts : 1;
+
+    if (s_state.changed) {
+        ESP_LOGW(TAG, "battery %d mV: level %s (periods x%u, sensors off 0x%02lx, %u attempts)",
+                 s_state.battery_mv, level_names[level], s_state.stretch,
+                 (unsigned long)s_state.disabled, s_state.attempts);
+    } else {
+        ESP_LOGI(TAG, "battery %d mV (read %d): level %s", s_state.battery_mv, battery_mv, level_names[level]);
+    }
+    return &s_state;
+}
+
+const power_governor_state_t *power_governor_state(void) {
+    return &s_state;
+}
+
+const char *power_governor_level_name(power_level_t level) {
+    return level < POWER_LEVEL_COUNT ? level_names[level] : "?";
+}
@@ -0,0 +1,40 @@
+// power_mgmt.h - frequency scaling, automatic light sleep and bus PM locks
+#ifndef POWER_MGMT_H
+#define POWER_MGMT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+/* A lock is held only while its bus moves data. Both keep APB at 80 MHz,
+ * which the UART baud and I2C SCL are derived from, and keep the chip out
+ * of light sleep, which stops both peripherals' clocks. */
+typedef enum {
+    POWER_MGMT_LOCK_UART,   // LoRa UART: TX until drained, RX while a reply is expected
+    POWER_MGMT_LOCK_I2C,    // I2C transfers
+    POWER_MGMT_LOCK_COUNT
+} power_mgmt_lock_t;
+
+typedef struct {
+    int max_mhz;            // CPU while any lock is held or a task runs
+    int min_mhz;            // CPU when idle; 40 (XTAL) also drops APB to 40 MHz
+    bool light_sleep;       // light-sleep in idle waits (tickless idle)
+} power_mgmt_config_t;
+
+/* Applies the configuration and creates the locks. Without CONFIG_PM_ENABLE
+ * it logs and returns ESP_ERR_NOT_SUPPORTED; the locks are then no-ops. */
+esp_err_t power_mgmt_init(const power_mgmt_config_t *cfg);
+
+/* Counted, so nested holds are fine. No-ops before power_mgmt_init(). */
+void power_mgmt_acquire(power_mgmt_lock_t lock);
+void power_mgmt_release(power_mgmt_lock_t lock);
+
+/* Time spent in automatic light sleep since power_mgmt_init() (needs
+ * CONFIG_PM_LIGHT_SLEEP_CALLBACKS, else 0). */
+uint32_t power_mgmt_light_sleep_us(void);
+
+/* Logs the light-sleep time and, with CONFIG_PM_PROFILING, the time spent
+ * in each PM mode and the lock statistics. */
+void power_mgmt_log(void);
+
+#endif // POWER_MGMT_H
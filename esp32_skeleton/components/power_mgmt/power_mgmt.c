@@ -0,0 +1,90 @@
+// power_mgmt.c - frequency scaling, automatic light sleep and bus PM locks
+#include "power_mgmt.h"
+#include <stdio.h>
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_pm.h"
+#include "sdkconfig.h"
+
+static const char *TAG = "POWER_MGMT";
+
+#if CONFIG_PM_ENABLE
+static const char *const s_lock_names[POWER_MGMT_LOCK_COUNT] = { "uart", "i2c" };
+static esp_pm_lock_handle_t s_locks[POWER_MGMT_LOCK_COUNT];
+#endif
+static volatile uint64_t s_light_sleep_us;
+
+#if CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+// Called by the idle task on the way out of each automatic light sleep
+static esp_err_t IRAM_ATTR light_sleep_exit(int64_t sleep_time_us, void *arg)
+{
+    if (sleep_time_us > 0) s_light_sleep_us += (uint64_t)sleep_time_us;
+    return ESP_OK;
+}
+#endif
+
+esp_err_t power_mgmt_init(const power_mgmt_config_t *cfg)
+{
+#if CONFIG_PM_ENABLE
+    esp_pm_config_t pm = {
+        .max_freq_mhz = cfg->max_mhz,
+        .min_freq_mhz = cfg->min_mhz,
+        .light_sleep_enable = cfg->light_sleep,
+    };
+    esp_err_t err = esp_pm_configure(&pm);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "esp_pm_configure: %s", esp_err_to_name(err));
+        return err;
+    }
+    for (int i = 0; i < POWER_MGMT_LOCK_COUNT; i++) {
+        if (s_locks[i]) continue;
+        err = esp_pm_lock_create(ESP_PM_APB_FREQ_MAX, 0, s_lock_names[i], &s_locks[i]);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "%s lock: %s", s_lock_names[i], esp_err_to_name(err));
+            return err;
+        }
+    }
+#if CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+    if (cfg->light_sleep) {
+        esp_pm_sleep_cbs_register_config_t cbs = { .exit_cb = light_sleep_exit };
+        err = esp_pm_light_sleep_register_cbs(&cbs);
+        if (err != ESP_OK) ESP_LOGW(TAG, "light sleep callback: %s", esp_err_to_name(err));
+    }
+#endif
+    ESP_LOGI(TAG, "CPU %d-%d MHz, light sleep %s", cfg->min_mhz, cfg->max_mhz,
+             cfg->light_sleep ? "on" : "off");
+    return ESP_OK;
+#else
+    ESP_LOGW(TAG, "CONFIG_PM_ENABLE is off, running at a fixed frequency");
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+void power_mgmt_acquire(power_mgmt_lock_t lock)
+{
+#if CONFIG_PM_ENABLE
+    if (lock < POWER_MGMT_LOCK_COUNT && s_locks[lock]) esp_pm_lock_acquire(s_locks[lock]);
+#endif
+}
+
+void power_mgmt_release(power_mgmt_lock_t lock)
+{
+#if CONFIG_PM_ENABLE
+    if (lock < POWER_MGMT_LOCK_COUNT && s_locks[lock]) esp_pm_lock_release(s_locks[lock]);
+#endif
+}
+
+uint32_t power_mgmt_light_sleep_us(void)
+{
+    return (uint32_t)s_light_sleep_us;
+}
+
+void power_mgmt_log(void)
+{
+#if CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+    ESP_LOGI(TAG, "light sleep %lu ms this wake", (unsigned long)(s_light_sleep_us / 1000));
+#endif
+#if CONFIG_PM_PROFILING
+    esp_pm_dump_locks(stdout);
+#endif
+}
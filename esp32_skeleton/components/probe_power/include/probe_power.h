@@ -0,0 +1,37 @@
+// probe_power.h - switched supply for the resistive/analog probes
+#ifndef PROBE_POWER_H
+#define PROBE_POWER_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "driver/gpio.h"
+
+#define PROBE_POWER_MAX 4
+
+typedef uint8_t probe_power_mask_t;   // bit i = probe id i
+
+typedef struct {
+    uint32_t on_count;     // times switched on
+    uint64_t on_us;        // total powered time since boot
+    uint32_t settle_us;    // settle time waited on the last switch-on
+} probe_power_stats_t;
+
+/* Registers a probe supply pin (active high) and the time its output needs
+ * to settle after power-up. The pin is driven low at once. A pin of
+ * GPIO_NUM_NC registers an always-powered probe (no gating, no settle).
+ * Returns the probe id (>= 0) or -1. */
+int probe_power_add(const char *name, gpio_num_t pin, uint32_t settle_us);
+
+/* Powers the probes in `mask` and blocks for the longest settle time among
+ * those that were off. Probes already on are not waited for again. */
+esp_err_t probe_power_on(probe_power_mask_t mask);
+
+void probe_power_off(probe_power_mask_t mask);
+
+/* Drives every supply low and latches it for deep sleep. Call right before
+ * esp_deep_sleep_start(); the latch is released by the next probe_power_add(). */
+void probe_power_prepare_sleep(void);
+
+const probe_power_stats_t *probe_power_get_stats(int id);
+
+#endif // PROBE_POWER_H
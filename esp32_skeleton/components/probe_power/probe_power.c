@@ -0,0 +1,97 @@
+// probe_power.c - switched supply for the resistive/analog probes
+#include "probe_power.h"
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+
+static const char *TAG = "PROBE_POWER";
+
+typedef struct {
+    const char *name;
+    gpio_num_t pin;
+    uint32_t settle_us;
+    bool on;
+    int64_t on_since_us;
+    probe_power_stats_t stats;
+} probe_t;
+
+static probe_t s_probes[PROBE_POWER_MAX];
+static int s_count;
+
+int probe_power_add(const char *name, gpio_num_t pin, uint32_t settle_us) {
+    if (s_count == PROBE_POWER_MAX) return -1;
+    if (pin != GPIO_NUM_NC) {
+        // Still latched low from the last deep sleep.
+        gpio_hold_dis(pin);
+        gpio_config_t io_conf = {
+            .pin_bit_mask = (1ULL << pin),
+            .mode = GPIO_MODE_OUTPUT,
+            .pull_up_en = GPIO_PULLUP_DISABLE,
+            .pull_down_en = GPIO_PULLDOWN_DISABLE,
+            .intr_type = GPIO_INTR_DISABLE
+        };
+        if (gpio_config(&io_conf) != ESP_OK) return -1;
+        gpio_set_level(pin, 0);
+    }
+    s_probes[s_count] = (probe_t){
+        .name = name,
+        .pin = pin,
+        .settle_us = pin == GPIO_NUM_NC ? 0 : settle_us,
+    };
+    ESP_LOGI(TAG, "%s: pin %d, settle %lu us", name, pin, (unsigned long)settle_us);
+    return s_count++;
+}
+
+// Sub-tick settle times busy-wait; longer ones give the CPU away.
+static void settle_wait(uint32_t us) {
+    if (us == 0) return;
+    uint32_t tick_us = portTICK_PERIOD_MS * 1000;
+    if (us < tick_us) {
+        esp_rom_delay_us(us);
+    } else {
+        vTaskDelay((us + tick_us - 1) / tick_us);
+    }
+}
+
+esp_err_t probe_power_on(probe_power_mask_t mask) {
+    uint32_t settle = 0;
+    int64_t now = esp_timer_get_time();
+    for (int i = 0; i < s_count; i++) {
+        probe_t *p = &s_probes[i];
+        if (!(mask & (1u << i)) || p->on) continue;
+        if (p->pin != GPIO_NUM_NC) gpio_set_level(p->pin, 1);
+        p->on = true;
+        p->on_since_us = now;
+        p->stats.on_count++;
+        p->stats.settle_us = p->settle_us;
+        if (p->settle_us > settle) settle = p->settle_us;
+    }
+    settle_wait(settle);
+    return ESP_OK;
+}
+
+void probe_power_off(probe_power_mask_t mask) {
+    int64_t now = esp_timer_get_time();
+    for (int i = 0; i < s_count; i++) {
+        probe_t *p = &s_probes[i];
+        if (!(mask & (1u << i)) || !p->on) continue;
+        if (p->pin != GPIO_NUM_NC) gpio_set_level(p->pin, 0);
+        p->on = false;
+        p->stats.on_us += now - p->on_since_us;
+    }
+}
+
+void probe_power_prepare_sleep(void) {
+    probe_power_off((probe_power_mask_t)~0);
+    for (int i = 0; i < s_count; i++) {
+        if (s_probes[i].pin != GPIO_NUM_NC) gpio_hold_en(s_probes[i].pin);
+    }
+    gpio_deep_sleep_hold_en();
+}
+
+const probe_power_stats_t *probe_power_get_stats(int id) {
+    return (id >= 0 && id < s_count) ? &s_probes[id].stats : NULL;
+}
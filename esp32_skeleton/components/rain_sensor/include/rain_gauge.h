@@ -0,0 +1,31 @@
+// rain_gauge.h - tipping-bucket rainfall, counted by the ULP during deep sleep
+#ifndef RAIN_GAUGE_H
+#define RAIN_GAUGE_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "driver/gpio.h"
+
+#define RAIN_GAUGE_GPIO       GPIO_NUM_27 // reed switch to GND, must be an RTC GPIO
+#define RAIN_GAUGE_MM_PER_TIP 0.2794f     // 0.011 in bucket
+
+typedef struct {
+    float interval_mm;     // since the last rain_gauge_commit()
+    float rate_mm_h;       // interval_mm over the interval length
+    float total_mm;        // since cold boot
+    uint32_t interval_s;
+} rain_gauge_report_t;
+
+/* Starts the ULP pulse counter on a cold boot; later wakes pick up the
+ * running counter. */
+esp_err_t rain_gauge_init(void);
+
+/* Folds the tips counted since the last call into the totals (RTC memory)
+ * and reports the current interval. */
+void rain_gauge_read(rain_gauge_report_t *report);
+
+/* Starts a new interval. Call once the frame carrying the report was
+ * acknowledged, so rain is not lost when a send fails. */
+void rain_gauge_commit(void);
+
+#endif // RAIN_GAUGE_H
@@ -0,0 +1,11 @@
+// rain_plate_sensor.h - rain plate as a sensor_registry descriptor
+#ifndef RAIN_PLATE_SENSOR_H
+#define RAIN_PLATE_SENSOR_H
+
+#include "sensor_registry.h"
+
+/* Values: rain level (0 dry .. 1 wet). Read from the shared ADC burst, so
+ * call rain_sensor_init() first; the entry ctx is unused. */
+extern const sensor_desc_t rain_plate_sensor;
+
+#endif // RAIN_PLATE_SENSOR_H
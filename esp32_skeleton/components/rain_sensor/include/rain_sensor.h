@@ -11,6 +11,7 @@ typedef enum {
 void rain_sensor_init(void);
 int rain_sensor_read(float *level);
 int rain_sensor_get_raw(void);
-float rain_sensor_get_normalized(void);
+int rain_sensor_get_mv(void);   // calibrated, -1 on error
+float rain_sensor_get_normalized(void); // 0-1, NAN on error
 
 #endif // RAIN_SENSOR_H
@@ -0,0 +1,61 @@
+// rain_gauge.c - tipping-bucket rainfall, counted by the ULP during deep sleep
+#include "rain_gauge.h"
+#include <stdbool.h>
+#include <sys/time.h>
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "ulp_monitor.h"
+
+static const char *TAG = "RAIN_GAUGE";
+
+// Each tip closes and reopens the reed switch: two edges.
+typedef struct {
+    bool valid;
+    uint16_t ulp_edges;       // ULP counter when last folded in
+    uint32_t edges;           // since cold boot
+    uint32_t edges_at_commit;
+    int64_t commit_us;        // wall clock (RTC timer) at last commit
+} rain_gauge_state_t;
+
+static RTC_DATA_ATTR rain_gauge_state_t s_gauge;
+
+// gettimeofday() runs off the RTC timer, so it keeps counting in deep sleep.
+static int64_t now_us(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+esp_err_t rain_gauge_init(void) {
+    esp_err_t err = ulp_monitor_start(RAIN_GAUGE_GPIO);
+    if (err != ESP_OK) return err;
+    if (!s_gauge.valid) {
+        s_gauge = (rain_gauge_state_t){
+            .valid = true,
+            .ulp_edges = ulp_monitor_edge_count(),
+            .commit_us = now_us(),
+        };
+    }
+    ESP_LOGI(TAG, "Rain gauge on GPIO %d, %.1f mm since boot", RAIN_GAUGE_GPIO,
+             (s_gauge.edges / 2) * RAIN_GAUGE_MM_PER_TIP);
+    return ESP_OK;
+}
+
+void rain_gauge_read(rain_gauge_report_t *report) {
+    uint16_t count = ulp_monitor_edge_count();
+    s_gauge.edges += (uint16_t)(count - s_gauge.ulp_edges);
+    s_gauge.ulp_edges = count;
+
+    // Whole tips only; a half-finished tip lands in the next interval.
+    uint32_t tips = s_gauge.edges / 2 - s_gauge.edges_at_commit / 2;
+    int64_t elapsed_us = now_us() - s_gauge.commit_us;
+    report->interval_mm = tips * RAIN_GAUGE_MM_PER_TIP;
+    report->interval_s = elapsed_us > 0 ? (uint32_t)(elapsed_us / 1000000) : 0;
+    report->rate_mm_h = elapsed_us > 0 ? report->interval_mm * 3600e6f / elapsed_us : 0.0f;
+    report->total_mm = (s_gauge.edges / 2) * RAIN_GAUGE_MM_PER_TIP;
+}
+
+void rain_gauge_commit(void) {
+    s_gauge.edges_at_commit = s_gauge.edges & ~1u;
+    s_gauge.commit_us = now_us();
+}
@@ -0,0 +1,21 @@
+// rain_plate_sensor.c - rain plate as a sensor_registry descriptor
+#include "rain_plate_sensor.h"
+#include <math.h>
+#include "rain_sensor.h"
+
+static int rain_collect(void *ctx, float *values)
+{
+    values[0] = rain_sensor_get_normalized();
+    return isnan(values[0]) ? -1 : 0;
+}
+
+static const char *const rain_names[] = { "level" };
+
+// No trigger: the ADC burst's settle time is the only wait
+const sensor_desc_t rain_plate_sensor = {
+    .name = "rain",
+    .bus = SENSOR_BUS_ADC,
+    .n_values = 1,
+    .value_names = rain_names,
+    .collect = rain_collect,
+};
@@ -1,56 +1,47 @@
 // rain_sensor.c - Rain Water Level sensor driver source (stub)
 #include "rain_sensor.h"
+#include <math.h>
 #include <stdio.h>
-#include "driver/adc.h" 
+#include "adc_service.h"
+#include "probe_power.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
 
 
 
-#define RAIN_SENSOR_ADC_CHAN ADC1_CHANNEL_0 
-// #define RAIN_SENSOR_POWER_PIN GPIO_NUM_13 
+#define RAIN_SENSOR_ADC_CHAN ADC_CHANNEL_0 // ADC1
+#define RAIN_SENSOR_POWER_PIN GPIO_NUM_13
+#define RAIN_SENSOR_SETTLE_US 10000       // output stable ~10 ms after power-up
 
 void rain_sensor_init(void) {
+    // Powered only for the ADC burst; off (and held off in deep sleep)
+    // otherwise so the traces do not corrode.
+    int probe = probe_power_add("rain", RAIN_SENSOR_POWER_PIN, RAIN_SENSOR_SETTLE_US);
 
-    // gpio_config_t io_conf = {
-    //     .pin_bit_mask = (1ULL << RAIN_SENSOR_POWER_PIN),
-    //     .mode = GPIO_MODE_OUTPUT,
-    //     .pull_up_en = GPIO_PULLUP_DISABLE,
-    //     .pull_down_en = GPIO_PULLDOWN_DISABLE,
-    //     .intr_type = GPIO_INTR_DISABLE
-    // };
-    // gpio_config(&io_conf);
-
-    // Start with sensor powered OFF
-    // gpio_set_level(RAIN_SENSOR_POWER_PIN, 0);
-
-    adc1_config_width(ADC_WIDTH_BIT_12);
-    adc1_config_channel_atten(RAIN_SENSOR_ADC_CHAN, ADC_ATTEN_DB_12);
+    adc_service_add_channel(RAIN_SENSOR_ADC_CHAN);
+    if (probe >= 0) adc_service_set_power(RAIN_SENSOR_ADC_CHAN, probe);
 
     printf("Rain Water Level sensor initialized (real hardware)!\n");
 }
 
 int rain_sensor_get_raw(void) {
-    // Turn sensor ON
-    // gpio_set_level(RAIN_SENSOR_POWER_PIN, 1);
-    
-    // Wait for voltage to stabilize (10ns)
-    // vTaskDelay(pdMS_TO_TICKS(10));
-    
-    // Read the sensor
-    int raw = adc1_get_raw(RAIN_SENSOR_ADC_CHAN);
-    
-    // Turn sensor OFF to prevent corrosion
-    // gpio_set_level(RAIN_SENSOR_POWER_PIN, 0);
-    return raw;
+    // Read the sensor (filtered burst shared with the other ADC probes;
+    // the burst switches the probe on, waits the settle time, and off again)
+    adc_service_reading_t r;
+    return adc_service_read(RAIN_SENSOR_ADC_CHAN, &r) == ESP_OK ? r.raw : 0;
+}
+
+int rain_sensor_get_mv(void) {
+    adc_service_reading_t r;
+    return adc_service_read(RAIN_SENSOR_ADC_CHAN, &r) == ESP_OK ? r.mv : -1;
 }
 
 float rain_sensor_get_normalized(void) {
-    int raw_value = rain_sensor_get_raw();
-    // Convert raw ADC value to normalized 0-1 scale
+    int mv = rain_sensor_get_mv();
+    // Convert millivolts to normalized 0-1 scale
     // 0V -> 0.0, 3.3V -> 1.0
-    float normalized = raw_value / 4095.0;
+    float normalized = mv < 0 ? NAN : mv / 3300.0f; // a failed burst is not a dry plate
 
     // if (normalized < 0.02f) {
     //     return RAIN_NONE;
@@ -0,0 +1,102 @@
+// sensor_registry.h - uniform sensor descriptors driven by the wake scheduler
+#ifndef SENSOR_REGISTRY_H
+#define SENSOR_REGISTRY_H
+
+#include <stdint.h>
+
+#define SENSOR_REGISTRY_MAX_ENTRIES 8   // = ACQ_MAX_JOBS
+#define SENSOR_MAX_VALUES           4
+
+/* Health backoff: after this many failed attempts in a row a sensor is
+ * skipped, first for BACKOFF_MIN_S, doubling per further failure up to
+ * BACKOFF_MAX_S, where it counts as failed. */
+#define SENSOR_HEALTH_FAILS_TO_BACKOFF 2
+#define SENSOR_HEALTH_BACKOFF_MIN_S    (15 * 60)
+#define SENSOR_HEALTH_BACKOFF_MAX_S    (24 * 3600)
+
+/* What a sensor's transfers go over. Jobs on the same bus are started back
+ * to back, so the bus is busy in one stretch per wake. */
+typedef enum {
+    SENSOR_BUS_NONE,
+    SENSOR_BUS_I2C,
+    SENSOR_BUS_ONEWIRE,
+    SENSOR_BUS_ADC,
+} sensor_bus_t;
+
+/* Per entry, kept in RTC memory across deep sleep. */
+typedef enum {
+    SENSOR_HEALTH_OK,           // last attempt succeeded
+    SENSOR_HEALTH_DEGRADED,     // failing, still tried on every due wake
+    SENSOR_HEALTH_RETRY_AFTER,  // skipped until its backoff runs out
+    SENSOR_HEALTH_FAILED,       // backoff at its maximum: tried once per BACKOFF_MAX_S
+} sensor_health_t;
+
+/* A driver's hooks, in the same shape for every sensor. Each hook gets the
+ * entry's ctx. init brings the sensor up on a wake that samples it; start
+ * triggers a conversion and returns at once; ready says when it ends
+ * (esp_timer time); collect reads it into values[0..n_values-1], NAN for a
+ * value it could not get; power_down runs before deep sleep. Any hook may
+ * be NULL: nothing to do / ready at once. init, start and collect return 0,
+ * or -1 if the sensor is absent or failed. With ready_poll_ms, ready is
+ * asked again that often during the wait, for a sensor that can tell when
+ * it finished early. */
+typedef struct {
+    const char *name;
+    sensor_bus_t bus;
+    uint8_t n_values;
+    const char *const *value_names;    // for the log
+    int (*init)(void *ctx);
+    int (*start)(void *ctx);
+    int64_t (*ready)(void *ctx);
+    int (*collect)(void *ctx, float *values);
+    void (*power_down)(void *ctx);
+    uint16_t ready_poll_ms;
+} sensor_desc_t;
+
+/* One descriptor value into one sensor_sched channel, as value * scale +
+ * offset (scale 0 means 1). A value may feed several channels. */
+typedef struct {
+    uint8_t value;
+    uint8_t channel;
+    float scale, offset;
+} sensor_channel_t;
+
+/* A sensor fitted to this board. `sensor` is its sensor_sched sensor: the
+ * entry is sampled when that sensor is due. Several entries may share one
+ * (e.g. two ADC probes in one burst). */
+typedef struct {
+    const sensor_desc_t *desc;
+    void *ctx;
+    uint8_t sensor;
+    const sensor_channel_t *channels;
+    uint8_t n_channels;
+} sensor_entry_t;
+
+/* Takes the table (kept by pointer) and brings up the entries whose sensor
+ * is in `due`, in table order. Entries still backing off are skipped. An
+ * entry whose init fails is absent for the rest of the wake; that counts as
+ * a failed attempt. */
+void sensor_registry_init(const sensor_entry_t *table, int count, uint32_t due);
+
+/* Samples the entries whose sensor is in `due` through acq_run(), grouped
+ * by bus, and adds their values to sensor_sched. Absent entries are
+ * skipped; one whose start or collect fails adds nothing and is marked
+ * failed. Updates the health of every entry tried this wake. Returns the number of entries run; with 0, acq_run() was not
+ * called and acq_last_timings() still holds an earlier wake. */
+int sensor_registry_sample(uint32_t due);
+
+/* Runs the power_down hooks of the entries brought up this wake. */
+void sensor_registry_power_down(void);
+
+/* Entries brought up this wake / that failed to init or sample, bit i =
+ * table entry i. */
+uint32_t sensor_registry_present(void);
+uint32_t sensor_registry_failed(void);
+
+sensor_health_t sensor_registry_health(int entry);
+
+/* Entries not OK (degraded, backing off or failed), bit i = table entry i.
+ * Sent in the frame as "ss". */
+uint32_t sensor_registry_status(void);
+
+#endif // SENSOR_REGISTRY_H
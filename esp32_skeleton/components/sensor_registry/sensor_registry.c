@@ -0,0 +1,244 @@
+// sensor_registry.c - uniform sensor descriptors driven by the wake scheduler
+#include "sensor_registry.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include "acq_scheduler.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "sensor_sched.h"
+
+static const char *TAG = "SENSORS";
+
+static const sensor_entry_t *s_table;
+static int s_count;
+static uint32_t s_present, s_failed;
+
+typedef struct {
+    uint8_t state;          // sensor_health_t
+    uint8_t fails;          // failed attempts in a row
+    uint32_t backoff_s;     // 0 = none
+    int64_t retry_us;       // skipped before this time
+} health_t;
+
+static RTC_DATA_ATTR struct {
+    uint32_t signature;     // table the health below was tracked for
+    health_t entry[SENSOR_REGISTRY_MAX_ENTRIES];
+} s_health;
+
+static const char *const health_names[] = { "ok", "degraded", "retry-after", "failed" };
+
+// One entry in this wake's acq_run(); the job ctx
+typedef struct {
+    const sensor_entry_t *entry;
+    float values[SENSOR_MAX_VALUES];
+} sensor_slot_t;
+
+static int job_start(void *ctx)
+{
+    const sensor_slot_t *s = ctx;
+    return s->entry->desc->start(s->entry->ctx);
+}
+
+static int64_t job_ready(void *ctx)
+{
+    const sensor_slot_t *s = ctx;
+    return s->entry->desc->ready(s->entry->ctx);
+}
+
+static int job_collect(void *ctx)
+{
+    sensor_slot_t *s = ctx;
+    const sensor_desc_t *d = s->entry->desc;
+    return d->collect ? d->collect(s->entry->ctx, s->values) : 0;
+}
+
+static bool is_due(int i, uint32_t due)
+{
+    return (due & (1u << s_table[i].sensor)) != 0;
+}
+
+// gettimeofday() runs off the RTC timer, so it keeps counting in deep sleep.
+static int64_t now_us(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+// Changes when entries are added, removed or reordered.
+static uint32_t table_signature(void)
+{
+    uint32_t h = 2166136261u; // FNV-1a
+    for (int i = 0; i < s_count; i++) {
+        for (const char *c = s_table[i].desc->name; *c; c++) h = (h ^ (uint8_t)*c) * 16777619u;
+        h = (h ^ 0xff) * 16777619u;
+    }
+    return h | 1; // never 0, the value of a cold RTC
+}
+
+// Still backing off: leave it alone this wake.
+static bool health_skip(int i, int64_t now)
+{
+    health_t *h = &s_health.entry[i];
+    if (h->state != SENSOR_HEALTH_RETRY_AFTER && h->state != SENSOR_HEALTH_FAILED) return false;
+    if (h->retry_us - now > (int64_t)h->backoff_s * 1000000) h->retry_us = now; // clock went back
+    if (now >= h->retry_us) return false;
+    ESP_LOGI(TAG, "%s: %s, next try in %lld s", s_table[i].desc->name, health_names[h->state],
+             (long long)((h->retry_us - now) / 1000000));
+    return true;
+}
+
+static void health_ok(int i)
+{
+    health_t *h = &s_health.entry[i];
+    if (h->state != SENSOR_HEALTH_OK) ESP_LOGI(TAG, "%s: recovered", s_table[i].desc->name);
+    *h = (health_t){ .state = SENSOR_HEALTH_OK };
+}
+
+// Degraded at first; after FAILS_TO_BACKOFF in a row, skipped for a
+// backoff that doubles with each further failure.
+static void health_fail(int i)
+{
+    health_t *h = &s_health.entry[i];
+    if (h->fails < UINT8_MAX) h->fails++;
+    if (h->fails < SENSOR_HEALTH_FAILS_TO_BACKOFF) {
+        h->state = SENSOR_HEALTH_DEGRADED;
+    } else {
+        h->backoff_s = h->backoff_s ? h->backoff_s * 2 : SENSOR_HEALTH_BACKOFF_MIN_S;
+        if (h->backoff_s >= SENSOR_HEALTH_BACKOFF_MAX_S) {
+            h->backoff_s = SENSOR_HEALTH_BACKOFF_MAX_S;
+            h->state = SENSOR_HEALTH_FAILED;
+        } else {
+            h->state = SENSOR_HEALTH_RETRY_AFTER;
+        }
+        h->retry_us = now_us() + (int64_t)h->backoff_s * 1000000;
+    }
+    ESP_LOGW(TAG, "%s: %s after %u failure(s)%s", s_table[i].desc->name, health_names[h->state],
+             h->fails, h->backoff_s ? ", backing off" : "");
+}
+
+void sensor_registry_init(const sensor_entry_t *table, int count, uint32_t due)
+{
+    if (count > SENSOR_REGISTRY_MAX_ENTRIES) count = SENSOR_REGISTRY_MAX_ENTRIES;
+    s_table = table;
+    s_count = count;
+    s_present = s_failed = 0;
+    uint32_t sig = table_signature();
+    if (s_health.signature != sig) {
+        memset(&s_health, 0, sizeof(s_health));
+        s_health.signature = sig;
+    }
+    int64_t now = now_us();
+    for (int i = 0; i < count; i++) {
+        if (!is_due(i, due) || health_skip(i, now)) continue;
+        const sensor_desc_t *d = table[i].desc;
+        if (d->init && d->init(table[i].ctx) != 0) {
+            ESP_LOGW(TAG, "%s: absent, skipped this wake", d->name);
+            s_failed |= 1u << i;
+            health_fail(i);
+            continue;
+        }
+        s_present |= 1u << i;
+    }
+}
+
+static void log_values(const sensor_slot_t *s)
+{
+    const sensor_desc_t *d = s->entry->desc;
+    char line[96];
+    int len = snprintf(line, sizeof(line), "%s ->", d->name);
+    for (int v = 0; v < d->n_values && len < (int)sizeof(line); v++) {
+        len += snprintf(line + len, sizeof(line) - len, " %s %.2f",
+                        d->value_names ? d->value_names[v] : "?", s->values[v]);
+    }
+    ESP_LOGI(TAG, "%s", line);
+}
+
+int sensor_registry_sample(uint32_t due)
+{
+    sensor_slot_t slots[SENSOR_REGISTRY_MAX_ENTRIES];
+    acq_job_t jobs[SENSOR_REGISTRY_MAX_ENTRIES];
+    int index[SENSOR_REGISTRY_MAX_ENTRIES];
+    bool taken[SENSOR_REGISTRY_MAX_ENTRIES] = { false };
+    int n = 0;
+
+    // Table order, except that each bus's entries follow its first one
+    for (int i = 0; i < s_count; i++) {
+        if (taken[i]) continue;
+        for (int j = i; j < s_count; j++) {
+            if (taken[j] || s_table[j].desc->bus != s_table[i].desc->bus) continue;
+            if (!is_due(j, due) || !(s_present & (1u << j))) continue;
+            taken[j] = true;
+            const sensor_desc_t *d = s_table[j].desc;
+            slots[n].entry = &s_table[j];
+            for (int v = 0; v < SENSOR_MAX_VALUES; v++) slots[n].values[v] = NAN;
+            jobs[n] = (acq_job_t){
+                .name = d->name,
+                .start = d->start ? job_start : NULL,
+                .due = d->ready ? job_ready : NULL,
+                .collect = job_collect,
+                .ctx = &slots[n],
+                .poll_ms = d->ready ? d->ready_poll_ms : 0,
+            };
+            index[n++] = j;
+        }
+    }
+    if (n == 0) return 0;
+    acq_run(jobs, n);
+    acq_log_timings();
+
+    const acq_timings_t *t = acq_last_timings();
+    for (int k = 0; k < n; k++) {
+        if (t->phase[k].result < 0) {
+            s_failed |= 1u << index[k];
+            health_fail(index[k]);
+            continue;
+        }
+        health_ok(index[k]);
+        log_values(&slots[k]);
+        const sensor_entry_t *e = slots[k].entry;
+        for (int c = 0; c < e->n_channels; c++) {
+            const sensor_channel_t *ch = &e->channels[c];
+            if (ch->value >= SENSOR_MAX_VALUES) continue;
+            float scale = ch->scale != 0.0f ? ch->scale : 1.0f;
+            sensor_sched_add(ch->channel, slots[k].values[ch->value] * scale + ch->offset);
+        }
+    }
+    return n;
+}
+
+void sensor_registry_power_down(void)
+{
+    for (int i = 0; i < s_count; i++) {
+        const sensor_desc_t *d = s_table[i].desc;
+        if ((s_present & (1u << i)) && d->power_down) d->power_down(s_table[i].ctx);
+    }
+}
+
+uint32_t sensor_registry_present(void)
+{
+    return s_present;
+}
+
+uint32_t sensor_registry_failed(void)
+{
+    return s_failed;
+}
+
+sensor_health_t sensor_registry_health(int entry)
+{
+    if (entry < 0 || entry >= s_count) return SENSOR_HEALTH_OK;
+    return (sensor_health_t)s_health.entry[entry].state;
+}
+
+uint32_t sensor_registry_status(void)
+{
+    uint32_t bits = 0;
+    for (int i = 0; i < s_count; i++) {
+        if (s_health.entry[i].state != SENSOR_HEALTH_OK) bits |= 1u << i;
+    }
+    return bits;
+}
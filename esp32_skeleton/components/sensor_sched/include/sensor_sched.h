@@ -0,0 +1,120 @@
+// sensor_sched.h - per-sensor sampling periods and aggregation between sends
+#ifndef SENSOR_SCHED_H
+#define SENSOR_SCHED_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define SENSOR_SCHED_MAX_SENSORS  8
+#define SENSOR_SCHED_MAX_CHANNELS 16
+#define SENSOR_SCHED_MIN_SLEEP_US 1000000ULL
+
+/* How a channel's samples since the last delivered frame are reported. */
+typedef enum {
+    SENSOR_SCHED_AGG_MEAN,    // "k":mean
+    SENSOR_SCHED_AGG_MINMAX,  // "k":mean,"kn":min,"kx":max
+    SENSOR_SCHED_AGG_RANGE,   // "k":[min,mean,max]
+    SENSOR_SCHED_AGG_MAX,     // "k":max
+    SENSOR_SCHED_AGG_LAST,    // "k":last
+    SENSOR_SCHED_AGG_SUM,     // "k":sum
+} sensor_sched_agg_t;
+
+/* Something sampled on its own period, e.g. one acquisition job. */
+typedef struct {
+    const char *name;
+    uint32_t period_s;
+} sensor_sched_sensor_t;
+
+/* One reported value. Sent as value * scale + offset (scale 0 means 1). A
+ * channel without samples in the window is left out of the frame: a missing
+ * key means "no value", never a made-up 0. Channels are written in table
+ * order, so the last ones are dropped first when the frame runs out of room.
+ * `deadband` (reported units) is how far the channel must move from the
+ * last delivered frame to be worth a send; 0 = any change. The latest
+ * sample is compared (the peak for MAX, the total for SUM). */
+typedef struct {
+    const char *key;            // JSON key
+    uint8_t sensor;             // index into the sensor table
+    sensor_sched_agg_t agg;
+    float scale, offset;
+    uint8_t decimals;
+    float deadband;
+} sensor_sched_channel_t;
+
+typedef struct {
+    const sensor_sched_sensor_t *sensors;
+    int n_sensors;
+    const sensor_sched_channel_t *channels;
+    int n_channels;
+    uint64_t send_period_us;
+    uint64_t max_silence_us;    // send-on-delta: longest run of skipped sends, 0 = never skip
+} sensor_sched_config_t;
+
+/* Samples folded into a channel since the last delivered frame. */
+typedef struct {
+    uint16_t count;
+    float sum, min, max, last;
+} sensor_sched_window_t;
+
+/* Takes the tables (kept by pointer) and the wake time. After a cold boot,
+ * or if the tables changed, every sensor and the send are due at once. */
+void sensor_sched_init(const sensor_sched_config_t *cfg);
+
+/* Policy on top of the tables, e.g. from a power governor: every period
+ * (sensors and send) is multiplied by `stretch` (>= 1) and the sensors in
+ * `disabled` are never due. Call before sensor_sched_init() on every wake;
+ * unlike a table change it keeps the window. A shorter period than the one
+ * a slot was scheduled with pulls that slot in. Channels of a disabled
+ * sensor are left out of the frame unless they hold samples. */
+void sensor_sched_set_policy(uint32_t disabled, uint16_t stretch);
+
+/* Sensors due this wake, bit i = sensor i. */
+uint32_t sensor_sched_due(void);
+
+bool sensor_sched_send_due(void);
+
+/* Makes this wake a send wake, e.g. on a threshold event. A requested
+ * send is never skipped. */
+void sensor_sched_request_send(void);
+
+/* Send-on-delta: on a send wake, whether the frame is worth the radio.
+ * True if the send was requested, a channel moved beyond its deadband or
+ * appeared/disappeared since the last delivered frame, or max_silence_us
+ * has passed since it. Otherwise the caller skips the radio and calls
+ * sensor_sched_skipped(). */
+bool sensor_sched_should_send(void);
+
+/* The due send was skipped: schedules the next one and keeps the window. */
+void sensor_sched_skipped(void);
+
+/* Longest the receiver should wait for the next frame, in s: the silence
+ * limit (or the send period, if longer) plus one send period. */
+uint32_t sensor_sched_heartbeat_s(void);
+
+/* Adds one sample; NAN is ignored. */
+void sensor_sched_add(int ch, float value);
+
+/* Adds `count` samples already reduced elsewhere (e.g. by the ULP). */
+void sensor_sched_add_batch(int ch, uint16_t count, float mean, float min, float max, float last);
+
+/* The sensors in `mask` were sampled: schedules their next run. */
+void sensor_sched_sampled(uint32_t mask);
+
+/* Writes the window as `"k":v,...` (no braces) into buf, leaving out
+ * channels that would not fit in `len`. Returns the length written. The
+ * channels written are the ones sensor_sched_sent() commits. */
+int sensor_sched_format(char *buf, size_t len);
+
+/* Call on a send wake once the frame went out. delivered = acknowledged:
+ * the channels in the frame start over; otherwise, and for channels left
+ * out for room, the window keeps growing into the next frame. */
+void sensor_sched_sent(bool delivered);
+
+const sensor_sched_window_t *sensor_sched_window(int ch);
+
+/* Deep-sleep time until the earliest due sensor or send, at least
+ * SENSOR_SCHED_MIN_SLEEP_US. */
+uint64_t sensor_sched_sleep_us(void);
+
+#endif // SENSOR_SCHED_H
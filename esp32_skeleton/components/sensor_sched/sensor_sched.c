@@ -0,0 +1,260 @@
+// sensor_sched.c - per-sensor sampling periods and aggregation between sends
+#include "sensor_sched.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include "esp_attr.h"
+#include "esp_log.h"
+
+static const char *TAG = "SENSOR_SCHED";
+
+typedef struct {
+    uint32_t signature;       // tables the state below was built for
+    int64_t next_due_us[SENSOR_SCHED_MAX_SENSORS];
+    int64_t next_send_us;
+    sensor_sched_window_t window[SENSOR_SCHED_MAX_CHANNELS];
+    float delivered[SENSOR_SCHED_MAX_CHANNELS]; // channel_value() of the last delivered frame, NAN = none
+    int64_t delivered_us;                       // time of the last delivered frame, 0 = none
+} sched_state_t;
+
+static RTC_DATA_ATTR sched_state_t s_state;
+static const sensor_sched_config_t *s_cfg;
+static int64_t s_wake_us;
+static uint32_t s_due;
+static bool s_send;
+static bool s_requested;
+static uint32_t s_disabled;
+static uint16_t s_stretch = 1;
+static uint32_t s_written; // channels in the last sensor_sched_format()
+
+// gettimeofday() runs off the RTC timer, so it keeps counting in deep sleep.
+static int64_t now_us(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+// Changes whenever a period, the channel list or the send period changes.
+static uint32_t table_signature(const sensor_sched_config_t *cfg) {
+    uint32_t h = 2166136261u; // FNV-1a
+    #define MIX(v) (h = (h ^ (uint32_t)(v)) * 16777619u)
+    MIX(cfg->n_sensors);
+    MIX(cfg->n_channels);
+    MIX(cfg->send_period_us);
+    MIX(cfg->send_period_us >> 32);
+    for (int i = 0; i < cfg->n_sensors; i++) MIX(cfg->sensors[i].period_s);
+    for (int i = 0; i < cfg->n_channels; i++) MIX(cfg->channels[i].sensor << 8 | cfg->channels[i].agg);
+    #undef MIX
+    return h | 1; // never 0, the value of a cold RTC
+}
+
+static void channel_reset(int i) {
+    s_state.window[i] = (sensor_sched_window_t){ .min = INFINITY, .max = -INFINITY };
+}
+
+static void window_reset(void) {
+    for (int i = 0; i < SENSOR_SCHED_MAX_CHANNELS; i++) channel_reset(i);
+}
+
+static int64_t sensor_period_us(int i) {
+    return (int64_t)s_cfg->sensors[i].period_s * s_stretch * 1000000LL;
+}
+
+static int64_t send_period_us(void) {
+    return (int64_t)s_cfg->send_period_us * s_stretch;
+}
+
+// Next slot on the period grid; missed slots are skipped, not caught up.
+static int64_t next_slot(int64_t due, int64_t period_us) {
+    due += period_us;
+    return due > s_wake_us ? due : s_wake_us + period_us;
+}
+
+void sensor_sched_set_policy(uint32_t disabled, uint16_t stretch) {
+    s_disabled = disabled;
+    s_stretch = stretch ? stretch : 1;
+}
+
+void sensor_sched_init(const sensor_sched_config_t *cfg) {
+    s_cfg = cfg;
+    s_wake_us = now_us();
+    if (cfg->n_sensors > SENSOR_SCHED_MAX_SENSORS || cfg->n_channels > SENSOR_SCHED_MAX_CHANNELS) {
+        ESP_LOGE(TAG, "table too large: %d sensors, %d channels", cfg->n_sensors, cfg->n_channels);
+    }
+    uint32_t sig = table_signature(cfg);
+    if (s_state.signature != sig) {
+        memset(&s_state, 0, sizeof(s_state));
+        s_state.signature = sig;
+        for (int i = 0; i < SENSOR_SCHED_MAX_SENSORS; i++) s_state.next_due_us[i] = s_wake_us;
+        s_state.next_send_us = s_wake_us;
+        for (int i = 0; i < SENSOR_SCHED_MAX_CHANNELS; i++) s_state.delivered[i] = NAN;
+        window_reset();
+    }
+
+    // Slots scheduled under a longer stretch come in when it shortens
+    s_due = 0;
+    for (int i = 0; i < cfg->n_sensors && i < SENSOR_SCHED_MAX_SENSORS; i++) {
+        if (s_state.next_due_us[i] > s_wake_us + sensor_period_us(i)) {
+            s_state.next_due_us[i] = s_wake_us + sensor_period_us(i);
+        }
+        if (!(s_disabled & (1u << i)) && s_state.next_due_us[i] <= s_wake_us) s_due |= 1u << i;
+    }
+    if (s_state.next_send_us > s_wake_us + send_period_us()) {
+        s_state.next_send_us = s_wake_us + send_period_us();
+    }
+    s_send = s_state.next_send_us <= s_wake_us;
+    ESP_LOGI(TAG, "due 0x%02lx%s", (unsigned long)s_due, s_send ? ", send" : "");
+}
+
+uint32_t sensor_sched_due(void) {
+    return s_due;
+}
+
+bool sensor_sched_send_due(void) {
+    return s_send;
+}
+
+void sensor_sched_request_send(void) {
+    s_send = true;
+    s_requested = true;
+}
+
+void sensor_sched_add_batch(int ch, uint16_t count, float mean, float min, float max, float last) {
+    if (ch < 0 || ch >= SENSOR_SCHED_MAX_CHANNELS || count == 0 || isnan(mean)) return;
+    sensor_sched_window_t *w = &s_state.window[ch];
+    if (w->count > UINT16_MAX - count) return; // window long overdue; keep what we have
+    w->count += count;
+    w->sum += mean * count;
+    if (min < w->min) w->min = min;
+    if (max > w->max) w->max = max;
+    w->last = last;
+}
+
+void sensor_sched_add(int ch, float value) {
+    sensor_sched_add_batch(ch, 1, value, value, value, value);
+}
+
+void sensor_sched_sampled(uint32_t mask) {
+    for (int i = 0; i < s_cfg->n_sensors && i < SENSOR_SCHED_MAX_SENSORS; i++) {
+        if (!(mask & (1u << i))) continue;
+        s_state.next_due_us[i] = next_slot(s_state.next_due_us[i], sensor_period_us(i));
+    }
+}
+
+static int format_channel(char *buf, size_t len, const sensor_sched_channel_t *c,
+                          const sensor_sched_window_t *w) {
+    float k = c->scale != 0.0f ? c->scale : 1.0f;
+    int d = c->decimals;
+    float mean = w->sum / w->count * k + c->offset;
+    float lo = w->min * k + c->offset, hi = w->max * k + c->offset;
+    if (k < 0) { float t = lo; lo = hi; hi = t; }
+    switch (c->agg) {
+    case SENSOR_SCHED_AGG_MINMAX:
+        return snprintf(buf, len, "\"%s\":%.*f,\"%sn\":%.*f,\"%sx\":%.*f",
+                        c->key, d, mean, c->key, d, lo, c->key, d, hi);
+    case SENSOR_SCHED_AGG_RANGE:
+        return snprintf(buf, len, "\"%s\":[%.*f,%.*f,%.*f]", c->key, d, lo, d, mean, d, hi);
+    case SENSOR_SCHED_AGG_MAX:
+        return snprintf(buf, len, "\"%s\":%.*f", c->key, d, hi);
+    case SENSOR_SCHED_AGG_LAST:
+        return snprintf(buf, len, "\"%s\":%.*f", c->key, d, w->last * k + c->offset);
+    case SENSOR_SCHED_AGG_SUM:
+        return snprintf(buf, len, "\"%s\":%.*f", c->key, d, w->sum * k + c->offset);
+    case SENSOR_SCHED_AGG_MEAN:
+    default:
+        return snprintf(buf, len, "\"%s\":%.*f", c->key, d, mean);
+    }
+}
+
+// What send-on-delta compares, in reported units; NAN without samples.
+static float channel_value(const sensor_sched_channel_t *c, const sensor_sched_window_t *w) {
+    if (w->count == 0) return NAN;
+    float k = c->scale != 0.0f ? c->scale : 1.0f;
+    float v = c->agg == SENSOR_SCHED_AGG_MAX ? w->max : c->agg == SENSOR_SCHED_AGG_SUM ? w->sum : w->last;
+    return v * k + c->offset;
+}
+
+bool sensor_sched_should_send(void) {
+    if (!s_send) return false;
+    if (s_requested || s_cfg->max_silence_us == 0 || s_state.delivered_us == 0) return true;
+    if (now_us() - s_state.delivered_us >= (int64_t)s_cfg->max_silence_us) {
+        ESP_LOGI(TAG, "silence limit reached");
+        return true;
+    }
+    for (int i = 0; i < s_cfg->n_channels && i < SENSOR_SCHED_MAX_CHANNELS; i++) {
+        const sensor_sched_channel_t *c = &s_cfg->channels[i];
+        float v = channel_value(c, &s_state.window[i]);
+        float sent = s_state.delivered[i];
+        if (isnan(v) && isnan(sent)) continue;
+        // A channel only disappears by its sensor being turned off, which
+        // the window does not need to report.
+        if (isnan(v)) continue;
+        if (isnan(sent) || fabsf(v - sent) > c->deadband) {
+            ESP_LOGI(TAG, "\"%s\" changed: %.3f -> %.3f", c->key, sent, v);
+            return true;
+        }
+    }
+    return false;
+}
+
+void sensor_sched_skipped(void) {
+    s_state.next_send_us = next_slot(s_state.next_send_us, send_period_us());
+}
+
+uint32_t sensor_sched_heartbeat_s(void) {
+    uint64_t period = (uint64_t)send_period_us();
+    uint64_t silence = s_cfg->max_silence_us > period ? s_cfg->max_silence_us : period;
+    return (uint32_t)((silence + period) / 1000000);
+}
+
+int sensor_sched_format(char *buf, size_t len) {
+    int pos = 0;
+    s_written = 0;
+    if (len) buf[0] = '\0';
+    for (int i = 0; i < s_cfg->n_channels && i < SENSOR_SCHED_MAX_CHANNELS; i++) {
+        const sensor_sched_channel_t *c = &s_cfg->channels[i];
+        const sensor_sched_window_t *w = &s_state.window[i];
+        if (w->count == 0) continue; // failed, backing off, disabled or not due
+
+        int sep = pos > 0;
+        if (sep && (size_t)pos + 1 < len) buf[pos] = ',';
+        int n = (size_t)(pos + sep) < len ? format_channel(buf + pos + sep, len - pos - sep, c, w) : -1;
+        if (n < 0 || (size_t)(pos + sep + n) >= len) {
+            buf[pos] = '\0'; // did not fit
+            ESP_LOGW(TAG, "no room for \"%s\", kept for the next frame", c->key);
+            continue;
+        }
+        pos += sep + n;
+        s_written |= 1u << i;
+    }
+    return pos;
+}
+
+void sensor_sched_sent(bool delivered) {
+    s_state.next_send_us = next_slot(s_state.next_send_us, send_period_us());
+    if (!delivered) return;
+    // Only what went out: a channel left out for room keeps its samples
+    // and its send-on-delta baseline
+    for (int i = 0; i < s_cfg->n_channels && i < SENSOR_SCHED_MAX_CHANNELS; i++) {
+        if (!(s_written & (1u << i))) continue;
+        float v = channel_value(&s_cfg->channels[i], &s_state.window[i]);
+        if (!isnan(v)) s_state.delivered[i] = v; // an empty window leaves the old value standing
+        channel_reset(i);
+    }
+    s_state.delivered_us = now_us();
+}
+
+const sensor_sched_window_t *sensor_sched_window(int ch) {
+    return (ch >= 0 && ch < SENSOR_SCHED_MAX_CHANNELS) ? &s_state.window[ch] : NULL;
+}
+
+uint64_t sensor_sched_sleep_us(void) {
+    int64_t next = s_state.next_send_us;
+    for (int i = 0; i < s_cfg->n_sensors && i < SENSOR_SCHED_MAX_SENSORS; i++) {
+        if (s_disabled & (1u << i)) continue;
+        if (s_state.next_due_us[i] < next) next = s_state.next_due_us[i];
+    }
+    int64_t sleep = next - now_us();
+    return sleep > (int64_t)SENSOR_SCHED_MIN_SLEEP_US ? (uint64_t)sleep : SENSOR_SCHED_MIN_SLEEP_US;
+}
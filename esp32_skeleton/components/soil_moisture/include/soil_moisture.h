@@ -5,6 +5,7 @@
 #include "freertos/task.h"
 
 void soil_moisture_init(void);
-void soil_moisture_read(float *soil_moisture);
+int soil_moisture_read(float *soil_moisture); // 0, or -1 (and NAN) on an ADC error
+int soil_moisture_read_mv(void); // calibrated, -1 on error
 
 #endif // SOIL_MOISTURE_Hcd
\ No newline at end of file
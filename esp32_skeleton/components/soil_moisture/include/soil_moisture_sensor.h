@@ -0,0 +1,11 @@
+// soil_moisture_sensor.h - soil moisture probe as a sensor_registry descriptor
+#ifndef SOIL_MOISTURE_SENSOR_H
+#define SOIL_MOISTURE_SENSOR_H
+
+#include "sensor_registry.h"
+
+/* Values: soil moisture (normalized). Read from the shared ADC burst, so
+ * call soil_moisture_init() first; the entry ctx is unused. */
+extern const sensor_desc_t soil_moisture_sensor;
+
+#endif // SOIL_MOISTURE_SENSOR_H
@@ -1,23 +1,37 @@
 // soil_moisture.c - Grove Soil Moisture sensor driver source (stub)
 #include "soil_moisture.h"
+#include <math.h>
 #include <stdio.h>
-#include "driver/adc.h" // Uncomment if using ADC
+#include "adc_service.h"
+#include "probe_power.h"
 
-#define SOIL_MOISTURE_ADC_CHAN ADC1_CHANNEL_6 // Replace with your ADC channel
+#define SOIL_MOISTURE_ADC_CHAN ADC_CHANNEL_6 // ADC1, GPIO34
+#define SOIL_MOISTURE_POWER_PIN GPIO_NUM_NC  // not gated on this board; set a GPIO to switch the probe
+#define SOIL_MOISTURE_SETTLE_US 5000
 
 // Initialization Function
 void soil_moisture_init(void) {
-    // 12-bit resolution (0-4095)
-    adc1_config_width(ADC_WIDTH_BIT_12);
+    int probe = probe_power_add("soil", SOIL_MOISTURE_POWER_PIN, SOIL_MOISTURE_SETTLE_US);
 
-    // 11 dB attenuation = full-scale voltage ~ 0V–3.3V
-    adc1_config_channel_atten(SOIL_MOISTURE_ADC_CHAN, ADC_ATTEN_DB_11);
+    // 12-bit, 12 dB attenuation (same as the rain sensor) via the shared service
+    adc_service_add_channel(SOIL_MOISTURE_ADC_CHAN);
+    if (probe >= 0) adc_service_set_power(SOIL_MOISTURE_ADC_CHAN, probe);
 
     printf("Soil Moisture sensor initialized (real hardware)!\n");
 }
 
 // Convert raw value to "Soil Moisture Index"
-void soil_moisture_read(float *soil_moisture) {
-    int raw = adc1_get_raw(SOIL_MOISTURE_ADC_CHAN); // Calls raw value which will range from 0-4095 bits
-    *soil_moisture = raw * 10 / 4095.0; // Scales from 0 to 10; this is the arbitrary unit of "Soil Moisture Index" that will range from bone-dry to completely saturated
+int soil_moisture_read(float *soil_moisture) {
+    int mv = soil_moisture_read_mv(); // filtered, calibrated millivolts
+    if (mv < 0) {
+        *soil_moisture = NAN; // a failed burst is not a dry soil
+        return -1;
+    }
+    *soil_moisture = mv * 10 / 3300.0f; // Scales from 0 to 10; this is the arbitrary unit of "Soil Moisture Index" that will range from bone-dry to completely saturated
+    return 0;
+}
+
+int soil_moisture_read_mv(void) {
+    adc_service_reading_t r;
+    return adc_service_read(SOIL_MOISTURE_ADC_CHAN, &r) == ESP_OK ? r.mv : -1;
 }
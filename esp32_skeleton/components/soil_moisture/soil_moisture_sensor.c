@@ -0,0 +1,19 @@
+// soil_moisture_sensor.c - soil moisture probe as a sensor_registry descriptor
+#include "soil_moisture_sensor.h"
+#include "soil_moisture.h"
+
+static int soil_collect(void *ctx, float *values)
+{
+    return soil_moisture_read(&values[0]);
+}
+
+static const char *const soil_names[] = { "moisture" };
+
+// No trigger: the ADC burst's settle time is the only wait
+const sensor_desc_t soil_moisture_sensor = {
+    .name = "soil_m",
+    .bus = SENSOR_BUS_ADC,
+    .n_values = 1,
+    .value_names = soil_names,
+    .collect = soil_collect,
+};
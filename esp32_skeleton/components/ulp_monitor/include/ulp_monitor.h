@@ -0,0 +1,63 @@
+// ulp_monitor.h - ULP coprocessor program that watches inputs during deep sleep
+#ifndef ULP_MONITOR_H
+#define ULP_MONITOR_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "driver/gpio.h"
+#include "hal/adc_types.h"
+
+#define ULP_MONITOR_PERIOD_US   10000 // ULP run interval
+#define ULP_MONITOR_DEBOUNCE    3     // runs a new level must hold (~30 ms)
+
+/* Loads and starts the ULP program counting debounced edges on `pulse_gpio`
+ * (must be an RTC GPIO, idle high with the internal pull-up). The program
+ * keeps running across deep sleep and CPU wakes, so this only loads it on a
+ * cold boot; later calls just reattach. */
+esp_err_t ulp_monitor_start(gpio_num_t pulse_gpio);
+
+/* Edges counted since the program was loaded. 16 bits: callers diff two
+ * readings with uint16_t arithmetic. */
+uint16_t ulp_monitor_edge_count(void);
+
+/* Analog inputs the ULP samples in deep sleep. These are immediates in
+ * ulp/adc_sample.S; change both together. */
+#define ULP_MONITOR_RAIN_ADC_CHANNEL ADC_CHANNEL_0  // rain plate
+#define ULP_MONITOR_SOIL_ADC_CHANNEL ADC_CHANNEL_6  // soil moisture
+#define ULP_MONITOR_RAIN_POWER_GPIO  GPIO_NUM_13    // rain plate supply, 10 ms settle
+#define ULP_MONITOR_ADC_RUN_MS       10             // = RAIN_SETTLE_MS in adc_sample.S
+
+/* ulp_monitor_adc_collect() wake reasons */
+#define ULP_MONITOR_WAKE_BATCH 0x1   // batch_size samples taken
+#define ULP_MONITOR_WAKE_ONSET 0x2   // rain plate crossed the onset threshold
+
+typedef struct {
+    uint16_t samples;
+    uint16_t min, max, last;   // raw 12-bit
+    float mean;                // raw
+} ulp_monitor_adc_stats_t;
+
+/* Sets the deep-sleep sampling plan: one sample of both channels every
+ * `period_ms` (rounded to ULP runs), a CPU wake after `batch` samples, and
+ * a single wake when the rain plate reads >= `rain_onset_raw` (re-armed
+ * once it reads below again). Takes effect at the next deep sleep. */
+void ulp_monitor_adc_config(uint32_t period_ms, uint16_t batch, uint16_t rain_onset_raw);
+
+/* Stops ULP sampling for the wake so the CPU can use ADC1. A ULP run that
+ * was already sampling is waited out (about 20 ms, in vTaskDelay), so ADC1,
+ * the rain plate supply and the batch statistics are the CPU's on return.
+ * Call early, before any adc_service use. */
+void ulp_monitor_adc_pause(void);
+
+/* Statistics of the samples taken since the last collect, then starts a new
+ * batch. Returns the ULP_MONITOR_WAKE_* bits that were pending. */
+uint32_t ulp_monitor_adc_collect(ulp_monitor_adc_stats_t *rain, ulp_monitor_adc_stats_t *soil);
+
+/* Hands ADC1 and the rain plate supply to the ULP, enables ULP wakeup, and
+ * keeps the RTC peripherals powered in deep sleep so the ULP can read the
+ * RTC GPIO and the ADC. The CPU must have released ADC1 (adc_service_release())
+ * and latched the other probe supplies already. Call right before
+ * esp_deep_sleep_start(). */
+void ulp_monitor_prepare_sleep(void);
+
+#endif // ULP_MONITOR_H
@@ -0,0 +1,152 @@
+// ulp_monitor.c - loads the ULP FSM program and reads its counters
+#include "ulp_monitor.h"
+#include <stdbool.h>
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_sleep.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/rtc_io.h"
+#include "esp_adc/adc_oneshot.h"
+#include "ulp.h"
+#include "ulp_main.h"
+
+static const char *TAG = "ULP_MONITOR";
+
+extern const uint8_t ulp_main_bin_start[] asm("_binary_ulp_main_bin_start");
+extern const uint8_t ulp_main_bin_end[]   asm("_binary_ulp_main_bin_end");
+
+// RTC slow memory is zeroed on a cold boot, so this says whether the
+// program already running on the ULP is ours.
+static RTC_DATA_ATTR bool s_loaded;
+
+// Reset state of one batch: min at the top so the first sample replaces it.
+static void adc_batch_reset(void) {
+    ulp_rain_min = ulp_soil_min = UINT16_MAX;
+    ulp_rain_max = ulp_soil_max = 0;
+    ulp_rain_sum_lo = ulp_rain_sum_hi = 0;
+    ulp_soil_sum_lo = ulp_soil_sum_hi = 0;
+    ulp_sample_count = 0;
+    ulp_sample_tick = 0;
+    ulp_batch_ready = 0;
+}
+
+esp_err_t ulp_monitor_start(gpio_num_t pulse_gpio) {
+    if (!rtc_gpio_is_valid_gpio(pulse_gpio)) {
+        ESP_LOGE(TAG, "GPIO %d is not an RTC GPIO", pulse_gpio);
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_loaded) return ESP_OK;
+
+    esp_err_t err = ulp_load_binary(0, ulp_main_bin_start,
+                                    (ulp_main_bin_end - ulp_main_bin_start) / sizeof(uint32_t));
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "ULP load failed: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    rtc_gpio_init(pulse_gpio);
+    rtc_gpio_set_direction(pulse_gpio, RTC_GPIO_MODE_INPUT_ONLY);
+    rtc_gpio_pulldown_dis(pulse_gpio);
+    rtc_gpio_pullup_en(pulse_gpio);
+    rtc_gpio_hold_en(pulse_gpio);
+
+    ulp_io_number = rtc_io_number_get(pulse_gpio);
+    ulp_next_edge = 0;              // idle high: the first edge falls
+    ulp_debounce_max_count = ULP_MONITOR_DEBOUNCE;
+    ulp_debounce_counter = ULP_MONITOR_DEBOUNCE;
+    ulp_edge_count = 0;
+
+    ulp_adc_enable = 0;
+    ulp_wake_reason = 0;
+    ulp_onset_armed = 1;
+    adc_batch_reset();
+
+    ulp_set_wakeup_period(0, ULP_MONITOR_PERIOD_US);
+    err = ulp_run(&ulp_entry - RTC_SLOW_MEM);
+    if (err == ESP_OK) {
+        s_loaded = true;
+        ESP_LOGI(TAG, "ULP counting edges on GPIO %d every %d us", pulse_gpio, ULP_MONITOR_PERIOD_US);
+    }
+    return err;
+}
+
+uint16_t ulp_monitor_edge_count(void) {
+    // ULP stores the 16-bit register in the low half of the word.
+    return (uint16_t)(ulp_edge_count & UINT16_MAX);
+}
+
+void ulp_monitor_adc_config(uint32_t period_ms, uint16_t batch, uint16_t rain_onset_raw) {
+    uint32_t div = period_ms * 1000 / ULP_MONITOR_PERIOD_US;
+    ulp_sample_div = div == 0 ? 1 : (div > UINT16_MAX ? UINT16_MAX : div);
+    ulp_batch_size = batch == 0 ? 1 : batch;
+    ulp_rain_onset_raw = rain_onset_raw;
+}
+
+void ulp_monitor_adc_pause(void) {
+    if (!s_loaded || ulp_adc_enable == 0) return; // cold boot, or already paused
+    ulp_adc_enable = 0;
+    // A run past the adc_enable check still powers the plate, settles and
+    // reads ADC1 into the stats. Wait longer than the settle plus one run
+    // period; +1 tick because vTaskDelay() may end up to a tick early.
+    vTaskDelay(pdMS_TO_TICKS(ULP_MONITOR_ADC_RUN_MS + ULP_MONITOR_PERIOD_US / 1000) + 1);
+}
+
+static void fill_stats(ulp_monitor_adc_stats_t *out, uint16_t n, uint32_t min, uint32_t max,
+                       uint32_t lo, uint32_t hi, uint32_t last) {
+    out->samples = n;
+    out->min = n ? (uint16_t)min : 0;
+    out->max = (uint16_t)max;
+    out->last = (uint16_t)last;
+    out->mean = n ? (float)(((hi & UINT16_MAX) << 16) | (lo & UINT16_MAX)) / n : 0.0f;
+}
+
+uint32_t ulp_monitor_adc_collect(ulp_monitor_adc_stats_t *rain, ulp_monitor_adc_stats_t *soil) {
+    // Paused and waited out, so the ULP does not touch any of this now.
+    uint16_t n = ulp_sample_count & UINT16_MAX;
+    fill_stats(rain, n, ulp_rain_min & UINT16_MAX, ulp_rain_max & UINT16_MAX,
+               ulp_rain_sum_lo, ulp_rain_sum_hi, ulp_rain_last & UINT16_MAX);
+    fill_stats(soil, n, ulp_soil_min & UINT16_MAX, ulp_soil_max & UINT16_MAX,
+               ulp_soil_sum_lo, ulp_soil_sum_hi, ulp_soil_last & UINT16_MAX);
+    uint32_t reason = ulp_wake_reason & UINT16_MAX;
+    ulp_wake_reason = 0;
+    if (n && rain->last < (ulp_rain_onset_raw & UINT16_MAX)) ulp_onset_armed = 1;
+    adc_batch_reset();
+    return reason;
+}
+
+// The handle has to outlive this function: deleting a ULP-mode unit turns
+// the ADC's sleep power off again. It is re-created before every sleep.
+static adc_oneshot_unit_handle_t s_ulp_adc;
+
+void ulp_monitor_prepare_sleep(void) {
+    if (!s_loaded) return;
+    if (!s_ulp_adc) {
+        adc_oneshot_unit_init_cfg_t unit_cfg = {
+            .unit_id = ADC_UNIT_1,
+            .ulp_mode = ADC_ULP_MODE_FSM,
+        };
+        adc_oneshot_chan_cfg_t chan_cfg = {
+            .atten = ADC_ATTEN_DB_12,    // same as adc_service, so its calibration applies
+            .bitwidth = ADC_BITWIDTH_12,
+        };
+        if (adc_oneshot_new_unit(&unit_cfg, &s_ulp_adc) != ESP_OK ||
+            adc_oneshot_config_channel(s_ulp_adc, ULP_MONITOR_RAIN_ADC_CHANNEL, &chan_cfg) != ESP_OK ||
+            adc_oneshot_config_channel(s_ulp_adc, ULP_MONITOR_SOIL_ADC_CHANNEL, &chan_cfg) != ESP_OK) {
+            ESP_LOGE(TAG, "ULP ADC setup failed, no sampling this sleep");
+            esp_sleep_pd_config(ESP_PD_DOMAIN_RTC_PERIPH, ESP_PD_OPTION_ON);
+            return;
+        }
+    }
+
+    // The ULP drives the rain plate supply itself, through the RTC mux.
+    gpio_num_t pwr = ULP_MONITOR_RAIN_POWER_GPIO;
+    rtc_gpio_hold_dis(pwr);
+    rtc_gpio_init(pwr);
+    rtc_gpio_set_direction(pwr, RTC_GPIO_MODE_OUTPUT_ONLY);
+    rtc_gpio_set_level(pwr, 0);
+
+    ulp_adc_enable = 1;
+    esp_sleep_enable_ulp_wakeup();
+    esp_sleep_pd_config(ESP_PD_DOMAIN_RTC_PERIPH, ESP_PD_OPTION_ON);
+}
@@ -0,0 +1,58 @@
+// wake_profile.h - where the time of one wake cycle goes
+#ifndef WAKE_PROFILE_H
+#define WAKE_PROFILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Phases of a satellite wake, in the order they normally run. A phase lasts
+ * from its mark to the next mark (or to wake_profile_finish()). Phases not
+ * reached on a wake, e.g. the radio ones on a sample-only wake, count 0. */
+typedef enum {
+    WAKE_PHASE_BOOT,        // app startup to app_main (esp_timer starts after the bootloader)
+    WAKE_PHASE_INIT,        // bus and sensor init
+    WAKE_PHASE_UART,        // LoRa UART config
+    WAKE_PHASE_LORA_RESET,  // module reset and boot wait
+    WAKE_PHASE_LORA_SETUP,  // AT setup
+    WAKE_PHASE_HANDSHAKE,   // boot handshake with the MiddleMan
+    WAKE_PHASE_ACQUIRE,     // sensor conversions (per sensor: acq_last_timings())
+    WAKE_PHASE_ENCODE,      // frame built
+    WAKE_PHASE_TX,          // AT+SEND written
+    WAKE_PHASE_ACK,         // waiting for MM_ACK_DATA, resends included
+    WAKE_PHASE_SLEEP,       // sleep entry: UART drain, latches, ULP hand-off
+    WAKE_PHASE_COUNT
+} wake_phase_t;
+
+typedef struct {
+    bool valid;
+    uint32_t total_us;
+    uint32_t phase_us[WAKE_PHASE_COUNT];
+} wake_profile_t;
+
+/* Starts a new profile; call first thing in app_main. Everything before
+ * it is WAKE_PHASE_BOOT. */
+void wake_profile_begin(void);
+
+void wake_profile_mark(wake_phase_t phase);
+
+/* Closes the profile; call right before esp_deep_sleep_start(). */
+void wake_profile_finish(void);
+
+/* The previous wake's profile, kept in RTC memory. */
+const wake_profile_t *wake_profile_last(void);
+
+/* The last wake that brought the radio up (marked WAKE_PHASE_UART). Most
+ * wakes only sample, so wake_profile_last() rarely has radio phases. */
+const wake_profile_t *wake_profile_last_send(void);
+
+/* Writes the last send wake before this one as
+ * "wp":[total,boot,init,...,sleep] in ms, or nothing if there is none or
+ * it does not fit in `len`. Returns the length written. */
+int wake_profile_format(char *buf, size_t len);
+
+const char *wake_profile_phase_name(wake_phase_t phase);
+
+void wake_profile_log(void);
+
+#endif // WAKE_PROFILE_H
@@ -0,0 +1,85 @@
+// wake_profile.c - where the time of one wake cycle goes
+#include "wake_profile.h"
+#include <stdio.h>
+#include <string.h>
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "WAKE_PROFILE";
+
+#define NOT_REACHED UINT32_MAX
+
+static const char *const phase_names[WAKE_PHASE_COUNT] = {
+    "boot", "init", "uart", "lora_reset", "lora_setup", "handshake",
+    "acquire", "encode", "tx", "ack", "sleep",
+};
+
+// esp_timer time each phase started this wake. RTC so it is still there
+// if the wake ends in a crash; the next begin() overwrites it.
+static RTC_DATA_ATTR uint32_t s_marks[WAKE_PHASE_COUNT];
+static RTC_DATA_ATTR wake_profile_t s_last;
+static RTC_DATA_ATTR wake_profile_t s_last_send; // last wake that brought the radio up
+
+void wake_profile_begin(void) {
+    for (int i = 0; i < WAKE_PHASE_COUNT; i++) s_marks[i] = NOT_REACHED;
+    s_marks[WAKE_PHASE_BOOT] = 0; // esp_timer starts counting at boot
+    s_marks[WAKE_PHASE_INIT] = (uint32_t)esp_timer_get_time();
+}
+
+void wake_profile_mark(wake_phase_t phase) {
+    if (phase < WAKE_PHASE_COUNT) s_marks[phase] = (uint32_t)esp_timer_get_time();
+}
+
+void wake_profile_finish(void) {
+    uint32_t end = (uint32_t)esp_timer_get_time();
+    wake_profile_t p = { .valid = true, .total_us = end };
+    // A phase runs until the next phase that started after it.
+    for (int i = 0; i < WAKE_PHASE_COUNT; i++) {
+        if (s_marks[i] == NOT_REACHED) continue;
+        uint32_t next = end;
+        for (int j = 0; j < WAKE_PHASE_COUNT; j++) {
+            if (s_marks[j] != NOT_REACHED && s_marks[j] > s_marks[i] && s_marks[j] < next) next = s_marks[j];
+        }
+        p.phase_us[i] = next - s_marks[i];
+    }
+    s_last = p;
+    if (s_marks[WAKE_PHASE_UART] != NOT_REACHED) s_last_send = p;
+    wake_profile_log();
+}
+
+const wake_profile_t *wake_profile_last(void) {
+    return &s_last;
+}
+
+const wake_profile_t *wake_profile_last_send(void) {
+    return &s_last_send;
+}
+
+int wake_profile_format(char *buf, size_t len) {
+    if (len) buf[0] = '\0';
+    const wake_profile_t *p = &s_last_send;
+    if (!p->valid) return 0;
+    char tmp[16 * (WAKE_PHASE_COUNT + 1)];
+    int n = snprintf(tmp, sizeof(tmp), "\"wp\":[%lu", (unsigned long)(p->total_us / 1000));
+    for (int i = 0; i < WAKE_PHASE_COUNT; i++) {
+        n += snprintf(tmp + n, sizeof(tmp) - n, ",%lu", (unsigned long)(p->phase_us[i] / 1000));
+    }
+    n += snprintf(tmp + n, sizeof(tmp) - n, "]");
+    if ((size_t)n >= len) return 0;
+    memcpy(buf, tmp, n + 1);
+    return n;
+}
+
+const char *wake_profile_phase_name(wake_phase_t phase) {
+    return phase < WAKE_PHASE_COUNT ? phase_names[phase] : "?";
+}
+
+void wake_profile_log(void) {
+    if (!s_last.valid) return;
+    for (int i = 0; i < WAKE_PHASE_COUNT; i++) {
+        if (s_last.phase_us[i] == 0) continue;
+        ESP_LOGI(TAG, "%-10s %8lu us", phase_names[i], (unsigned long)s_last.phase_us[i]);
+    }
+    ESP_LOGI(TAG, "wake total %lu us", (unsigned long)s_last.total_us);
+}
@@ -0,0 +1,60 @@
+// bench.h - shared types for the bme68x.c compensation benchmark
+#ifndef BME68X_BENCH_H
+#define BME68X_BENCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Raw NVM calibration, as get_calib_data() decodes it. */
+typedef struct {
+    const char *name;
+    uint16_t par_t1; int16_t par_t2; int8_t par_t3;
+    uint16_t par_p1; int16_t par_p2; int8_t par_p3; int16_t par_p4; int16_t par_p5;
+    int8_t par_p6; int8_t par_p7; int16_t par_p8; int16_t par_p9; uint8_t par_p10;
+    uint16_t par_h1; uint16_t par_h2; int8_t par_h3; int8_t par_h4; int8_t par_h5;
+    uint8_t par_h6; int8_t par_h7;
+    int8_t par_gh1; int16_t par_gh2; int8_t par_gh3;
+    uint8_t res_heat_range; int8_t res_heat_val; int8_t range_sw_err;
+    int8_t amb_temp;
+} bench_calib_t;
+
+/* One field register read, already unpacked into ADC counts. */
+typedef struct {
+    uint32_t temp_adc;
+    uint32_t pres_adc;
+    uint16_t hum_adc;
+    uint16_t gas_adc;
+    uint8_t gas_range;
+    uint16_t heatr_temp; // degC, input of calc_res_heat
+} bench_raw_t;
+
+/* Compensated outputs normalised to degC, Pa, %RH and ohm. */
+typedef struct {
+    double temperature;
+    double pressure;
+    double humidity;
+    double gas_low;
+    double gas_high;
+    uint8_t res_heat;
+} bench_out_t;
+
+typedef enum {
+    BENCH_CALC_TEMPERATURE,
+    BENCH_CALC_PRESSURE,
+    BENCH_CALC_HUMIDITY,
+    BENCH_CALC_GAS_LOW,
+    BENCH_CALC_GAS_HIGH,
+    BENCH_CALC_RES_HEAT,
+    BENCH_CALC_COUNT
+} bench_calc_t;
+
+/* Implemented once per compensation path (bench_int.c, bench_fpu.c). */
+void bench_int_compute(const bench_calib_t *calib, const bench_raw_t *raw, bench_out_t *out);
+double bench_int_ns_per_call(bench_calc_t calc, const bench_calib_t *calib,
+                             const bench_raw_t *raw, size_t n_raw, uint32_t iters);
+
+void bench_fpu_compute(const bench_calib_t *calib, const bench_raw_t *raw, bench_out_t *out);
+double bench_fpu_ns_per_call(bench_calc_t calc, const bench_calib_t *calib,
+                             const bench_raw_t *raw, size_t n_raw, uint32_t iters);
+
+#endif // BME68X_BENCH_H
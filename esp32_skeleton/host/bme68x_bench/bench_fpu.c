@@ -0,0 +1,3 @@
+// bench_fpu.c - floating point compensation path of bme68x.c
+#define BENCH_NS fpu
+#include "bench_impl.h"
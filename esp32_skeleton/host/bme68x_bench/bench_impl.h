@@ -0,0 +1,154 @@
+// bench_impl.h - per-path half of the compensation benchmark
+//
+// Included by bench_int.c and bench_fpu.c with BENCH_NS set to `int` or
+// `fpu`. It pulls bme68x.c into the including translation unit so the
+// static calc_* routines can be called directly, and renames the driver's
+// public API so both copies link into one executable.
+#ifndef BENCH_NS
+#error "define BENCH_NS before including bench_impl.h"
+#endif
+
+#define BENCH_CAT_(a, b, c) a##_##b##_##c
+#define BENCH_CAT(a, b, c)  BENCH_CAT_(a, b, c)
+#define BENCH_FN(name)      BENCH_CAT(bench, BENCH_NS, name)
+
+#define bme68x_init            BENCH_FN(bme68x_init)
+#define bme68x_set_regs        BENCH_FN(bme68x_set_regs)
+#define bme68x_get_regs        BENCH_FN(bme68x_get_regs)
+#define bme68x_soft_reset      BENCH_FN(bme68x_soft_reset)
+#define bme68x_set_conf        BENCH_FN(bme68x_set_conf)
+#define bme68x_get_conf        BENCH_FN(bme68x_get_conf)
+#define bme68x_set_op_mode     BENCH_FN(bme68x_set_op_mode)
+#define bme68x_get_op_mode     BENCH_FN(bme68x_get_op_mode)
+#define bme68x_get_meas_dur    BENCH_FN(bme68x_get_meas_dur)
+#define bme68x_get_data        BENCH_FN(bme68x_get_data)
+#define bme68x_set_heatr_conf  BENCH_FN(bme68x_set_heatr_conf)
+#define bme68x_get_heatr_conf  BENCH_FN(bme68x_get_heatr_conf)
+#define bme68x_selftest_check  BENCH_FN(bme68x_selftest_check)
+
+#include "bme68x.c"
+#include "bench.h"
+#include <string.h>
+#include <time.h>
+
+#ifdef BME68X_USE_FPU
+#define TEMP_SCALE 1.0
+#define HUM_SCALE  1.0
+#else
+#define TEMP_SCALE 100.0
+#define HUM_SCALE  1000.0
+#endif
+
+static void load_calib(struct bme68x_dev *dev, const bench_calib_t *c)
+{
+    memset(dev, 0, sizeof(*dev));
+    dev->amb_temp = c->amb_temp;
+    dev->calib.par_t1 = c->par_t1;
+    dev->calib.par_t2 = c->par_t2;
+    dev->calib.par_t3 = c->par_t3;
+    dev->calib.par_p1 = c->par_p1;
+    dev->calib.par_p2 = c->par_p2;
+    dev->calib.par_p3 = c->par_p3;
+    dev->calib.par_p4 = c->par_p4;
+    dev->calib.par_p5 = c->par_p5;
+    dev->calib.par_p6 = c->par_p6;
+    dev->calib.par_p7 = c->par_p7;
+    dev->calib.par_p8 = c->par_p8;
+    dev->calib.par_p9 = c->par_p9;
+    dev->calib.par_p10 = c->par_p10;
+    dev->calib.par_h1 = c->par_h1;
+    dev->calib.par_h2 = c->par_h2;
+    dev->calib.par_h3 = c->par_h3;
+    dev->calib.par_h4 = c->par_h4;
+    dev->calib.par_h5 = c->par_h5;
+    dev->calib.par_h6 = c->par_h6;
+    dev->calib.par_h7 = c->par_h7;
+    dev->calib.par_gh1 = c->par_gh1;
+    dev->calib.par_gh2 = c->par_gh2;
+    dev->calib.par_gh3 = c->par_gh3;
+    dev->calib.res_heat_range = c->res_heat_range;
+    dev->calib.res_heat_val = c->res_heat_val;
+    dev->calib.range_sw_err = c->range_sw_err;
+    calc_derived_calib(&dev->calib);
+}
+
+void BENCH_FN(compute)(const bench_calib_t *calib, const bench_raw_t *raw, bench_out_t *out)
+{
+    struct bme68x_dev dev;
+
+    load_calib(&dev, calib);
+    out->temperature = calc_temperature(raw->temp_adc, &dev) / TEMP_SCALE;
+    out->pressure = calc_pressure(raw->pres_adc, &dev);
+    out->humidity = calc_humidity(raw->hum_adc, &dev) / HUM_SCALE;
+    out->gas_low = calc_gas_resistance_low(raw->gas_adc, raw->gas_range, &dev);
+    out->gas_high = calc_gas_resistance_high(raw->gas_adc, raw->gas_range);
+    out->res_heat = calc_res_heat(raw->heatr_temp, &dev);
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+double BENCH_FN(ns_per_call)(bench_calc_t calc, const bench_calib_t *calib,
+                             const bench_raw_t *raw, size_t n_raw, uint32_t iters)
+{
+    struct bme68x_dev dev;
+    volatile double sink = 0;
+    double t_fine[64];
+
+    if (n_raw == 0 || n_raw > sizeof(t_fine) / sizeof(t_fine[0]))
+    {
+        return -1.0;
+    }
+
+    load_calib(&dev, calib);
+
+    /* Pressure and humidity depend on the t_fine left behind by the temperature step */
+    for (size_t i = 0; i < n_raw; i++)
+    {
+        (void)calc_temperature(raw[i].temp_adc, &dev);
+        t_fine[i] = dev.calib.t_fine;
+    }
+
+    double start = now_ns();
+    for (uint32_t it = 0; it < iters; it++)
+    {
+        for (size_t i = 0; i < n_raw; i++)
+        {
+            const bench_raw_t *r = &raw[i];
+            switch (calc)
+            {
+                case BENCH_CALC_TEMPERATURE:
+                    sink += calc_temperature(r->temp_adc, &dev);
+                    break;
+                case BENCH_CALC_PRESSURE:
+                    dev.calib.t_fine = t_fine[i];
+                    sink += calc_pressure(r->pres_adc, &dev);
+                    break;
+                case BENCH_CALC_HUMIDITY:
+                    dev.calib.t_fine = t_fine[i];
+                    sink += calc_humidity(r->hum_adc, &dev);
+                    break;
+                case BENCH_CALC_GAS_LOW:
+                    sink += calc_gas_resistance_low(r->gas_adc, r->gas_range, &dev);
+                    break;
+                case BENCH_CALC_GAS_HIGH:
+                    sink += calc_gas_resistance_high(r->gas_adc, r->gas_range);
+                    break;
+                case BENCH_CALC_RES_HEAT:
+                    sink += calc_res_heat(r->heatr_temp, &dev);
+                    break;
+                default:
+                    return -1.0;
+            }
+        }
+    }
+    double elapsed = now_ns() - start;
+
+    (void)sink;
+    return elapsed / ((double)iters * (double)n_raw);
+}
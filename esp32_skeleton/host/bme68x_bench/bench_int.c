@@ -0,0 +1,4 @@
+// bench_int.c - integer compensation path of bme68x.c
+#define BME68X_DO_NOT_USE_FPU
+#define BENCH_NS int
+#include "bench_impl.h"
@@ -0,0 +1,111 @@
+// bench_main.c - integer vs float compensation benchmark for bme68x.c
+//
+// Runs every calc_* routine of both compensation paths over the vectors in
+// vectors.h, checks the two paths agree within the sensor's own resolution,
+// and reports the cost of each routine in ns per call.
+//
+// Usage: bme68x_bench [iterations]
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "vectors.h"
+
+#define DEFAULT_ITERS 200000u
+
+/* Largest int/float disagreement we accept; both are well under the
+ * sensor's stated accuracy (0.5 degC, 60 Pa, 3 %RH, 15 % gas). */
+#define TOL_TEMPERATURE 0.02   // degC
+#define TOL_PRESSURE    10.0   // Pa
+#define TOL_HUMIDITY    0.05   // %RH
+#define TOL_GAS_REL     0.01   // fraction of the float value
+#define TOL_GAS_HIGH    100.0  // ohm; the integer high-variant path rounds to 100 ohm
+#define TOL_RES_HEAT    1      // register code
+
+static const char *calc_names[BENCH_CALC_COUNT] = {
+    "calc_temperature",
+    "calc_pressure",
+    "calc_humidity",
+    "calc_gas_resistance_low",
+    "calc_gas_resistance_high",
+    "calc_res_heat",
+};
+
+typedef struct {
+    double temperature;
+    double pressure;
+    double humidity;
+    double gas_low;
+    double gas_high;
+    int res_heat;
+} max_diff_t;
+
+static double rel_diff(double a, double b)
+{
+    return (b != 0.0) ? fabs(a - b) / fabs(b) : fabs(a);
+}
+
+static void track(double *max, double value)
+{
+    if (value > *max) *max = value;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t iters = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : DEFAULT_ITERS;
+    max_diff_t diff = { 0 };
+    int failures = 0;
+
+    if (iters == 0) iters = DEFAULT_ITERS;
+
+    printf("== Agreement (integer vs float) ==\n");
+    printf("%-7s %-3s %10s %10s %9s %9s %8s %8s %12s %12s %4s %4s\n",
+           "calib", "#", "T int", "T fpu", "P int", "P fpu", "H int", "H fpu",
+           "Gl int", "Gl fpu", "R i", "R f");
+
+    for (size_t c = 0; c < BENCH_N_CALIBS; c++) {
+        for (size_t r = 0; r < BENCH_N_RAWS; r++) {
+            bench_out_t oi, of;
+
+            bench_int_compute(&bench_calibs[c], &bench_raws[r], &oi);
+            bench_fpu_compute(&bench_calibs[c], &bench_raws[r], &of);
+
+            printf("%-7s %-3zu %10.2f %10.3f %9.0f %9.1f %8.3f %8.3f %12.0f %12.0f %4u %4u\n",
+                   bench_calibs[c].name, r, oi.temperature, of.temperature,
+                   oi.pressure, of.pressure, oi.humidity, of.humidity,
+                   oi.gas_low, of.gas_low, oi.res_heat, of.res_heat);
+
+            track(&diff.temperature, fabs(oi.temperature - of.temperature));
+            track(&diff.pressure, fabs(oi.pressure - of.pressure));
+            track(&diff.humidity, fabs(oi.humidity - of.humidity));
+            track(&diff.gas_low, rel_diff(oi.gas_low, of.gas_low));
+            track(&diff.gas_high, fabs(oi.gas_high - of.gas_high));
+            if (abs((int)oi.res_heat - (int)of.res_heat) > diff.res_heat) {
+                diff.res_heat = abs((int)oi.res_heat - (int)of.res_heat);
+            }
+        }
+    }
+
+    printf("\nmax |int - fpu|: T %.4f degC, P %.2f Pa, H %.4f %%RH, "
+           "gas low %.3f %%, gas high %.0f ohm, res_heat %d\n",
+           diff.temperature, diff.pressure, diff.humidity,
+           diff.gas_low * 100.0, diff.gas_high, diff.res_heat);
+
+    if (diff.temperature > TOL_TEMPERATURE) { printf("FAIL: temperature\n"); failures++; }
+    if (diff.pressure > TOL_PRESSURE)       { printf("FAIL: pressure\n"); failures++; }
+    if (diff.humidity > TOL_HUMIDITY)       { printf("FAIL: humidity\n"); failures++; }
+    if (diff.gas_low > TOL_GAS_REL)         { printf("FAIL: gas resistance (low)\n"); failures++; }
+    if (diff.gas_high > TOL_GAS_HIGH)       { printf("FAIL: gas resistance (high)\n"); failures++; }
+    if (diff.res_heat > TOL_RES_HEAT)       { printf("FAIL: res_heat\n"); failures++; }
+
+    printf("\n== Cost (%u iterations x %zu vectors, calib %s) ==\n",
+           iters, BENCH_N_RAWS, bench_calibs[0].name);
+    printf("%-26s %10s %10s %8s\n", "routine", "int ns", "fpu ns", "fpu/int");
+    for (int k = 0; k < BENCH_CALC_COUNT; k++) {
+        double ni = bench_int_ns_per_call((bench_calc_t)k, &bench_calibs[0], bench_raws, BENCH_N_RAWS, iters);
+        double nf = bench_fpu_ns_per_call((bench_calc_t)k, &bench_calibs[0], bench_raws, BENCH_N_RAWS, iters);
+        printf("%-26s %10.2f %10.2f %8.2f\n", calc_names[k], ni, nf, (ni > 0.0) ? nf / ni : 0.0);
+    }
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,51 @@
+// vectors.h - calibration and raw ADC vectors for the compensation benchmark
+//
+// Each calibration set is the decoded NVM of one sensor (the fields
+// get_calib_data() fills). The raw vectors span the outdoor operating range
+// of a satellite: cold and hot air, dry and saturated, and every gas range
+// the heater profiles actually hit. Add dumps from new units here.
+#ifndef BME68X_BENCH_VECTORS_H
+#define BME68X_BENCH_VECTORS_H
+
+#include "bench.h"
+
+static const bench_calib_t bench_calibs[] = {
+    {
+        .name = "unit-a",
+        .par_t1 = 26113, .par_t2 = 26458, .par_t3 = 3,
+        .par_p1 = 36212, .par_p2 = -10410, .par_p3 = 88, .par_p4 = 6944, .par_p5 = -51,
+        .par_p6 = 30, .par_p7 = 33, .par_p8 = -2716, .par_p9 = -2186, .par_p10 = 30,
+        .par_h1 = 792, .par_h2 = 1040, .par_h3 = 0, .par_h4 = 45, .par_h5 = 20,
+        .par_h6 = 120, .par_h7 = -100,
+        .par_gh1 = -34, .par_gh2 = -11860, .par_gh3 = 18,
+        .res_heat_range = 1, .res_heat_val = 42, .range_sw_err = 0,
+        .amb_temp = 25,
+    },
+    {
+        .name = "unit-b",
+        .par_t1 = 25933, .par_t2 = 26641, .par_t3 = 3,
+        .par_p1 = 36745, .par_p2 = -10513, .par_p3 = 88, .par_p4 = 6433, .par_p5 = -166,
+        .par_p6 = 30, .par_p7 = 41, .par_p8 = -3412, .par_p9 = -1512, .par_p10 = 30,
+        .par_h1 = 763, .par_h2 = 1004, .par_h3 = 0, .par_h4 = 45, .par_h5 = 20,
+        .par_h6 = 120, .par_h7 = -100,
+        .par_gh1 = -29, .par_gh2 = -11036, .par_gh3 = 18,
+        .res_heat_range = 1, .res_heat_val = 39, .range_sw_err = -1,
+        .amb_temp = 10,
+    },
+};
+
+static const bench_raw_t bench_raws[] = {
+    { .temp_adc = 367604, .pres_adc = 381322, .hum_adc = 14210, .gas_adc = 612, .gas_range = 4,  .heatr_temp = 320 },
+    { .temp_adc = 390118, .pres_adc = 378890, .hum_adc = 17240, .gas_adc = 401, .gas_range = 6,  .heatr_temp = 100 },
+    { .temp_adc = 413575, .pres_adc = 376012, .hum_adc = 20015, .gas_adc = 287, .gas_range = 8,  .heatr_temp = 200 },
+    { .temp_adc = 436240, .pres_adc = 371407, .hum_adc = 22880, .gas_adc = 733, .gas_range = 9,  .heatr_temp = 300 },
+    { .temp_adc = 459012, .pres_adc = 368155, .hum_adc = 24412, .gas_adc = 918, .gas_range = 10, .heatr_temp = 320 },
+    { .temp_adc = 482398, .pres_adc = 365031, .hum_adc = 19007, .gas_adc = 512, .gas_range = 5,  .heatr_temp = 250 },
+    { .temp_adc = 505770, .pres_adc = 362874, .hum_adc = 15533, .gas_adc = 150, .gas_range = 12, .heatr_temp = 150 },
+    { .temp_adc = 528113, .pres_adc = 360112, .hum_adc = 26125, .gas_adc = 990, .gas_range = 13, .heatr_temp = 400 },
+};
+
+#define BENCH_N_CALIBS (sizeof(bench_calibs) / sizeof(bench_calibs[0]))
+#define BENCH_N_RAWS   (sizeof(bench_raws) / sizeof(bench_raws[0]))
+
+#endif // BME68X_BENCH_VECTORS_H
@@ -0,0 +1,456 @@
+// bme68x_emu.c - register-level BME68x emulator for host builds
+#include "bme68x_emu.h"
+#include <math.h>
+#include <string.h>
+#include "driver/i2c_master.h"
+#include "host_clock.h"
+
+#define FIELD_BASE(i)       (BME68X_REG_FIELD0 + (i) * BME68X_LEN_FIELD_OFFSET)
+#define MEASURING_MSK       UINT8_C(0x20)
+#define GAS_MEASURING_MSK   UINT8_C(0x40)
+#define RUN_GAS_MSK         BME68X_RUN_GAS_MSK
+#define NB_CONV_MSK         BME68X_NBCONV_MSK
+#define MAX_CYCLES_PER_POLL 1024
+
+const bme68x_emu_calib_t bme68x_emu_default_calib = {
+    .par_t1 = 26113, .par_t2 = 26458, .par_t3 = 3,
+    .par_p1 = 36212, .par_p2 = -10410, .par_p3 = 88, .par_p4 = 6944, .par_p5 = -51,
+    .par_p6 = 30, .par_p7 = 33, .par_p8 = -2716, .par_p9 = -2186, .par_p10 = 30,
+    .par_h1 = 792, .par_h2 = 1040, .par_h3 = 0, .par_h4 = 45, .par_h5 = 20,
+    .par_h6 = 120, .par_h7 = -100,
+    .par_gh1 = -34, .par_gh2 = -11860, .par_gh3 = 18,
+    .res_heat_range = 1, .res_heat_val = 42, .range_sw_err = 0,
+};
+
+static const uint8_t os_to_cycles[8] = { 0, 1, 2, 4, 8, 16, 16, 16 };
+static const uint8_t filter_to_coeff[8] = { 0, 1, 3, 7, 15, 31, 63, 127 };
+
+static uint64_t now(const bme68x_emu_t *emu)
+{
+    return emu->now_us ? emu->now_us() : emu->own_time_us;
+}
+
+/* ---------------------------------------------------------------- NVM --- */
+
+// Index into the 42-byte coefficient array get_calib_data() assembles.
+static uint8_t *coeff(bme68x_emu_t *emu, uint8_t idx)
+{
+    if (idx < BME68X_LEN_COEFF1) return &emu->regs[BME68X_REG_COEFF1 + idx];
+    idx -= BME68X_LEN_COEFF1;
+    if (idx < BME68X_LEN_COEFF2) return &emu->regs[BME68X_REG_COEFF2 + idx];
+    idx -= BME68X_LEN_COEFF2;
+    return &emu->regs[BME68X_REG_COEFF3 + idx];
+}
+
+static void put16(bme68x_emu_t *emu, uint8_t lsb_idx, uint8_t msb_idx, uint16_t v)
+{
+    *coeff(emu, lsb_idx) = (uint8_t)(v & 0xFF);
+    *coeff(emu, msb_idx) = (uint8_t)(v >> 8);
+}
+
+static void load_nvm(bme68x_emu_t *emu)
+{
+    const bme68x_emu_calib_t *c = &emu->calib;
+
+    put16(emu, BME68X_IDX_T1_LSB, BME68X_IDX_T1_MSB, c->par_t1);
+    put16(emu, BME68X_IDX_T2_LSB, BME68X_IDX_T2_MSB, (uint16_t)c->par_t2);
+    *coeff(emu, BME68X_IDX_T3) = (uint8_t)c->par_t3;
+
+    put16(emu, BME68X_IDX_P1_LSB, BME68X_IDX_P1_MSB, c->par_p1);
+    put16(emu, BME68X_IDX_P2_LSB, BME68X_IDX_P2_MSB, (uint16_t)c->par_p2);
+    *coeff(emu, BME68X_IDX_P3) = (uint8_t)c->par_p3;
+    put16(emu, BME68X_IDX_P4_LSB, BME68X_IDX_P4_MSB, (uint16_t)c->par_p4);
+    put16(emu, BME68X_IDX_P5_LSB, BME68X_IDX_P5_MSB, (uint16_t)c->par_p5);
+    *coeff(emu, BME68X_IDX_P6) = (uint8_t)c->par_p6;
+    *coeff(emu, BME68X_IDX_P7) = (uint8_t)c->par_p7;
+    put16(emu, BME68X_IDX_P8_LSB, BME68X_IDX_P8_MSB, (uint16_t)c->par_p8);
+    put16(emu, BME68X_IDX_P9_LSB, BME68X_IDX_P9_MSB, (uint16_t)c->par_p9);
+    *coeff(emu, BME68X_IDX_P10) = c->par_p10;
+
+    // H1 and H2 are 12-bit values sharing the nibbles of one byte.
+    *coeff(emu, BME68X_IDX_H2_MSB) = (uint8_t)(c->par_h2 >> 4);
+    *coeff(emu, BME68X_IDX_H1_LSB) = (uint8_t)(((c->par_h2 & 0x0F) << 4) | (c->par_h1 & 0x0F));
+    *coeff(emu, BME68X_IDX_H1_MSB) = (uint8_t)(c->par_h1 >> 4);
+    *coeff(emu, BME68X_IDX_H3) = (uint8_t)c->par_h3;
+    *coeff(emu, BME68X_IDX_H4) = (uint8_t)c->par_h4;
+    *coeff(emu, BME68X_IDX_H5) = (uint8_t)c->par_h5;
+    *coeff(emu, BME68X_IDX_H6) = c->par_h6;
+    *coeff(emu, BME68X_IDX_H7) = (uint8_t)c->par_h7;
+
+    *coeff(emu, BME68X_IDX_GH1) = (uint8_t)c->par_gh1;
+    put16(emu, BME68X_IDX_GH2_LSB, BME68X_IDX_GH2_MSB, (uint16_t)c->par_gh2);
+    *coeff(emu, BME68X_IDX_GH3) = (uint8_t)c->par_gh3;
+
+    *coeff(emu, BME68X_IDX_RES_HEAT_VAL) = (uint8_t)c->res_heat_val;
+    *coeff(emu, BME68X_IDX_RES_HEAT_RANGE) = (uint8_t)((c->res_heat_range << 4) & BME68X_RHRANGE_MSK);
+    *coeff(emu, BME68X_IDX_RANGE_SW_ERR) = (uint8_t)(((uint8_t)c->range_sw_err << 4) & BME68X_RSERROR_MSK);
+}
+
+/* ------------------------------------------------------------- timing --- */
+
+static uint32_t tph_us(const bme68x_emu_t *emu)
+{
+    uint8_t ctrl_meas = emu->regs[BME68X_REG_CTRL_MEAS];
+    uint32_t cycles = os_to_cycles[(ctrl_meas >> BME68X_OST_POS) & 0x07] +
+                      os_to_cycles[(ctrl_meas >> BME68X_OSP_POS) & 0x07] +
+                      os_to_cycles[emu->regs[BME68X_REG_CTRL_HUM] & BME68X_OSH_MSK];
+
+    // Same model as the datasheet (and bme68x_get_meas_dur): conversions,
+    // TPH switching and the gas measurement itself.
+    return cycles * 1963 + 477 * 4 + 477 * 5;
+}
+
+static bool gas_enabled(const bme68x_emu_t *emu)
+{
+    return (emu->regs[BME68X_REG_CTRL_GAS_1] & RUN_GAS_MSK) != 0;
+}
+
+// gas_wait: 6-bit value times a 1/4/16/64 multiplier, in ms.
+static uint32_t gas_wait_ms(uint8_t reg)
+{
+    static const uint8_t mult[4] = { 1, 4, 16, 64 };
+    return (uint32_t)(reg & 0x3F) * mult[reg >> 6];
+}
+
+// Shared heater duration: same encoding in steps of 0.477 ms.
+static uint32_t shared_heatr_us(uint8_t reg)
+{
+    static const uint8_t mult[4] = { 1, 4, 16, 64 };
+    return (uint32_t)(reg & 0x3F) * mult[reg >> 6] * 477;
+}
+
+static uint32_t parallel_cycle_us(const bme68x_emu_t *emu)
+{
+    return tph_us(emu) + shared_heatr_us(emu->regs[BME68X_REG_SHD_HEATR_DUR]);
+}
+
+uint32_t bme68x_emu_conversion_us(const bme68x_emu_t *emu)
+{
+    if (emu->mode == BME68X_PARALLEL_MODE) return parallel_cycle_us(emu);
+
+    uint32_t us = tph_us(emu) + 1000; // wake-up from sleep
+    if (gas_enabled(emu)) {
+        uint8_t nb_conv = emu->regs[BME68X_REG_CTRL_GAS_1] & NB_CONV_MSK;
+        us += gas_wait_ms(emu->regs[BME68X_REG_GAS_WAIT0 + nb_conv]) * 1000;
+    }
+    return us;
+}
+
+/* ------------------------------------------------------- conversions --- */
+
+// Standard normal deviate (xorshift64* + Box-Muller); deterministic per emulator.
+static double gaussian(bme68x_emu_t *emu)
+{
+    double u[2];
+    for (int i = 0; i < 2; i++) {
+        emu->rng ^= emu->rng >> 12;
+        emu->rng ^= emu->rng << 25;
+        emu->rng ^= emu->rng >> 27;
+        u[i] = ((emu->rng * UINT64_C(2685821657736338717)) >> 11) * (1.0 / 9007199254740992.0);
+    }
+    return sqrt(-2.0 * log(u[0] + 1e-300)) * cos(6.283185307179586 * u[1]);
+}
+
+static double clamp_adc(double v, double max)
+{
+    return v < 0.0 ? 0.0 : (v > max ? max : v);
+}
+
+// One conversion's ADC counts: injected value, noise averaged over the
+// oversampled cycles, then the IIR filter on T and P.
+static void sample_tph(bme68x_emu_t *emu, uint32_t *temp_adc, uint32_t *pres_adc, uint16_t *hum_adc)
+{
+    uint8_t ctrl_meas = emu->regs[BME68X_REG_CTRL_MEAS];
+    uint8_t ost = os_to_cycles[(ctrl_meas >> BME68X_OST_POS) & 0x07];
+    uint8_t osp = os_to_cycles[(ctrl_meas >> BME68X_OSP_POS) & 0x07];
+    uint8_t osh = os_to_cycles[emu->regs[BME68X_REG_CTRL_HUM] & BME68X_OSH_MSK];
+    uint8_t c = filter_to_coeff[(emu->regs[BME68X_REG_CONFIG] & BME68X_FILTER_MSK) >> BME68X_FILTER_POS];
+
+    double t = emu->tph.temp_adc, p = emu->tph.pres_adc, h = emu->tph.hum_adc;
+    if (ost) t += emu->noise.temp_adc * gaussian(emu) / sqrt(ost);
+    if (osp) p += emu->noise.pres_adc * gaussian(emu) / sqrt(osp);
+    if (osh) h += emu->noise.hum_adc * gaussian(emu) / sqrt(osh);
+
+    if (!emu->filt_valid || c == 0) {
+        emu->filt_temp = t;
+        emu->filt_pres = p;
+        emu->filt_valid = true;
+    } else {
+        emu->filt_temp = (emu->filt_temp * c + t) / (c + 1);
+        emu->filt_pres = (emu->filt_pres * c + p) / (c + 1);
+    }
+
+    *temp_adc = (uint32_t)lround(clamp_adc(emu->filt_temp, 0xFFFFF));
+    *pres_adc = (uint32_t)lround(clamp_adc(emu->filt_pres, 0xFFFFF));
+    *hum_adc = (uint16_t)lround(clamp_adc(h, 0xFFFF));
+}
+
+static void write_field(bme68x_emu_t *emu, uint8_t field, uint8_t gas_index, bool gas_valid)
+{
+    uint8_t *f = &emu->regs[FIELD_BASE(field)];
+    const bme68x_emu_gas_t *g = &emu->gas[gas_index % BME68X_EMU_MAX_STEPS];
+    uint8_t gas_status = gas_valid ? (BME68X_GASM_VALID_MSK | BME68X_HEAT_STAB_MSK) : 0;
+    uint32_t temp_adc, pres_adc;
+    uint16_t hum_adc;
+
+    sample_tph(emu, &temp_adc, &pres_adc, &hum_adc);
+
+    memset(f, 0, BME68X_LEN_FIELD);
+    f[0] = (uint8_t)(BME68X_NEW_DATA_MSK | (gas_index & BME68X_GAS_INDEX_MSK));
+    f[1] = emu->meas_index++;
+    f[2] = (uint8_t)(pres_adc >> 12);
+    f[3] = (uint8_t)(pres_adc >> 4);
+    f[4] = (uint8_t)((pres_adc & 0x0F) << 4);
+    f[5] = (uint8_t)(temp_adc >> 12);
+    f[6] = (uint8_t)(temp_adc >> 4);
+    f[7] = (uint8_t)((temp_adc & 0x0F) << 4);
+    f[8] = (uint8_t)(hum_adc >> 8);
+    f[9] = (uint8_t)(hum_adc & 0xFF);
+
+    // Both gas register pairs are filled; the variant picks which one is read.
+    uint8_t gas_lo = (uint8_t)(((g->gas_adc & 0x03) << 6) | gas_status | (g->gas_range & BME68X_GAS_RANGE_MSK));
+    f[13] = (uint8_t)(g->gas_adc >> 2);
+    f[14] = gas_lo;
+    f[15] = (uint8_t)(g->gas_adc >> 2);
+    f[16] = gas_lo;
+}
+
+static void start_conversion(bme68x_emu_t *emu, uint8_t mode)
+{
+    emu->mode = mode;
+    emu->converting = true;
+    emu->conv_start_us = now(emu);
+    emu->conv_end_us = emu->conv_start_us + bme68x_emu_conversion_us(emu);
+
+    if (mode == BME68X_FORCED_MODE) {
+        uint8_t *f0 = &emu->regs[FIELD_BASE(0)];
+        f0[0] = (uint8_t)((f0[0] & ~BME68X_NEW_DATA_MSK) | MEASURING_MSK |
+                          (gas_enabled(emu) ? GAS_MEASURING_MSK : 0));
+    } else {
+        emu->step = 0;
+        emu->step_cycle = 0;
+        emu->next_field = 0;
+    }
+}
+
+// Completes every conversion whose end time has passed.
+static void update(bme68x_emu_t *emu)
+{
+    uint64_t t = now(emu);
+
+    if (!emu->converting) return;
+
+    if (emu->mode == BME68X_FORCED_MODE) {
+        if (t < emu->conv_end_us) return;
+        uint8_t nb_conv = emu->regs[BME68X_REG_CTRL_GAS_1] & NB_CONV_MSK;
+        write_field(emu, 0, nb_conv, gas_enabled(emu));
+        emu->regs[BME68X_REG_CTRL_MEAS] &= (uint8_t)~BME68X_MODE_MSK; // back to sleep
+        emu->converting = false;
+        emu->mode = BME68X_SLEEP_MODE;
+        emu->stats.conversions++;
+        return;
+    }
+
+    uint8_t profile_len = emu->regs[BME68X_REG_CTRL_GAS_1] & NB_CONV_MSK;
+    if (profile_len == 0) profile_len = 1;
+
+    for (int n = 0; n < MAX_CYCLES_PER_POLL && t >= emu->conv_end_us; n++) {
+        uint8_t mult = emu->regs[BME68X_REG_GAS_WAIT0 + emu->step];
+        if (mult == 0) mult = 1;
+        bool last_cycle_of_step = (uint8_t)(emu->step_cycle + 1) >= mult;
+
+        write_field(emu, emu->next_field, emu->step, gas_enabled(emu) && last_cycle_of_step);
+        emu->next_field = (uint8_t)((emu->next_field + 1) % 3);
+        emu->stats.conversions++;
+
+        if (last_cycle_of_step) {
+            emu->step = (uint8_t)((emu->step + 1) % profile_len);
+            emu->step_cycle = 0;
+        } else {
+            emu->step_cycle++;
+        }
+        emu->conv_end_us += parallel_cycle_us(emu);
+    }
+}
+
+/* ---------------------------------------------------------- registers --- */
+
+void bme68x_emu_reset(bme68x_emu_t *emu)
+{
+    memset(emu->regs, 0, sizeof(emu->regs));
+    emu->regs[BME68X_REG_CHIP_ID] = BME68X_CHIP_ID;
+    emu->regs[BME68X_REG_VARIANT_ID] = emu->variant_id;
+    load_nvm(emu);
+    emu->converting = false;
+    emu->mode = BME68X_SLEEP_MODE;
+    emu->meas_index = 0;
+    emu->filt_valid = false;
+}
+
+static bool is_read_only(uint8_t reg)
+{
+    if (reg == BME68X_REG_CHIP_ID || reg == BME68X_REG_VARIANT_ID) return true;
+    if (reg >= BME68X_REG_FIELD0 && reg < FIELD_BASE(3)) return true;
+    if (reg >= BME68X_REG_COEFF1 && reg < BME68X_REG_COEFF1 + BME68X_LEN_COEFF1) return true;
+    if (reg >= BME68X_REG_COEFF2 && reg < BME68X_REG_COEFF2 + BME68X_LEN_COEFF2) return true;
+    return reg < BME68X_REG_COEFF3 + BME68X_LEN_COEFF3;
+}
+
+static void write_reg(bme68x_emu_t *emu, uint8_t reg, uint8_t val)
+{
+    if (reg == BME68X_REG_SOFT_RESET) {
+        if (val == BME68X_SOFT_RESET_CMD) bme68x_emu_reset(emu);
+        return;
+    }
+    if (is_read_only(reg)) return;
+
+    emu->regs[reg] = val;
+    if (reg != BME68X_REG_CTRL_MEAS) return;
+
+    uint8_t mode = val & BME68X_MODE_MSK;
+    if (mode == BME68X_SLEEP_MODE) {
+        emu->converting = false;
+        emu->mode = BME68X_SLEEP_MODE;
+    } else if (mode == BME68X_FORCED_MODE || mode == BME68X_PARALLEL_MODE) {
+        start_conversion(emu, mode);
+    }
+}
+
+// Consumes one transaction from the error-injection budget.
+static bool inject_error(bme68x_emu_t *emu)
+{
+    if (emu->fail_count == 0) return false;
+    if (emu->fail_after > 0) {
+        emu->fail_after--;
+        return false;
+    }
+    emu->fail_count--;
+    emu->stats.injected_errors++;
+    return true;
+}
+
+int8_t bme68x_emu_read(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, void *intf_ptr)
+{
+    bme68x_emu_t *emu = intf_ptr;
+
+    if (!emu || !reg_data) return BME68X_E_NULL_PTR;
+    if (inject_error(emu)) return BME68X_E_COM_FAIL;
+
+    update(emu);
+    if (emu->converting && emu->mode == BME68X_FORCED_MODE &&
+        reg_addr < FIELD_BASE(1) && reg_addr + len > BME68X_REG_FIELD0 + 2) {
+        emu->stats.stale_reads++;
+    }
+
+    for (uint32_t i = 0; i < len; i++) {
+        reg_data[i] = emu->regs[(uint8_t)(reg_addr + i)];
+    }
+    emu->stats.reads++;
+    emu->stats.bytes_read += len;
+    return BME68X_OK;
+}
+
+// I2C writes are register/value pairs after the first register pointer.
+int8_t bme68x_emu_write(uint8_t reg_addr, const uint8_t *reg_data, uint32_t len, void *intf_ptr)
+{
+    bme68x_emu_t *emu = intf_ptr;
+
+    if (!emu || (!reg_data && len)) return BME68X_E_NULL_PTR;
+    if (inject_error(emu)) return BME68X_E_COM_FAIL;
+
+    update(emu);
+    if (len > 0) write_reg(emu, reg_addr, reg_data[0]);
+    for (uint32_t i = 1; i + 1 < len; i += 2) {
+        write_reg(emu, reg_data[i], reg_data[i + 1]);
+    }
+    emu->stats.writes++;
+    emu->stats.bytes_written += len + 1;
+    return BME68X_OK;
+}
+
+void bme68x_emu_delay_us(uint32_t period, void *intf_ptr)
+{
+    bme68x_emu_t *emu = intf_ptr;
+
+    if (!emu) return;
+    if (emu->now_us) {
+        host_clock_advance_us(period);
+    } else {
+        emu->own_time_us += period;
+    }
+}
+
+/* -------------------------------------------------------------- setup --- */
+
+void bme68x_emu_init(bme68x_emu_t *emu, const bme68x_emu_calib_t *calib)
+{
+    memset(emu, 0, sizeof(*emu));
+    emu->calib = calib ? *calib : bme68x_emu_default_calib;
+    emu->variant_id = BME68X_VARIANT_GAS_HIGH; // BME688
+    emu->rng = UINT64_C(0x9E3779B97F4A7C15);
+
+    // Mid-range indoor conditions until the caller injects something else.
+    emu->tph.temp_adc = 482398;
+    emu->tph.pres_adc = 378890;
+    emu->tph.hum_adc = 22015;
+    for (uint8_t i = 0; i < BME68X_EMU_MAX_STEPS; i++) {
+        emu->gas[i].gas_adc = 512;
+        emu->gas[i].gas_range = 5;
+    }
+    bme68x_emu_reset(emu);
+}
+
+void bme68x_emu_attach(bme68x_emu_t *emu, struct bme68x_dev *dev)
+{
+    dev->intf = BME68X_I2C_INTF;
+    dev->intf_ptr = emu;
+    dev->read = bme68x_emu_read;
+    dev->write = bme68x_emu_write;
+    dev->delay_us = bme68x_emu_delay_us;
+    dev->amb_temp = 25;
+}
+
+static int i2c_target_write(void *ctx, const uint8_t *buf, size_t len)
+{
+    if (len == 0) return 0;
+    return bme68x_emu_write(buf[0], &buf[1], (uint32_t)(len - 1), ctx) != BME68X_OK;
+}
+
+static int i2c_target_read(void *ctx, const uint8_t *wbuf, size_t wlen, uint8_t *rbuf, size_t rlen)
+{
+    uint8_t reg = wlen ? wbuf[0] : 0;
+    return bme68x_emu_read(reg, rbuf, (uint32_t)rlen, ctx) != BME68X_OK;
+}
+
+int bme68x_emu_register_i2c(bme68x_emu_t *emu, uint16_t addr)
+{
+    host_i2c_target_t target = {
+        .write = i2c_target_write,
+        .read = i2c_target_read,
+        .ctx = emu,
+    };
+
+    emu->now_us = host_clock_now_us;
+    return host_i2c_register_target(addr, &target);
+}
+
+void bme68x_emu_set_tph(bme68x_emu_t *emu, const bme68x_emu_tph_t *tph)
+{
+    emu->tph = *tph;
+}
+
+void bme68x_emu_set_gas(bme68x_emu_t *emu, uint8_t step, const bme68x_emu_gas_t *gas)
+{
+    if (step < BME68X_EMU_MAX_STEPS) emu->gas[step] = *gas;
+}
+
+void bme68x_emu_set_noise(bme68x_emu_t *emu, const bme68x_emu_noise_t *noise)
+{
+    emu->noise = *noise;
+}
+
+void bme68x_emu_inject_bus_errors(bme68x_emu_t *emu, uint32_t after, uint32_t count)
+{
+    emu->fail_after = after;
+    emu->fail_count = count;
+}
@@ -0,0 +1,125 @@
+// bme68x_emu.h - register-level BME68x emulator for host builds
+//
+// Plugs into a struct bme68x_dev through its read/write/delay_us pointers
+// (bme68x_emu_attach), or behind the host I2C stand-in so the unmodified
+// bme688.c talks to it (bme68x_emu_register_i2c). It models:
+//  - calibration NVM, chip and variant ID, soft reset
+//  - forced and parallel mode conversions with the datasheet timing
+//  - the three field registers, filled from injected raw ADC counts
+//  - bus errors injected after a given number of transactions
+#ifndef BME68X_EMU_H
+#define BME68X_EMU_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "bme68x.h"
+
+#define BME68X_EMU_MAX_STEPS 10
+
+/* Calibration as get_calib_data() decodes it; encoded into NVM on reset. */
+typedef struct {
+    uint16_t par_t1; int16_t par_t2; int8_t par_t3;
+    uint16_t par_p1; int16_t par_p2; int8_t par_p3; int16_t par_p4; int16_t par_p5;
+    int8_t par_p6; int8_t par_p7; int16_t par_p8; int16_t par_p9; uint8_t par_p10;
+    uint16_t par_h1; uint16_t par_h2; int8_t par_h3; int8_t par_h4; int8_t par_h5;
+    uint8_t par_h6; int8_t par_h7;
+    int8_t par_gh1; int16_t par_gh2; int8_t par_gh3;
+    uint8_t res_heat_range; int8_t res_heat_val; int8_t range_sw_err;
+} bme68x_emu_calib_t;
+
+/* Raw ADC counts reported by the next conversions. */
+typedef struct {
+    uint32_t temp_adc;
+    uint32_t pres_adc;
+    uint16_t hum_adc;
+} bme68x_emu_tph_t;
+
+typedef struct {
+    uint16_t gas_adc;
+    uint8_t gas_range;
+} bme68x_emu_gas_t;
+
+/* RMS noise of one 1x conversion, in ADC counts. Oversampling averages it
+ * down and the IIR filter smooths T and P, as on the chip. Zero by default. */
+typedef struct {
+    float temp_adc;
+    float pres_adc;
+    float hum_adc;
+} bme68x_emu_noise_t;
+
+typedef struct {
+    uint32_t reads;
+    uint32_t writes;
+    uint32_t bytes_read;
+    uint32_t bytes_written;
+    uint32_t injected_errors;
+    uint32_t conversions;     // completed TPH(+gas) cycles
+    uint32_t stale_reads;     // field data (not status) read before the conversion finished
+} bme68x_emu_stats_t;
+
+typedef struct {
+    uint8_t regs[256];
+    bme68x_emu_calib_t calib;
+    uint8_t variant_id;
+
+    bme68x_emu_tph_t tph;
+    bme68x_emu_gas_t gas[BME68X_EMU_MAX_STEPS];
+    bme68x_emu_noise_t noise;
+    uint64_t rng;
+    bool filt_valid;
+    double filt_temp;
+    double filt_pres;
+
+    /* Time source in us. NULL uses `own_time_us`, advanced by delay_us. */
+    uint64_t (*now_us)(void);
+    uint64_t own_time_us;
+
+    /* Conversion in progress */
+    bool converting;
+    uint8_t mode;
+    uint64_t conv_start_us;
+    uint64_t conv_end_us;
+    uint8_t next_field;
+    uint8_t meas_index;
+    uint8_t step;          // parallel mode: current heater profile step
+    uint8_t step_cycle;    // parallel mode: cycles spent in `step`
+
+    /* Error injection */
+    uint32_t fail_after;   // successful transactions before failing
+    uint32_t fail_count;   // transactions to fail once triggered
+
+    bme68x_emu_stats_t stats;
+} bme68x_emu_t;
+
+/* Calibration of a typical unit; usable as-is. */
+extern const bme68x_emu_calib_t bme68x_emu_default_calib;
+
+/* Powers the emulator up with `calib` (NULL = default) as a BME688. */
+void bme68x_emu_init(bme68x_emu_t *emu, const bme68x_emu_calib_t *calib);
+
+/* Soft reset: registers back to power-on values, NVM reloaded. */
+void bme68x_emu_reset(bme68x_emu_t *emu);
+
+/* Wires `dev` to the emulator over the I2C register protocol. */
+void bme68x_emu_attach(bme68x_emu_t *emu, struct bme68x_dev *dev);
+
+/* Answers host I2C transfers to `addr` (see driver/i2c_master.h) and
+ * takes time from the host virtual clock. */
+int bme68x_emu_register_i2c(bme68x_emu_t *emu, uint16_t addr);
+
+void bme68x_emu_set_tph(bme68x_emu_t *emu, const bme68x_emu_tph_t *tph);
+void bme68x_emu_set_gas(bme68x_emu_t *emu, uint8_t step, const bme68x_emu_gas_t *gas);
+void bme68x_emu_set_noise(bme68x_emu_t *emu, const bme68x_emu_noise_t *noise);
+
+/* After `after` more good transactions, fail the next `count`. */
+void bme68x_emu_inject_bus_errors(bme68x_emu_t *emu, uint32_t after, uint32_t count);
+
+/* Duration of one conversion with the current register settings, us. */
+uint32_t bme68x_emu_conversion_us(const bme68x_emu_t *emu);
+
+/* bme68x_dev callbacks; intf_ptr must be the bme68x_emu_t. */
+int8_t bme68x_emu_read(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, void *intf_ptr);
+int8_t bme68x_emu_write(uint8_t reg_addr, const uint8_t *reg_data, uint32_t len, void *intf_ptr);
+void bme68x_emu_delay_us(uint32_t period, void *intf_ptr);
+
+#endif // BME68X_EMU_H
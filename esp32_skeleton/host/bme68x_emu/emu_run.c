@@ -0,0 +1,263 @@
+// emu_run.c - drives the BME688 driver against the register-level emulator
+//
+// Runs the satellite's BME688 sampling flow (init, forced-mode T/P/H reads,
+// gas scan) through the unmodified components/bme688 code, i2c_bus and the
+// host I2C stand-in, then checks that i2c_bus retries short bus glitches and
+// that the driver reports persistent failures. For each
+// step it reports virtual time (what the ESP32 would spend waiting), I2C
+// traffic, and host CPU time.
+//
+// Usage: bme68x_emu_run
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "bme688.h"
+#include "bme688_gas_scan.h"
+#include "bme68x_emu.h"
+#include "driver/i2c_master.h"
+#include "freertos/FreeRTOS.h"
+#include "host_clock.h"
+#include "i2c_bus.h"
+
+#define BME688_ADDR 0x77
+
+static int failures;
+
+#define CHECK(cond, ...)                          \
+    do {                                          \
+        if (!(cond)) {                            \
+            printf("FAIL: " __VA_ARGS__);         \
+            printf("\n");                         \
+            failures++;                           \
+        }                                         \
+    } while (0)
+
+typedef struct {
+    uint64_t virt_us;
+    uint64_t host_ns;
+    host_i2c_stats_t i2c;
+    bme68x_emu_stats_t emu;
+} step_mark_t;
+
+static uint64_t host_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void mark(step_mark_t *m, const bme68x_emu_t *emu)
+{
+    m->virt_us = host_clock_now_us();
+    m->host_ns = host_ns();
+    host_i2c_get_stats(&m->i2c);
+    m->emu = emu->stats;
+}
+
+static void report(const char *name, const step_mark_t *a, const bme68x_emu_t *emu)
+{
+    step_mark_t b;
+    mark(&b, emu);
+    printf("%-22s %9.1f ms %5u xfers %6u B %7.2f ms bus %3u conv %3u stale %8.1f us host\n",
+           name,
+           (b.virt_us - a->virt_us) / 1000.0,
+           b.i2c.transfers - a->i2c.transfers,
+           (b.i2c.bytes_written - a->i2c.bytes_written) + (b.i2c.bytes_read - a->i2c.bytes_read),
+           (b.i2c.bus_time_us - a->i2c.bus_time_us) / 1000.0,
+           b.emu.conversions - a->emu.conversions,
+           b.emu.stale_reads - a->emu.stale_reads,
+           (b.host_ns - a->host_ns) / 1000.0);
+}
+
+// Reference reading straight through the Bosch API, emulator attached
+// directly; the driver path must return the same numbers.
+static void reference_read(const bme68x_emu_tph_t *tph, const struct bme68x_conf *driver_conf,
+                           struct bme68x_data *out)
+{
+    bme68x_emu_t emu;
+    struct bme68x_dev dev;
+    struct bme68x_conf conf = *driver_conf;
+    uint8_t n = 0;
+
+    bme68x_emu_init(&emu, NULL);
+    bme68x_emu_set_tph(&emu, tph);
+    memset(&dev, 0, sizeof(dev));
+    bme68x_emu_attach(&emu, &dev);
+
+    CHECK(bme68x_init(&dev) == BME68X_OK, "reference bme68x_init");
+    CHECK(bme68x_set_conf(&conf, &dev) == BME68X_OK, "reference set_conf");
+    CHECK(bme68x_set_op_mode(BME68X_FORCED_MODE, &dev) == BME68X_OK, "reference forced mode");
+    dev.delay_us(bme68x_emu_conversion_us(&emu), dev.intf_ptr);
+    CHECK(bme68x_get_data(BME68X_FORCED_MODE, out, &n, &dev) == BME68X_OK && n == 1, "reference get_data");
+}
+
+int main(void)
+{
+    static bme68x_emu_t emu;
+    struct bme68x_dev bme;
+    struct bme68x_data data;
+    step_mark_t m;
+    float temp = 0, pres = 0, hum = 0, gas = 0;
+
+    host_clock_reset();
+    bme68x_emu_init(&emu, NULL);
+    bme68x_emu_register_i2c(&emu, BME688_ADDR);
+
+    i2c_master_bus_config_t bus_cfg = { .i2c_port = I2C_NUM_0, .sda_io_num = 21, .scl_io_num = 22 };
+    CHECK(i2c_bus_init(&bus_cfg) == ESP_OK, "i2c_bus_init");
+
+    printf("%-22s %12s\n", "step", "virtual");
+
+    /* --- init --- */
+    memset(&bme, 0, sizeof(bme));
+    mark(&m, &emu);
+    bme688_init(&data, &bme);
+    report("bme688_init", &m, &emu);
+    CHECK(bme.chip_id == BME68X_CHIP_ID, "chip id 0x%02X", bme.chip_id);
+    CHECK(bme.variant_id == BME68X_VARIANT_GAS_HIGH, "variant 0x%02X", (unsigned)bme.variant_id);
+    CHECK(memcmp(&bme.calib, &(struct bme68x_calib_data){ 0 }, sizeof(bme.calib)) != 0, "calibration not loaded");
+
+    /* --- forced-mode T/P/H, as periodic_sensor_task does --- */
+    mark(&m, &emu);
+    CHECK(bme688_read_temperature(&temp, &data, &bme) == BME68X_OK, "read temperature");
+    report("read_temperature", &m, &emu);
+    uint32_t forced_conv_us = bme68x_emu_conversion_us(&emu);
+    mark(&m, &emu);
+    CHECK(bme688_read_pressure(&pres, &data, &bme) == BME68X_OK, "read pressure");
+    report("read_pressure", &m, &emu);
+    // The driver's wait should cover the conversion by at most one RTOS tick.
+    // (The first read also pays for stopping the conversion bme688_init left running.)
+    CHECK(host_clock_now_us() - m.virt_us <= forced_conv_us + 1000 * portTICK_PERIOD_MS + 2000,
+          "read waited %.1f ms for a %.1f ms conversion",
+          (host_clock_now_us() - m.virt_us) / 1000.0, forced_conv_us / 1000.0);
+    mark(&m, &emu);
+    CHECK(bme688_read_humidity(&hum, &data, &bme) == BME68X_OK, "read humidity");
+    report("read_humidity", &m, &emu);
+    mark(&m, &emu);
+    CHECK(bme688_read_gas_resistance(&gas, &data, &bme) == BME68X_OK, "read gas resistance");
+    report("read_gas_resistance", &m, &emu);
+
+    struct bme68x_data ref;
+    reference_read(&emu.tph, &bme688_get_tph_setting()->conf, &ref);
+    CHECK(fabsf(temp - bme688_data_temperature(&ref)) < 0.01f, "temperature %.2f != %.2f",
+          temp, bme688_data_temperature(&ref));
+    CHECK(fabsf(pres - bme688_data_pressure(&ref)) < 1.0f, "pressure %.1f != %.1f",
+          pres, bme688_data_pressure(&ref));
+    CHECK(fabsf(hum - bme688_data_humidity(&ref)) < 0.01f, "humidity %.2f != %.2f",
+          hum, bme688_data_humidity(&ref));
+    CHECK(gas > 0.0f, "gas resistance %.0f", gas);
+    CHECK(temp > -40.0f && temp < 85.0f, "temperature %.2f out of range", temp);
+    CHECK(pres > 30000.0f && pres < 110000.0f, "pressure %.1f out of range", pres);
+    CHECK(hum > 0.0f && hum < 100.0f, "humidity %.2f out of range", hum);
+
+    /* --- gas scan: each heater step reports its own resistance --- */
+    bme688_gas_scan_config_t scan_cfg;
+    bme688_gas_scan_result_t scan;
+    bme688_gas_scan_default_config(&scan_cfg);
+    for (uint8_t i = 0; i < scan_cfg.profile_len; i++) {
+        bme68x_emu_gas_t g = { .gas_adc = (uint16_t)(300 + 100 * i), .gas_range = (uint8_t)(4 + i) };
+        bme68x_emu_set_gas(&emu, i, &g);
+    }
+    uint16_t all_steps = (uint16_t)((1u << scan_cfg.profile_len) - 1);
+    mark(&m, &emu);
+    int8_t rslt = bme688_gas_scan_run(&scan_cfg, &scan, &bme);
+    report("gas_scan_run", &m, &emu);
+    CHECK(rslt == BME68X_OK, "gas scan %d", rslt);
+    CHECK(scan.steps_valid == all_steps, "gas scan steps 0x%03X", scan.steps_valid);
+    float iaq = scan.iaq;
+    for (uint8_t i = 1; i < scan_cfg.profile_len; i++) {
+        CHECK(scan.gas_res[i] != scan.gas_res[i - 1], "gas steps %u/%u not distinguished", i - 1, i);
+    }
+    CHECK((emu.regs[BME68X_REG_CTRL_MEAS] & BME68X_MODE_MSK) == BME68X_SLEEP_MODE,
+          "gas scan left the sensor out of sleep mode");
+    mark(&m, &emu);
+    CHECK(bme688_read_temperature(&temp, &data, &bme) == BME68X_OK, "read after gas scan");
+    report("read_temperature", &m, &emu);
+
+    /* --- bus errors: i2c_bus retries a short glitch --- */
+    i2c_bus_stats_t bus_before, bus_after;
+    i2c_bus_get_stats(&bus_before);
+    bme68x_emu_inject_bus_errors(&emu, 1, I2C_BUS_RETRIES);
+    mark(&m, &emu);
+    CHECK(bme688_read_temperature(&temp, &data, &bme) == BME68X_OK, "read with retried bus errors");
+    report("read (retried)", &m, &emu);
+    i2c_bus_get_stats(&bus_after);
+    CHECK(bus_after.retries - bus_before.retries == I2C_BUS_RETRIES && bus_after.errors == bus_before.errors,
+          "%u retries, %u errors for %d glitches", bus_after.retries - bus_before.retries,
+          bus_after.errors - bus_before.errors, I2C_BUS_RETRIES);
+
+    /* --- persistent bus errors: the driver reports them and recovers --- */
+    bme68x_emu_inject_bus_errors(&emu, 1, I2C_BUS_RETRIES + 1);
+    mark(&m, &emu);
+    rslt = bme688_read_temperature(&temp, &data, &bme);
+    report("read (bus error)", &m, &emu);
+    CHECK(rslt < 0, "injected bus error returned %d", rslt);
+    bme68x_emu_inject_bus_errors(&emu, 0, I2C_BUS_RETRIES + 1);
+    rslt = bme688_gas_scan_run(&scan_cfg, &scan, &bme);
+    CHECK(rslt < 0, "gas scan with bus error returned %d", rslt);
+    mark(&m, &emu);
+    CHECK(bme688_read_temperature(&temp, &data, &bme) == BME68X_OK, "read after bus errors");
+    report("read (recovered)", &m, &emu);
+
+    /* --- oversampling/filter profiles: measured conversion time and noise --- */
+    static const uint8_t os_samples[] = { 0, 1, 2, 4, 8, 16 };
+    static const uint8_t filter_coeff[] = { 0, 1, 3, 7, 15, 31, 63, 127 };
+    static const char *profile_names[BME688_PROFILE_COUNT] = { "low_power", "balanced", "precision" };
+    bme68x_emu_noise_t noise = { .temp_adc = 16.0f, .pres_adc = 16.0f, .hum_adc = 3.0f };
+    bme68x_emu_set_noise(&emu, &noise);
+    printf("\n%-10s %-15s %9s %9s %9s   %-24s %s\n", "profile", "os T/P/H filt", "meas ms",
+           "conv ms", "model ms", "model rms T/P/H", "measured rms T/P/H");
+    float pres_rms[BME688_PROFILE_COUNT];
+    for (int p = 0; p < BME688_PROFILE_COUNT; p++) {
+        bme688_tph_stats_t st;
+        CHECK(bme688_set_profile((bme688_profile_t)p, &bme) == BME68X_OK, "profile %d", p);
+        const bme688_tph_setting_t *set = bme688_get_tph_setting();
+        // Let the IIR filter settle before measuring its output noise
+        bme688_read_pressure(&pres, &data, &bme);
+        CHECK(bme688_characterize(48, &st, &data, &bme) == BME68X_OK, "characterize profile %d", p);
+        uint32_t model_us = set->meas_dur_us + BME688_FORCED_HEATR_DUR * 1000;
+        printf("%-10s %2u/%2u/%2u %-6u %9.2f %9.2f %9.2f   %.4f/%.2f/%.3f  %.4f/%.2f/%.3f\n",
+               profile_names[p], os_samples[set->conf.os_temp], os_samples[set->conf.os_pres],
+               os_samples[set->conf.os_hum], filter_coeff[set->conf.filter],
+               set->meas_dur_us / 1000.0, st.conv_us_mean / 1000.0, model_us / 1000.0,
+               set->noise.temp, set->noise.pres, set->noise.hum,
+               sqrtf(st.variance.temp), sqrtf(st.variance.pres), sqrtf(st.variance.hum));
+        CHECK(st.conv_us_mean >= model_us && st.conv_us_mean <= model_us + 1000,
+              "profile %d: measured %u us vs model %u us", p, st.conv_us_mean, model_us);
+        pres_rms[p] = sqrtf(st.variance.pres);
+    }
+    CHECK(pres_rms[BME688_PROFILE_PRECISION] < pres_rms[BME688_PROFILE_BALANCED] &&
+          pres_rms[BME688_PROFILE_BALANCED] < pres_rms[BME688_PROFILE_LOW_POWER],
+          "pressure noise does not fall with the profile");
+    memset(&noise, 0, sizeof(noise));
+    bme68x_emu_set_noise(&emu, &noise);
+
+    /* --- soft reset brings back NVM and IDs --- */
+    CHECK(bme68x_soft_reset(&bme) == BME68X_OK, "soft reset");
+    uint8_t chip_id = 0;
+    CHECK(bme68x_get_regs(BME68X_REG_CHIP_ID, &chip_id, 1, &bme) == BME68X_OK &&
+          chip_id == BME68X_CHIP_ID, "chip id after reset 0x%02X", chip_id);
+
+    host_i2c_stats_t total;
+    host_i2c_get_stats(&total);
+    i2c_bus_stats_t bus;
+    i2c_bus_get_stats(&bus);
+    printf("\nT %.2f degC  P %.1f Pa  H %.2f %%RH  gas %.0f ohm  aqi %.0f\n",
+           temp, pres, hum, gas, iaq);
+    printf("forced conversion %.1f ms; I2C %u transfers, %u nacks, %.2f ms bus; "
+           "emulator %u conversions, %u stale reads, %u injected errors\n",
+           forced_conv_us / 1000.0, total.transfers, total.nacks,
+           total.bus_time_us / 1000.0, emu.stats.conversions, emu.stats.stale_reads,
+           emu.stats.injected_errors);
+    printf("i2c_bus %u transfers, %u errors, %u retries, busy %.2f ms of %.1f ms (%.1f %%)\n",
+           bus.transfers, bus.errors, bus.retries, bus.busy_us / 1000.0, bus.elapsed_us / 1000.0,
+           bus.elapsed_us ? 100.0 * bus.busy_us / bus.elapsed_us : 0.0);
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
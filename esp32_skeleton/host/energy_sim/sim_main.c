@@ -0,0 +1,336 @@
+// sim_main.c - what-if battery life for satellite configurations
+//
+// Replays the satellite's wake schedule (per-sensor periods on a grid,
+// sends every send period unless the readings are unchanged, at least 1 s
+// of sleep) for a number of days and
+// prices every wake with components/energy_model. Prints the firmware
+// defaults and, when options are given, the modified scenario next to them.
+//
+// Usage: energy_sim [key=value ...]   (energy_sim help lists the keys)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "energy_model.h"
+
+enum { S_AIR, S_GAS, S_UV, S_SOIL, S_ANALOG, S_COUNT };
+
+typedef struct {
+    energy_model_config_t em;
+    float period_s[S_COUNT];    // as in satellite_main.c sched_sensors
+    float acq_ms[S_COUNT];      // conversion time of each sensor
+    float send_s;
+    float frame_bytes;          // typical data frame
+    float retries;              // resends per data frame
+    float unchanged;            // share of due sends skipped as unchanged (send-on-delta)
+    float silence_s;            // longest silence before a send is forced
+    float pm;                   // 1 = automatic light sleep in the wake's waits (power_mgmt)
+    float days;
+    // Fixed wake phases (ms); wp= replaces them with a measured send wake
+    float boot_ms, init_ms, uart_ms, lora_reset_ms, lora_setup_ms;
+    float handshake_ms, encode_ms, ack_ms, sleep_entry_ms;
+    float handshake_wait_ms;    // turnaround on top of the airtimes
+} sim_config_t;
+
+typedef struct {
+    energy_breakdown_t sum;
+    double days;
+    unsigned wakes, sends;
+} sim_result_t;
+
+#define BOOT_MSG_BYTES 17 // "SATELLITE_BOOT_OK"
+#define ACK_MSG_BYTES  11 // "MM_ACK_BOOT", "MM_ACK_DATA"
+
+// Waits that light-sleep with power management: the post-send delay only,
+// since the UART lock is held from radio_up() to the end of send_window().
+// Of the acquisition, only the I2C/1-Wire traffic keeps the CPU up (the
+// RMT channels are enabled per 1-Wire transaction, see onewire_rmt.c).
+#define POST_SEND_WAIT_MS 500
+#define ACQ_BUS_MS        10
+
+static void default_config(sim_config_t *c)
+{
+    memset(c, 0, sizeof(*c));
+    energy_model_default_config(&c->em);
+    const float period_s[S_COUNT] = { 300, 1800, 300, 1800, 600 };
+    // TPH + 100 ms heater; 17 gas cycles of ~140 ms; 64 ms integration;
+    // 12-bit conversion, already running since init; ADC burst
+    const float acq_ms[S_COUNT] = { 180, 2400, 70, 700, 20 };
+    memcpy(c->period_s, period_s, sizeof(period_s));
+    memcpy(c->acq_ms, acq_ms, sizeof(acq_ms));
+    c->send_s = 1800;
+    c->frame_bytes = 190;
+    c->silence_s = 3 * 3600;
+    c->pm = 1;
+    c->days = 7;
+    c->boot_ms = 30;
+    c->init_ms = 60;
+    c->uart_ms = 1;
+    c->lora_reset_ms = 1600;     // NRST pulse, boot wait, settle delay
+    c->lora_setup_ms = 5500;     // 5 AT commands, each read times out at 1 s
+    c->encode_ms = 5;
+    c->sleep_entry_ms = 510;     // post-send delay + UART drain
+    c->handshake_wait_ms = 100;
+}
+
+typedef struct {
+    const char *key;
+    float *val;
+    const char *help;
+} sim_option_t;
+
+static float s_sf, s_bw_khz, s_cr, s_preamble, s_boot_us_ms;
+
+static int parse_options(sim_config_t *c, int argc, char **argv, int print_help)
+{
+    s_sf = c->em.sf;
+    s_bw_khz = c->em.bw_hz / 1000.0f;
+    s_cr = c->em.cr;
+    s_preamble = c->em.preamble;
+    s_boot_us_ms = c->em.boot_us / 1000.0f;
+    const sim_option_t opts[] = {
+        { "cpu_ma", &c->em.cpu_active_ma, "ESP32 awake" },
+        { "light_ma", &c->em.light_sleep_ma, "ESP32 in light sleep during a wake" },
+        { "pm", &c->pm, "1 = light sleep in the wake's waits, 0 = CPU up throughout" },
+        { "sleep_ua", &c->em.sleep_ua, "deep sleep, board total" },
+        { "sensor_ma", &c->em.sensor_ma, "sensors converting" },
+        { "heater_ma", &c->em.heater_ma, "BME688 gas heater" },
+        { "tx_ma", &c->em.radio_tx_ma, "LoRa transmitting" },
+        { "rx_ma", &c->em.radio_rx_ma, "LoRa listening on a send wake" },
+        { "idle_ma", &c->em.radio_idle_ma, "LoRa between wakes (module sleep current if put in AT+MODE=1)" },
+        { "rom_boot_ms", &s_boot_us_ms, "ROM + bootloader before esp_timer" },
+        { "sf", &s_sf, "spreading factor" },
+        { "bw_khz", &s_bw_khz, "bandwidth" },
+        { "cr", &s_cr, "coding rate 4/(4+cr)" },
+        { "preamble", &s_preamble, "preamble symbols" },
+        { "capacity_mah", &c->em.capacity_mah, "battery capacity" },
+        { "usable", &c->em.usable_frac, "usable share of the capacity" },
+        { "harvest_mah", &c->em.harvest_mah_day, "solar charge per day" },
+        { "send_s", &c->send_s, "send period" },
+        { "air_s", &c->period_s[S_AIR], "BME688 T/H/P period" },
+        { "gas_s", &c->period_s[S_GAS], "BME688 gas scan period" },
+        { "uv_s", &c->period_s[S_UV], "AS7331 period" },
+        { "soil_s", &c->period_s[S_SOIL], "DS18B20 period" },
+        { "analog_s", &c->period_s[S_ANALOG], "rain plate + soil moisture period" },
+        { "air_ms", &c->acq_ms[S_AIR], "T/H/P conversion" },
+        { "gas_ms", &c->acq_ms[S_GAS], "gas scan" },
+        { "uv_ms", &c->acq_ms[S_UV], "UV conversion" },
+        { "soil_ms", &c->acq_ms[S_SOIL], "soil probe conversion" },
+        { "analog_ms", &c->acq_ms[S_ANALOG], "ADC burst" },
+        { "frame_bytes", &c->frame_bytes, "data frame payload" },
+        { "retries", &c->retries, "resends per data frame" },
+        { "unchanged", &c->unchanged, "share of due sends skipped as unchanged, 0-1" },
+        { "silence_s", &c->silence_s, "longest silence before a send is forced" },
+        { "lora_setup_ms", &c->lora_setup_ms, "AT setup" },
+        { "lora_reset_ms", &c->lora_reset_ms, "module reset" },
+        { "days", &c->days, "simulated days" },
+    };
+    const int n_opts = sizeof(opts) / sizeof(opts[0]);
+
+    if (print_help) {
+        printf("usage: energy_sim [key=value ...]\n");
+        printf("  %-14s measured send wake \"wp\" array from telemetry (ms, comma separated)\n", "wp");
+        for (int i = 0; i < n_opts; i++) {
+            printf("  %-14s %s (default %g)\n", opts[i].key, opts[i].help, *opts[i].val);
+        }
+        return 0;
+    }
+
+    for (int a = 1; a < argc; a++) {
+        const char *eq = strchr(argv[a], '=');
+        if (!eq) {
+            fprintf(stderr, "bad option '%s' (try: energy_sim help)\n", argv[a]);
+            return -1;
+        }
+        size_t klen = (size_t)(eq - argv[a]);
+        if (klen == 2 && strncmp(argv[a], "wp", 2) == 0) {
+            // total,boot,init,uart,lora_reset,lora_setup,handshake,acquire,encode,tx,ack,sleep
+            float v[12];
+            int n = 0;
+            char *p = (char *)eq + 1;
+            while (n < 12 && *p) {
+                v[n++] = strtof(p, &p);
+                if (*p == ',') p++;
+            }
+            if (n != 12) {
+                fprintf(stderr, "wp needs the 12 values of a send wake's \"wp\" array\n");
+                return -1;
+            }
+            c->boot_ms = v[1];
+            c->init_ms = v[2];
+            c->uart_ms = v[3];
+            c->lora_reset_ms = v[4];
+            c->lora_setup_ms = v[5];
+            c->handshake_ms = v[6]; // measured, airtime included
+            c->encode_ms = v[8];
+            c->ack_ms = v[9] + v[10];
+            c->sleep_entry_ms = v[11];
+            continue;
+        }
+        int i;
+        for (i = 0; i < n_opts; i++) {
+            if (strlen(opts[i].key) == klen && strncmp(argv[a], opts[i].key, klen) == 0) break;
+        }
+        if (i == n_opts) {
+            fprintf(stderr, "unknown key '%.*s' (try: energy_sim help)\n", (int)klen, argv[a]);
+            return -1;
+        }
+        *opts[i].val = strtof(eq + 1, NULL);
+    }
+    c->em.sf = (uint8_t)s_sf;
+    c->em.bw_hz = (uint32_t)(s_bw_khz * 1000.0f);
+    c->em.cr = (uint8_t)s_cr;
+    c->em.preamble = (uint16_t)s_preamble;
+    c->em.boot_us = (uint32_t)(s_boot_us_ms * 1000.0f);
+    if (c->em.sf < 7 || c->em.sf > 12 || c->em.cr < 1 || c->em.cr > 4 || c->em.bw_hz == 0 ||
+        c->send_s < 1 || c->days <= 0 || c->unchanged < 0 || c->unchanged > 1) {
+        fprintf(stderr, "out of range: sf 7-12, cr 1-4, bw_khz > 0, send_s >= 1, days > 0, "
+                        "unchanged 0-1\n");
+        return -1;
+    }
+    return 1;
+}
+
+static void add(energy_breakdown_t *sum, const energy_breakdown_t *b)
+{
+    sum->cpu_uah += b->cpu_uah;
+    sum->sensor_uah += b->sensor_uah;
+    sum->heater_uah += b->heater_uah;
+    sum->tx_uah += b->tx_uah;
+    sum->rx_uah += b->rx_uah;
+    sum->idle_uah += b->idle_uah;
+    sum->sleep_uah += b->sleep_uah;
+    sum->total_uah += b->total_uah;
+    sum->period_us += b->period_us;
+}
+
+// Next slot of `period` after `t` on the period grid (missed slots skipped,
+// as sensor_sched_sampled() does).
+static double next_slot(double t, double period)
+{
+    return ((long long)(t / period) + 1) * period;
+}
+
+static void simulate(const sim_config_t *c, sim_result_t *r)
+{
+    const double end_s = c->days * 86400.0;
+    double next_due[S_COUNT] = { 0 };
+    double next_send = c->send_s;
+    double t = 0, delivered = 0, skip_acc = 0;
+    memset(r, 0, sizeof(*r));
+
+    uint32_t frame_air = energy_model_airtime_us(&c->em, (uint32_t)c->frame_bytes);
+    uint32_t ack_air = energy_model_airtime_us(&c->em, ACK_MSG_BYTES);
+    double handshake_ms = c->handshake_ms > 0 ? c->handshake_ms :
+        (energy_model_airtime_us(&c->em, BOOT_MSG_BYTES) + ack_air) / 1000.0 + c->handshake_wait_ms;
+    double ack_ms = c->ack_ms > 0 ? c->ack_ms :
+        (1 + c->retries) * (frame_air + ack_air) / 1000.0 + c->handshake_wait_ms;
+
+    while (t < end_s) {
+        bool send = t >= next_send;
+        double acquire_ms = 0, heater_ms = 0;
+        for (int i = 0; i < S_COUNT; i++) {
+            if (t < next_due[i]) continue;
+            if (c->acq_ms[i] > acquire_ms) acquire_ms = c->acq_ms[i]; // overlapped
+            if (i == S_GAS) heater_ms += c->acq_ms[i];
+            if (i == S_AIR) heater_ms += 100;
+            next_due[i] = next_slot(t, c->period_s[i]);
+        }
+        if (send) {
+            next_send = next_slot(t, c->send_s);
+            // Spread the unchanged share evenly over the due sends
+            skip_acc += c->unchanged;
+            if (skip_acc >= 1 && t - delivered < c->silence_s) {
+                skip_acc -= 1;
+                send = false;
+            }
+        }
+        double radio_ms = 0;
+        energy_cycle_t cyc = { 0 };
+        if (send) {
+            // The radio comes up after sampling, so the acquisition is not in its window
+            radio_ms = c->lora_reset_ms + c->lora_setup_ms + handshake_ms +
+                       c->encode_ms + ack_ms + c->sleep_entry_ms;
+            cyc.tx_frames = (uint16_t)(2 + c->retries);
+            cyc.tx_bytes = BOOT_MSG_BYTES + (uint32_t)((1 + c->retries) * c->frame_bytes);
+            delivered = t;
+            r->sends++;
+        }
+        double active_ms = c->boot_ms + c->init_ms + acquire_ms + 5; // 5 ms sleep entry
+        if (send) active_ms = c->boot_ms + c->init_ms + acquire_ms + c->uart_ms + radio_ms;
+
+        double next = next_send;
+        for (int i = 0; i < S_COUNT; i++) {
+            if (next_due[i] < next) next = next_due[i];
+        }
+        double light_ms = 0;
+        if (c->pm) {
+            light_ms = acquire_ms > ACQ_BUS_MS ? acquire_ms - ACQ_BUS_MS : 0;
+            if (send) light_ms += POST_SEND_WAIT_MS;
+        }
+
+        double wake_end = t + (active_ms + c->em.boot_us / 1000.0) / 1000.0;
+        double sleep_s = next - wake_end;
+        if (sleep_s < 1) sleep_s = 1;
+
+        cyc.active_us = (uint32_t)(active_ms * 1000);
+        cyc.light_sleep_us = (uint32_t)(light_ms * 1000);
+        cyc.sensor_us = (uint32_t)(acquire_ms * 1000);
+        cyc.heater_us = (uint32_t)(heater_ms * 1000);
+        cyc.radio_us = (uint32_t)(radio_ms * 1000);
+        cyc.sleep_us = (uint64_t)(sleep_s * 1e6);
+        energy_breakdown_t b;
+        energy_model_cycle(&c->em, &cyc, &b);
+        add(&r->sum, &b);
+        r->wakes++;
+        t = wake_end + sleep_s;
+    }
+    r->days = t / 86400.0;
+}
+
+static void print_result(const char *name, const sim_config_t *c, const sim_result_t *r)
+{
+    const energy_breakdown_t *s = &r->sum;
+    double per_day = 1.0 / r->days / 1000.0; // µAh total -> mAh/day
+    float avg_ua = (float)(s->total_uah * 3.6e9 / (double)s->period_us);
+    float life = energy_model_life_days(&c->em, avg_ua);
+    printf("%-9s %7.0f %7.0f %9.1f %8.0f ", name, r->wakes / r->days, r->sends / r->days,
+           s->total_uah * per_day, avg_ua);
+    if (life < 0) printf("%8s", "neutral");
+    else printf("%8.1f", life);
+    printf(" | %7.2f %7.2f %7.2f %7.2f %7.2f %7.2f %7.2f\n",
+           s->cpu_uah * per_day, s->sensor_uah * per_day, s->heater_uah * per_day,
+           s->tx_uah * per_day, s->rx_uah * per_day, s->idle_uah * per_day, s->sleep_uah * per_day);
+}
+
+int main(int argc, char **argv)
+{
+    sim_config_t base, what_if;
+    default_config(&base);
+    default_config(&what_if);
+    if (argc == 2 && (strcmp(argv[1], "help") == 0 || strcmp(argv[1], "-h") == 0)) {
+        parse_options(&what_if, argc, argv, 1);
+        return 0;
+    }
+    if (parse_options(&what_if, argc, argv, 0) < 0) return 2;
+
+    printf("airtime: %u B frame %.0f ms, ACK %.0f ms (SF%u, %lu kHz, CR 4/%u)\n",
+           (unsigned)what_if.frame_bytes,
+           energy_model_airtime_us(&what_if.em, (uint32_t)what_if.frame_bytes) / 1000.0,
+           energy_model_airtime_us(&what_if.em, ACK_MSG_BYTES) / 1000.0,
+           what_if.em.sf, (unsigned long)(what_if.em.bw_hz / 1000), 4 + what_if.em.cr);
+    printf("%-9s %7s %7s %9s %8s %8s | %-55s\n", "", "wakes/d", "sends/d", "mAh/day", "avg uA",
+           "life d", "mAh/day: cpu  sensors heater  tx      rx      r.idle  sleep");
+
+    sim_result_t r;
+    simulate(&base, &r);
+    print_result("defaults", &base, &r);
+    if (argc > 1) {
+        sim_result_t w;
+        simulate(&what_if, &w);
+        print_result("what-if", &what_if, &w);
+        double d = w.sum.total_uah / w.days - r.sum.total_uah / r.days;
+        printf("what-if changes consumption by %+.1f mAh/day (%+.0f%%)\n",
+               d / 1000.0, 100.0 * d / (r.sum.total_uah / r.days));
+    }
+    return 0;
+}
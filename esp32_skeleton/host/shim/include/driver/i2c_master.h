@@ -0,0 +1,71 @@
+// i2c_master.h - host stand-in for the ESP-IDF I2C master driver
+//
+// Devices added to a bus are routed to targets registered with
+// host_i2c_register_target(), typically a register-level emulator.
+#ifndef HOST_I2C_MASTER_H
+#define HOST_I2C_MASTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef enum { I2C_NUM_0, I2C_NUM_1 } i2c_port_num_t;
+typedef enum { I2C_ADDR_BIT_LEN_7, I2C_ADDR_BIT_LEN_10 } i2c_addr_bit_len_t;
+typedef enum { I2C_CLK_SRC_DEFAULT } i2c_clock_source_t;
+
+typedef struct {
+    i2c_port_num_t i2c_port;
+    int sda_io_num;
+    int scl_io_num;
+    i2c_clock_source_t clk_source;
+    uint8_t glitch_ignore_cnt;
+    struct {
+        uint32_t enable_internal_pullup : 1;
+    } flags;
+} i2c_master_bus_config_t;
+
+typedef struct {
+    i2c_addr_bit_len_t dev_addr_length;
+    uint16_t device_address;
+    uint32_t scl_speed_hz;
+} i2c_device_config_t;
+
+typedef struct host_i2c_bus *i2c_master_bus_handle_t;
+typedef struct host_i2c_dev *i2c_master_dev_handle_t;
+
+esp_err_t i2c_new_master_bus(const i2c_master_bus_config_t *cfg, i2c_master_bus_handle_t *ret_bus);
+esp_err_t i2c_master_bus_add_device(i2c_master_bus_handle_t bus, const i2c_device_config_t *cfg,
+                                    i2c_master_dev_handle_t *ret_dev);
+esp_err_t i2c_master_bus_rm_device(i2c_master_dev_handle_t dev);
+esp_err_t i2c_master_bus_reset(i2c_master_bus_handle_t bus);
+esp_err_t i2c_master_transmit(i2c_master_dev_handle_t dev, const uint8_t *buf, size_t len, int timeout_ms);
+esp_err_t i2c_master_receive(i2c_master_dev_handle_t dev, uint8_t *buf, size_t len, int timeout_ms);
+esp_err_t i2c_master_transmit_receive(i2c_master_dev_handle_t dev, const uint8_t *wbuf, size_t wlen,
+                                      uint8_t *rbuf, size_t rlen, int timeout_ms);
+
+/* Host-only: a target answers transfers addressed to `addr`. `write` gets
+ * the raw bytes the master sent (register pointer first); `read` gets the
+ * bytes written just before (may be empty) and fills `rbuf`. Return 0 to
+ * ACK, non-zero to NACK. */
+typedef struct {
+    int (*write)(void *ctx, const uint8_t *buf, size_t len);
+    int (*read)(void *ctx, const uint8_t *wbuf, size_t wlen, uint8_t *rbuf, size_t rlen);
+    void *ctx;
+} host_i2c_target_t;
+
+esp_err_t host_i2c_register_target(uint16_t addr, const host_i2c_target_t *target);
+void host_i2c_clear_targets(void);
+
+/* Host-only: counters for every transfer routed through the stand-in. */
+typedef struct {
+    uint32_t transfers;
+    uint32_t bytes_written;
+    uint32_t bytes_read;
+    uint32_t nacks;
+    uint64_t bus_time_us; // SCL time at each device's configured clock
+} host_i2c_stats_t;
+
+void host_i2c_get_stats(host_i2c_stats_t *stats);
+void host_i2c_reset_stats(void);
+
+#endif // HOST_I2C_MASTER_H
@@ -0,0 +1,9 @@
+// esp_attr.h - host stand-in; memory placement attributes are no-ops
+#ifndef HOST_ESP_ATTR_H
+#define HOST_ESP_ATTR_H
+
+#define IRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+
+#endif // HOST_ESP_ATTR_H
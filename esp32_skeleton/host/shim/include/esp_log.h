@@ -0,0 +1,33 @@
+// esp_log.h - host stand-in for ESP-IDF logging
+#ifndef HOST_ESP_LOG_H
+#define HOST_ESP_LOG_H
+
+#include <stdio.h>
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE
+} esp_log_level_t;
+
+/* Only the "*" wildcard is honoured; per-tag levels are ignored so a
+ * driver raising its own tag to DEBUG does not flood host runs. */
+void esp_log_level_set(const char *tag, esp_log_level_t level);
+esp_log_level_t host_log_level(void);
+
+#define HOST_LOG(level, letter, tag, fmt, ...) do {                           \
+        if (host_log_level() >= (level)) {                                    \
+            printf(letter " (%s) " fmt "\n", tag, ##__VA_ARGS__);             \
+        }                                                                     \
+    } while (0)
+
+#define ESP_LOGE(tag, fmt, ...) HOST_LOG(ESP_LOG_ERROR, "E", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) HOST_LOG(ESP_LOG_WARN, "W", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) HOST_LOG(ESP_LOG_INFO, "I", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...) HOST_LOG(ESP_LOG_DEBUG, "D", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGV(tag, fmt, ...) HOST_LOG(ESP_LOG_VERBOSE, "V", tag, fmt, ##__VA_ARGS__)
+
+#endif // HOST_ESP_LOG_H
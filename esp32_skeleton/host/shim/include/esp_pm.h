@@ -0,0 +1,8 @@
+// esp_pm.h - host stand-in; power management is off (see sdkconfig.h),
+// so only the header has to exist
+#ifndef HOST_ESP_PM_H
+#define HOST_ESP_PM_H
+
+#include "esp_err.h"
+
+#endif // HOST_ESP_PM_H
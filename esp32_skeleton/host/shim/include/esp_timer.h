@@ -0,0 +1,11 @@
+// esp_timer.h - host stand-in backed by the virtual clock
+#ifndef HOST_ESP_TIMER_H
+#define HOST_ESP_TIMER_H
+
+#include <stdint.h>
+
+/* Returns virtual microseconds. Each call advances the clock by 1 us so
+ * busy-wait loops written against the real timer still terminate. */
+int64_t esp_timer_get_time(void);
+
+#endif // HOST_ESP_TIMER_H
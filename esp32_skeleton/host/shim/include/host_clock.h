@@ -0,0 +1,11 @@
+// host_clock.h - virtual time shared by the host stand-ins and emulators
+#ifndef HOST_CLOCK_H
+#define HOST_CLOCK_H
+
+#include <stdint.h>
+
+uint64_t host_clock_now_us(void);
+void host_clock_advance_us(uint64_t us);
+void host_clock_reset(void);
+
+#endif // HOST_CLOCK_H
@@ -0,0 +1,7 @@
+// sdkconfig.h - host stand-in; no Kconfig options are set
+#ifndef HOST_SDKCONFIG_H
+#define HOST_SDKCONFIG_H
+
+// CONFIG_PM_ENABLE is off: power_mgmt builds with its locks as no-ops
+
+#endif // HOST_SDKCONFIG_H
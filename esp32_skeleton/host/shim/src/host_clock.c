@@ -0,0 +1,37 @@
+// host_clock.c - virtual time for host builds
+#include "host_clock.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static uint64_t s_now_us;
+
+uint64_t host_clock_now_us(void)
+{
+    return s_now_us;
+}
+
+void host_clock_advance_us(uint64_t us)
+{
+    s_now_us += us;
+}
+
+void host_clock_reset(void)
+{
+    s_now_us = 0;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return (int64_t)s_now_us++;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    s_now_us += (uint64_t)ticks * portTICK_PERIOD_MS * 1000;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(s_now_us / (portTICK_PERIOD_MS * 1000));
+}
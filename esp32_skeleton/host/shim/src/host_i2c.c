@@ -0,0 +1,145 @@
+// host_i2c.c - I2C master stand-in that routes transfers to host targets
+#include <stdlib.h>
+#include <string.h>
+#include "driver/i2c_master.h"
+#include "host_clock.h"
+
+#define HOST_I2C_MAX_TARGETS 8
+
+struct host_i2c_bus {
+    i2c_master_bus_config_t cfg;
+};
+
+struct host_i2c_dev {
+    struct host_i2c_bus *bus;
+    i2c_device_config_t cfg;
+};
+
+typedef struct {
+    uint16_t addr;
+    host_i2c_target_t target;
+} target_slot_t;
+
+static target_slot_t s_targets[HOST_I2C_MAX_TARGETS];
+static size_t s_n_targets;
+static host_i2c_stats_t s_stats;
+
+esp_err_t host_i2c_register_target(uint16_t addr, const host_i2c_target_t *target)
+{
+    if (!target) return ESP_ERR_INVALID_ARG;
+    for (size_t i = 0; i < s_n_targets; i++) {
+        if (s_targets[i].addr == addr) {
+            s_targets[i].target = *target;
+            return ESP_OK;
+        }
+    }
+    if (s_n_targets == HOST_I2C_MAX_TARGETS) return ESP_ERR_NO_MEM;
+    s_targets[s_n_targets].addr = addr;
+    s_targets[s_n_targets].target = *target;
+    s_n_targets++;
+    return ESP_OK;
+}
+
+void host_i2c_clear_targets(void)
+{
+    s_n_targets = 0;
+}
+
+void host_i2c_get_stats(host_i2c_stats_t *stats)
+{
+    if (stats) *stats = s_stats;
+}
+
+void host_i2c_reset_stats(void)
+{
+    memset(&s_stats, 0, sizeof(s_stats));
+}
+
+static const host_i2c_target_t *find_target(uint16_t addr)
+{
+    for (size_t i = 0; i < s_n_targets; i++) {
+        if (s_targets[i].addr == addr) return &s_targets[i].target;
+    }
+    return NULL;
+}
+
+// 9 SCL clocks per byte (8 data + ACK) plus one address byte per (re)start.
+static void account(const struct host_i2c_dev *dev, size_t wlen, size_t rlen)
+{
+    uint32_t hz = dev->cfg.scl_speed_hz ? dev->cfg.scl_speed_hz : 100000;
+    size_t frames = (wlen ? 1 + wlen : 0) + (rlen ? 1 + rlen : 0);
+    uint64_t us = ((uint64_t)frames * 9 * 1000000 + hz - 1) / hz;
+
+    s_stats.transfers++;
+    s_stats.bytes_written += wlen;
+    s_stats.bytes_read += rlen;
+    s_stats.bus_time_us += us;
+    host_clock_advance_us(us);
+}
+
+esp_err_t i2c_new_master_bus(const i2c_master_bus_config_t *cfg, i2c_master_bus_handle_t *ret_bus)
+{
+    if (!cfg || !ret_bus) return ESP_ERR_INVALID_ARG;
+    struct host_i2c_bus *bus = calloc(1, sizeof(*bus));
+    if (!bus) return ESP_ERR_NO_MEM;
+    bus->cfg = *cfg;
+    *ret_bus = bus;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_bus_add_device(i2c_master_bus_handle_t bus, const i2c_device_config_t *cfg,
+                                    i2c_master_dev_handle_t *ret_dev)
+{
+    if (!bus || !cfg || !ret_dev) return ESP_ERR_INVALID_ARG;
+    struct host_i2c_dev *dev = calloc(1, sizeof(*dev));
+    if (!dev) return ESP_ERR_NO_MEM;
+    dev->bus = bus;
+    dev->cfg = *cfg;
+    *ret_dev = dev;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_bus_rm_device(i2c_master_dev_handle_t dev)
+{
+    free(dev);
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_bus_reset(i2c_master_bus_handle_t bus)
+{
+    return bus ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t i2c_master_transmit(i2c_master_dev_handle_t dev, const uint8_t *buf, size_t len, int timeout_ms)
+{
+    (void)timeout_ms;
+    if (!dev || (!buf && len)) return ESP_ERR_INVALID_ARG;
+    account(dev, len, 0);
+
+    const host_i2c_target_t *t = find_target(dev->cfg.device_address);
+    if (!t || !t->write || t->write(t->ctx, buf, len) != 0) {
+        s_stats.nacks++;
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_receive(i2c_master_dev_handle_t dev, uint8_t *buf, size_t len, int timeout_ms)
+{
+    return i2c_master_transmit_receive(dev, NULL, 0, buf, len, timeout_ms);
+}
+
+esp_err_t i2c_master_transmit_receive(i2c_master_dev_handle_t dev, const uint8_t *wbuf, size_t wlen,
+                                      uint8_t *rbuf, size_t rlen, int timeout_ms)
+{
+    (void)timeout_ms;
+    if (!dev || (!wbuf && wlen) || !rbuf) return ESP_ERR_INVALID_ARG;
+    account(dev, wlen, rlen);
+
+    const host_i2c_target_t *t = find_target(dev->cfg.device_address);
+    if (!t || !t->read || t->read(t->ctx, wbuf, wlen, rbuf, rlen) != 0) {
+        s_stats.nacks++;
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include "esp_system.h"
 #include "nvs_flash.h"
@@ -14,6 +15,7 @@
 
 // --- Include our new common component ---
 #include "lora_comm.h" 
+#include "power_mgmt.h"
 // --- MiddleMan Specific Configuration ---
 #define MM_ADDR 1 // This MiddleMan's address
 #define SAT_ADDR 10 // This satellite's address
@@ -23,6 +25,15 @@
 // Set to 0 to build the full Wi-Fi + MQTT application
 #define LORA_TEST_ONLY 0
 
+// The MiddleMan listens on the LoRa UART all the time, so it never light-
+// sleeps; 80 MHz at idle keeps APB, and so the UART baud, fixed. Wi-Fi
+// modem sleep does the rest.
+static const power_mgmt_config_t pm_cfg = {
+    .max_mhz = 160,
+    .min_mhz = 80,
+    .light_sleep = false,
+};
+
 // List of KNOWN satellite addresses.
 // We will publish discovery topics for each of these.
 static const int KNOWN_SATELLITE_ADDRESSES[] = { 10 }; // Add more, e.g. {10, 11, 12}
@@ -121,6 +132,121 @@ void wifi_init_sta(void)
  *
  */
 
+/*
+ * --- Satellite availability (heartbeat) ---
+ *
+ * A satellite skips frames whose readings have not moved beyond their
+ * deadbands (send-on-delta), so silence means "unchanged": the last state
+ * is published retained and stays valid. Each frame carries "hb", the
+ * longest the satellite stays silent; a satellite not heard from within
+ * 1.5 x hb is reported offline on its availability topic.
+ *
+ * A frame also leaves out channels that did not fit or have no reading, so
+ * each one is merged into the satellite's last known values and the merged
+ * document is what gets published.
+ */
+#define DEFAULT_HEARTBEAT_S (4 * 3600) // until a satellite's first frame tells us
+#define MAX_SATELLITES      8
+
+static struct {
+    int addr;
+    TickType_t last_seen;
+    uint32_t heartbeat_s;
+    bool online;
+    cJSON *state;           // last known value of every key the satellite sent
+} s_heartbeat[MAX_SATELLITES];
+
+static void availability_topic(char *buf, size_t len, int sat_addr)
+{
+    snprintf(buf, len, "weather/berrystation_%d/availability", sat_addr);
+}
+
+// Discovery config with the satellite's availability topic spliced in
+// after the opening brace.
+static void publish_discovery(esp_mqtt_client_handle_t client, int sat_addr,
+                              const char *topic, const char *payload)
+{
+    char avty[96];
+    availability_topic(avty, sizeof(avty), sat_addr);
+    size_t len = strlen(payload) + strlen(avty) + 16;
+    char *buf = malloc(len);
+    if (!buf) {
+        ESP_LOGE(TAG, "No memory for discovery %s", topic);
+        return;
+    }
+    snprintf(buf, len, "{\"avty_t\": \"%s\",%s", avty, payload + 1);
+    esp_mqtt_client_publish(client, topic, buf, 0, 1, true);
+    free(buf);
+}
+
+static void set_availability(esp_mqtt_client_handle_t client, int slot, bool online)
+{
+    char topic[96];
+    availability_topic(topic, sizeof(topic), s_heartbeat[slot].addr);
+    esp_mqtt_client_publish(client, topic, online ? "online" : "offline", 0, 1, true);
+    s_heartbeat[slot].online = online;
+}
+
+static int heartbeat_slot(int sat_addr)
+{
+    for (int i = 0; i < MAX_SATELLITES; i++) {
+        if (s_heartbeat[i].addr == sat_addr) return i;
+        if (s_heartbeat[i].addr == 0) {
+            s_heartbeat[i].addr = sat_addr;
+            s_heartbeat[i].last_seen = xTaskGetTickCount();
+            s_heartbeat[i].heartbeat_s = DEFAULT_HEARTBEAT_S;
+            s_heartbeat[i].online = true; // the broker keeps the last retained state
+            return i;
+        }
+    }
+    return -1;
+}
+
+// A frame arrived: the satellite is alive and says when to expect the next.
+static void heartbeat_seen(esp_mqtt_client_handle_t client, int sat_addr, const cJSON *root)
+{
+    int slot = heartbeat_slot(sat_addr);
+    if (slot < 0) return;
+    const cJSON *hb = cJSON_GetObjectItem(root, "hb");
+    if (cJSON_IsNumber(hb) && hb->valuedouble > 0) s_heartbeat[slot].heartbeat_s = (uint32_t)hb->valuedouble;
+    s_heartbeat[slot].last_seen = xTaskGetTickCount();
+    set_availability(client, slot, true);
+}
+
+// Merges a frame into the satellite's last known values and returns the
+// merged document (cJSON_free() it), or NULL without memory.
+static char *merge_state(int sat_addr, const cJSON *frame)
+{
+    int slot = heartbeat_slot(sat_addr);
+    if (slot < 0) return cJSON_PrintUnformatted(frame); // no slot: the frame as is
+    if (!s_heartbeat[slot].state) s_heartbeat[slot].state = cJSON_CreateObject();
+    cJSON *state = s_heartbeat[slot].state;
+    if (!state) return NULL;
+    for (const cJSON *item = frame->child; item; item = item->next) {
+        cJSON *copy = cJSON_Duplicate(item, true);
+        if (!copy) continue;
+        if (cJSON_GetObjectItem(state, item->string)) {
+            cJSON_ReplaceItemInObject(state, item->string, copy);
+        } else {
+            cJSON_AddItemToObject(state, item->string, copy);
+        }
+    }
+    return cJSON_PrintUnformatted(state);
+}
+
+static void heartbeat_check(esp_mqtt_client_handle_t client)
+{
+    TickType_t now = xTaskGetTickCount();
+    for (int i = 0; i < MAX_SATELLITES && s_heartbeat[i].addr; i++) {
+        uint32_t silent_s = (now - s_heartbeat[i].last_seen) / configTICK_RATE_HZ;
+        if (s_heartbeat[i].online && silent_s > s_heartbeat[i].heartbeat_s * 3 / 2) {
+            ESP_LOGW(TAG, "Satellite %d silent for %lu s, marking offline",
+                     s_heartbeat[i].addr, (unsigned long)silent_s);
+            set_availability(client, i, false);
+        }
+    }
+}
+
 /**
  * @brief Publishes all 4 discovery messages for a single satellite.
  * This is now dynamic, based on the satellite's address.
@@ -149,14 +275,35 @@ void publish_discovery_for_satellite(esp_mqtt_client_handle_t client, int sat_ad
             "\"name\": \"%s Temperature\","
             "\"unique_id\": \"%s\","
             "\"stat_t\": \"%s\","
-            "\"val_tpl\": \"{{ value_json.t }}\","
+            "\"val_tpl\": \"{{ value_json.t if value_json.t is defined else None }}\","
             "\"unit_of_meas\": \"°C\","   // Still matching your original, even though payload is °C
             "\"dev_cla\": \"temperature\","
             "\"ic\": \"mdi:thermometer\","
             "\"dev\": {\"ids\": [\"%s\"],\"name\": \"%s\",\"mf\": \"ESAP\"}"
         "}",
         device_name, unique_id, state_topic, device_id, device_name);
-    esp_mqtt_client_publish(client, discovery_topic, discovery_payload, 0, 1, true);
+    publish_discovery(client, sat_addr, discovery_topic, discovery_payload);
+
+    // 1b. Air Temperature min / max over the reporting window (value_json.tn / tx)
+    const char *extremes[][3] = { { "tn", "min", "Min" }, { "tx", "max", "Max" } };
+    for (int i = 0; i < 2; i++) {
+        snprintf(unique_id, sizeof(unique_id), "%s_temperature_%s", device_id, extremes[i][1]);
+        snprintf(discovery_topic, sizeof(discovery_topic), "homeassistant/sensor/%s/config", unique_id);
+        snprintf(discovery_payload, sizeof(discovery_payload),
+            "{"
+                "\"name\": \"%s Temperature %s\","
+                "\"unique_id\": \"%s\","
+                "\"stat_t\": \"%s\","
+                "\"val_tpl\": \"{{ value_json.%s if value_json.%s is defined else None }}\","
+                "\"unit_of_meas\": \"°C\","
+                "\"dev_cla\": \"temperature\","
+                "\"ic\": \"mdi:thermometer\","
+                "\"dev\": {\"ids\": [\"%s\"],\"name\": \"%s\",\"mf\": \"ESAP\"}"
+            "}",
+            device_name, extremes[i][2], unique_id, state_topic, extremes[i][0], extremes[i][0],
+            device_id, device_name);
+        publish_discovery(client, sat_addr, discovery_topic, discovery_payload);
+    }
 
     // 2. Humidity
     snprintf(unique_id, sizeof(unique_id), "%s_humidity", device_id);
@@ -166,14 +313,14 @@ void publish_discovery_for_satellite(esp_mqtt_client_handle_t client, int sat_ad
             "\"name\": \"%s Humidity\","
             "\"unique_id\": \"%s\","
             "\"stat_t\": \"%s\","
-            "\"val_tpl\": \"{{ value_json.h }}\","
+            "\"val_tpl\": \"{{ value_json.h if value_json.h is defined else None }}\","
             "\"unit_of_meas\": \"%%\","
             "\"dev_cla\": \"humidity\","
             "\"ic\": \"mdi:water-percent\","
             "\"dev\": {\"ids\": [\"%s\"],\"name\": \"%s\",\"mf\": \"ESAP\"}"
         "}",
         device_name, unique_id, state_topic, device_id, device_name);
-    esp_mqtt_client_publish(client, discovery_topic, discovery_payload, 0, 1, true);
+    publish_discovery(client, sat_addr, discovery_topic, discovery_payload);
 
     // 3. Pressure
     snprintf(unique_id, sizeof(unique_id), "%s_pressure", device_id);
@@ -183,14 +330,14 @@ void publish_discovery_for_satellite(esp_mqtt_client_handle_t client, int sat_ad
             "\"name\": \"%s Pressure\","
             "\"unique_id\": \"%s\","
             "\"stat_t\": \"%s\","
-            "\"val_tpl\": \"{{ value_json.p }}\","
+            "\"val_tpl\": \"{{ value_json.p if value_json.p is defined else None }}\","
             "\"unit_of_meas\": \"hPa\","
             "\"dev_cla\": \"pressure\","
             "\"ic\": \"mdi:gauge\","
             "\"dev\": {\"ids\": [\"%s\"],\"name\": \"%s\",\"mf\": \"ESAP\"}"
         "}",
         device_name, unique_id, state_topic, device_id, device_name);
-    esp_mqtt_client_publish(client, discovery_topic, discovery_payload, 0, 1, true);
+    publish_discovery(client, sat_addr, discovery_topic, discovery_payload);
 
     // 4. Soil Temperature (DS18B20 -> value_json.st)
     snprintf(unique_id, sizeof(unique_id), "%s_soil_temperature", device_id);
@@ -200,14 +347,14 @@ void publish_discovery_for_satellite(esp_mqtt_client_handle_t client, int sat_ad
             "\"name\": \"%s Soil Temperature\","
             "\"unique_id\": \"%s\","
             "\"stat_t\": \"%s\","
-            "\"val_tpl\": \"{{ value_json.st }}\","
+            "\"val_tpl\": \"{{ value_json.st if value_json.st is defined else None }}\","
             "\"unit_of_meas\": \"°C\","   // Or \"°C\" if you want HA to treat it as Celsius
             "\"dev_cla\": \"temperature\","
             "\"ic\": \"mdi:thermometer\","
             "\"dev\": {\"ids\": [\"%s\"],\"name\": \"%s\",\"mf\": \"ESAP\"}"
         "}",
         device_name, unique_id, state_topic, device_id, device_name);
-    esp_mqtt_client_publish(client, discovery_topic, discovery_payload, 0, 1, true);
+    publish_discovery(client, sat_addr, discovery_topic, discovery_payload);
 
     // 5. Soil Moisture
     snprintf(unique_id, sizeof(unique_id), "%s_soil_moisture", device_id);
@@ -217,15 +364,15 @@ void publish_discovery_for_satellite(esp_mqtt_client_handle_t client, int sat_ad
             "\"name\": \"%s Soil Moisture\","
             "\"unique_id\": \"%s\","
             "\"stat_t\": \"%s\","
-            "\"val_tpl\": \"{{ value_json.sm }}\","
+            "\"val_tpl\": \"{{ value_json.sm if value_json.sm is defined else None }}\","
             "\"unit_of_meas\": \"%%\","
             "\"ic\": \"mdi:water\","
             "\"dev\": {\"ids\": [\"%s\"],\"name\": \"%s\",\"mf\": \"ESAP\"}"
         "}",
         device_name, unique_id, state_topic, device_id, device_name);
-    esp_mqtt_client_publish(client, discovery_topic, discovery_payload, 0, 1, true);
+    publish_discovery(client, sat_addr, discovery_topic, discovery_payload);
 
-    // 6. Rain Level (normalized)
+    // 6. Rain Level (normalized wetness of the resistive plate, 0-1)
     snprintf(unique_id, sizeof(unique_id), "%s_rain_level", device_id);
     snprintf(discovery_topic, sizeof(discovery_topic), "homeassistant/sensor/%s/config", unique_id);
     snprintf(discovery_payload, sizeof(discovery_payload),
@@ -234,13 +381,47 @@ void publish_discovery_for_satellite(esp_mqtt_client_handle_t client, int sat_ad
             "\"unique_id\": \"%s\","
             "\"stat_t\": \"%s\","
             // "\"val_tpl\": \"{%% set m = {0:'None',1:'Light',2:'Moderate',3:'Heavy'} %%} {{ m[value_json.rain | int] }}\","
-            "\"val_tpl\": \"{{ value_json.rain }}\","
-            "\"unit_of_meas\": \"in\","
+            "\"val_tpl\": \"{{ value_json.rain if value_json.rain is defined else None }}\","
             "\"ic\": \"mdi:weather-rainy\","
             "\"dev\": {\"ids\": [\"%s\"],\"name\": \"%s\",\"mf\": \"ESAP\"}"
         "}",
         device_name, unique_id, state_topic, device_id, device_name);
-    esp_mqtt_client_publish(client, discovery_topic, discovery_payload, 0, 1, true);
+    publish_discovery(client, sat_addr, discovery_topic, discovery_payload);
+
+    // 6b. Rainfall (tipping bucket, since cold boot -> value_json.rt)
+    snprintf(unique_id, sizeof(unique_id), "%s_rainfall", device_id);
+    snprintf(discovery_topic, sizeof(discovery_topic), "homeassistant/sensor/%s/config", unique_id);
+    snprintf(discovery_payload, sizeof(discovery_payload),
+        "{"
+            "\"name\": \"%s Rainfall\","
+            "\"unique_id\": \"%s\","
+            "\"stat_t\": \"%s\","
+            "\"val_tpl\": \"{{ value_json.rt if value_json.rt is defined else None }}\","
+            "\"unit_of_meas\": \"mm\","
+            "\"dev_cla\": \"precipitation\","
+            "\"stat_cla\": \"total_increasing\","
+            "\"ic\": \"mdi:weather-pouring\","
+            "\"dev\": {\"ids\": [\"%s\"],\"name\": \"%s\",\"mf\": \"ESAP\"}"
+        "}",
+        device_name, unique_id, state_topic, device_id, device_name);
+    publish_discovery(client, sat_addr, discovery_topic, discovery_payload);
+
+    // 6c. Rain Rate (over the last reporting interval -> value_json.rr)
+    snprintf(unique_id, sizeof(unique_id), "%s_rain_rate", device_id);
+    snprintf(discovery_topic, sizeof(discovery_topic), "homeassistant/sensor/%s/config", unique_id);
+    snprintf(discovery_payload, sizeof(discovery_payload),
+        "{"
+            "\"name\": \"%s Rain Rate\","
+            "\"unique_id\": \"%s\","
+            "\"stat_t\": \"%s\","
+            "\"val_tpl\": \"{{ value_json.rr if value_json.rr is defined else None }}\","
+            "\"unit_of_meas\": \"mm/h\","
+            "\"dev_cla\": \"precipitation_intensity\","
+            "\"ic\": \"mdi:weather-pouring\","
+            "\"dev\": {\"ids\": [\"%s\"],\"name\": \"%s\",\"mf\": \"ESAP\"}"
+        "}",
+        device_name, unique_id, state_topic, device_id, device_name);
+    publish_discovery(client, sat_addr, discovery_topic, discovery_payload);
 
     // 7. UVA
     snprintf(unique_id, sizeof(unique_id), "%s_uva", device_id);
@@ -250,13 +431,13 @@ void publish_discovery_for_satellite(esp_mqtt_client_handle_t client, int sat_ad
             "\"name\": \"%s UVA\","
             "\"unique_id\": \"%s\","
             "\"stat_t\": \"%s\","
-            "\"val_tpl\": \"{{ value_json.uva }}\","
+            "\"val_tpl\": \"{{ value_json.uva if value_json.uva is defined else None }}\"," // keeps its last value while UV is off (power_governor)
             "\"unit_of_meas\": \"W/m²\","
             "\"ic\": \"mdi:weather-sunny\","
             "\"dev\": {\"ids\": [\"%s\"],\"name\": \"%s\",\"mf\": \"ESAP\"}"
         "}",
         device_name, unique_id, state_topic, device_id, device_name);
-    esp_mqtt_client_publish(client, discovery_topic, discovery_payload, 0, 1, true);
+    publish_discovery(client, sat_addr, discovery_topic, discovery_payload);
 
     // 8. UVB
     snprintf(unique_id, sizeof(unique_id), "%s_uvb", device_id);
@@ -266,13 +447,13 @@ void publish_discovery_for_satellite(esp_mqtt_client_handle_t client, int sat_ad
             "\"name\": \"%s UVB\","
             "\"unique_id\": \"%s\","
             "\"stat_t\": \"%s\","
-            "\"val_tpl\": \"{{ value_json.uvb }}\","
+            "\"val_tpl\": \"{{ value_json.uvb if value_json.uvb is defined else None }}\","
             "\"unit_of_meas\": \"W/m²\","
             "\"ic\": \"mdi:weather-sunny\","
             "\"dev\": {\"ids\": [\"%s\"],\"name\": \"%s\",\"mf\": \"ESAP\"}"
         "}",
         device_name, unique_id, state_topic, device_id, device_name);
-    esp_mqtt_client_publish(client, discovery_topic, discovery_payload, 0, 1, true);
+    publish_discovery(client, sat_addr, discovery_topic, discovery_payload);
 
     // 9. UVC
     snprintf(unique_id, sizeof(unique_id), "%s_uvc", device_id);
@@ -282,18 +463,216 @@ void publish_discovery_for_satellite(esp_mqtt_client_handle_t client, int sat_ad
             "\"name\": \"%s UVC\","
             "\"unique_id\": \"%s\","
             "\"stat_t\": \"%s\","
-            "\"val_tpl\": \"{{ value_json.uvc }}\","
+            "\"val_tpl\": \"{{ value_json.uvc if value_json.uvc is defined else None }}\","
             "\"unit_of_meas\": \"W/m²\","
             "\"ic\": \"mdi:weather-sunny\","
             "\"dev\": {\"ids\": [\"%s\"],\"name\": \"%s\",\"mf\": \"ESAP\"}"
         "}",
         device_name, unique_id, state_topic, device_id, device_name);
-    esp_mqtt_client_publish(client, discovery_topic, discovery_payload, 0, 1, true);
+    publish_discovery(client, sat_addr, discovery_topic, discovery_payload);
+
+    // 10. Air Quality Index (BME688 gas scan)
+    snprintf(unique_id, sizeof(unique_id), "%s_aqi", device_id);
+    snprintf(discovery_topic, sizeof(discovery_topic), "homeassistant/sensor/%s/config", unique_id);
+    snprintf(discovery_payload, sizeof(discovery_payload),
+        "{"
+            "\"name\": \"%s Air Quality\","
+            "\"unique_id\": \"%s\","
+            "\"stat_t\": \"%s\","
+            "\"val_tpl\": \"{{ value_json.aqi if value_json.aqi is defined and value_json.aqi >= 0 else None }}\","
+            "\"dev_cla\": \"aqi\","
+            "\"ic\": \"mdi:air-filter\","
+            "\"dev\": {\"ids\": [\"%s\"],\"name\": \"%s\",\"mf\": \"ESAP\"}"
+        "}",
+        device_name, unique_id, state_topic, device_id, device_name);
+    publish_discovery(client, sat_addr, discovery_topic, discovery_payload);
+
+    // 11. Soil probe bus errors (CRC, no response, power-on value)
+    snprintf(unique_id, sizeof(unique_id), "%s_soil_probe_errors", device_id);
+    snprintf(discovery_topic, sizeof(discovery_topic), "homeassistant/sensor/%s/config", unique_id);
+    snprintf(discovery_payload, sizeof(discovery_payload),
+        "{"
+            "\"name\": \"%s Soil Probe Errors\","
+            "\"unique_id\": \"%s\","
+            "\"stat_t\": \"%s\","
+            "\"val_tpl\": \"{{ value_json.se if value_json.se is defined else None }}\","
+            "\"stat_cla\": \"total_increasing\","
+            "\"ent_cat\": \"diagnostic\","
+            "\"ic\": \"mdi:alert-circle-outline\","
+            "\"dev\": {\"ids\": [\"%s\"],\"name\": \"%s\",\"mf\": \"ESAP\"}"
+        "}",
+        device_name, unique_id, state_topic, device_id, device_name);
+    publish_discovery(client, sat_addr, discovery_topic, discovery_payload);
+
+    // 11a. Sensors not OK: bit i = the satellite's sensors[] entry i (sensor_registry.h)
+    snprintf(unique_id, sizeof(unique_id), "%s_sensor_status", device_id);
+    snprintf(discovery_topic, sizeof(discovery_topic), "homeassistant/sensor/%s/config", unique_id);
+    snprintf(discovery_payload, sizeof(discovery_payload),
+        "{"
+            "\"name\": \"%s Sensor Faults\","
+            "\"unique_id\": \"%s\","
+            "\"stat_t\": \"%s\","
+            "\"val_tpl\": \"{{ value_json.ss if value_json.ss is defined else None }}\","
+            "\"ent_cat\": \"diagnostic\","
+            "\"ic\": \"mdi:alert-decagram-outline\","
+            "\"dev\": {\"ids\": [\"%s\"],\"name\": \"%s\",\"mf\": \"ESAP\"}"
+        "}",
+        device_name, unique_id, state_topic, device_id, device_name);
+    publish_discovery(client, sat_addr, discovery_topic, discovery_payload);
+
+    // 11b. Battery voltage and power level (power_governor.h)
+    snprintf(unique_id, sizeof(unique_id), "%s_battery_voltage", device_id);
+    snprintf(discovery_topic, sizeof(discovery_topic), "homeassistant/sensor/%s/config", unique_id);
+    snprintf(discovery_payload, sizeof(discovery_payload),
+        "{"
+            "\"name\": \"%s Battery Voltage\","
+            "\"unique_id\": \"%s\","
+            "\"stat_t\": \"%s\","
+            "\"val_tpl\": \"{{ value_json.bv if value_json.bv is defined and value_json.bv > 0 else None }}\","
+            "\"unit_of_meas\": \"V\","
+            "\"dev_cla\": \"voltage\","
+            "\"stat_cla\": \"measurement\","
+            "\"ic\": \"mdi:battery\","
+            "\"dev\": {\"ids\": [\"%s\"],\"name\": \"%s\",\"mf\": \"ESAP\"}"
+        "}",
+        device_name, unique_id, state_topic, device_id, device_name);
+    publish_discovery(client, sat_addr, discovery_topic, discovery_payload);
+
+    snprintf(unique_id, sizeof(unique_id), "%s_power_level", device_id);
+    snprintf(discovery_topic, sizeof(discovery_topic), "homeassistant/sensor/%s/config", unique_id);
+    snprintf(discovery_payload, sizeof(discovery_payload),
+        "{"
+            "\"name\": \"%s Power Level\","
+            "\"unique_id\": \"%s\","
+            "\"stat_t\": \"%s\","
+            "\"val_tpl\": \"{{ ['normal', 'save', 'low', 'critical'][value_json.pl] if value_json.pl is defined and value_json.pl < 4 else None }}\","
+            "\"ent_cat\": \"diagnostic\","
+            "\"ic\": \"mdi:battery-heart-variant\","
+            "\"dev\": {\"ids\": [\"%s\"],\"name\": \"%s\",\"mf\": \"ESAP\"}"
+        "}",
+        device_name, unique_id, state_topic, device_id, device_name);
+    publish_discovery(client, sat_addr, discovery_topic, discovery_payload);
+
+    // 12. Previous wake's time per phase (value_json.wp[i], ms), see wake_profile.h
+    static const char *const wake_phases[][2] = {
+        { "total", "Wake Time" },       { "boot", "Wake Boot" },
+        { "init", "Wake Sensor Init" }, { "uart", "Wake UART Init" },
+        { "lora_reset", "Wake LoRa Reset" }, { "lora_setup", "Wake LoRa Setup" },
+        { "handshake", "Wake Handshake" }, { "acquire", "Wake Acquisition" },
+        { "encode", "Wake Encode" },    { "tx", "Wake TX" },
+        { "ack", "Wake ACK Wait" },     { "sleep", "Wake Sleep Entry" },
+    };
+    for (int i = 0; i < (int)(sizeof(wake_phases) / sizeof(wake_phases[0])); i++) {
+        snprintf(unique_id, sizeof(unique_id), "%s_wake_%s", device_id, wake_phases[i][0]);
+        snprintf(discovery_topic, sizeof(discovery_topic), "homeassistant/sensor/%s/config", unique_id);
+        snprintf(discovery_payload, sizeof(discovery_payload),
+            "{"
+                "\"name\": \"%s %s\","
+                "\"unique_id\": \"%s\","
+                "\"stat_t\": \"%s\","
+                "\"val_tpl\": \"{{ value_json.wp[%d] if value_json.wp is defined else None }}\","
+                "\"unit_of_meas\": \"ms\","
+                "\"dev_cla\": \"duration\","
+                "\"stat_cla\": \"measurement\","
+                "\"ent_cat\": \"diagnostic\","
+                "\"ic\": \"mdi:timer-outline\","
+                "\"dev\": {\"ids\": [\"%s\"],\"name\": \"%s\",\"mf\": \"ESAP\"}"
+            "}",
+            device_name, wake_phases[i][1], unique_id, state_topic, i, device_id, device_name);
+        publish_discovery(client, sat_addr, discovery_topic, discovery_payload);
+    }
+
+    // 13. Energy estimate (value_json.em[i]), see energy_model.h
+    static const char *const energy[][5] = {
+        { "energy_cycle", "Energy per Cycle", "µAh", "", "mdi:lightning-bolt" },
+        { "energy_current", "Average Current", "µA", "", "mdi:current-dc" }, // HA current class has no µA
+        { "battery_life", "Projected Battery Life", "d", "\"dev_cla\": \"duration\",", "mdi:battery-clock" },
+    };
+    for (int i = 0; i < (int)(sizeof(energy) / sizeof(energy[0])); i++) {
+        snprintf(unique_id, sizeof(unique_id), "%s_%s", device_id, energy[i][0]);
+        snprintf(discovery_topic, sizeof(discovery_topic), "homeassistant/sensor/%s/config", unique_id);
+        // Battery life < 0 means the solar harvest covers the drain
+        snprintf(discovery_payload, sizeof(discovery_payload),
+            "{"
+                "\"name\": \"%s %s\","
+                "\"unique_id\": \"%s\","
+                "\"stat_t\": \"%s\","
+                "\"val_tpl\": \"{{ value_json.em[%d] if value_json.em is defined and value_json.em[%d] >= 0 else None }}\","
+                "\"unit_of_meas\": \"%s\","
+                "%s"
+                "\"stat_cla\": \"measurement\","
+                "\"ent_cat\": \"diagnostic\","
+                "\"ic\": \"%s\","
+                "\"dev\": {\"ids\": [\"%s\"],\"name\": \"%s\",\"mf\": \"ESAP\"}"
+            "}",
+            device_name, energy[i][1], unique_id, state_topic, i, i, energy[i][2], energy[i][3],
+            energy[i][4], device_id, device_name);
+        publish_discovery(client, sat_addr, discovery_topic, discovery_payload);
+    }
 
     vTaskDelay(pdMS_TO_TICKS(250)); // Small delay to avoid flooding the broker
 }
 
 
+/**
+ * @brief Announces soil temperature probe `idx` (>= 1, payload key "st<idx>").
+ * Extra probes are only in the payload when fitted, so they are announced
+ * the first time a satellite reports them rather than at MQTT connect.
+ */
+void publish_soil_probe_discovery(esp_mqtt_client_handle_t client, int sat_addr, int idx)
+{
+    char discovery_topic[512];
+    char discovery_payload[1024];
+    char state_topic[128];
+    char unique_id[256];
+    char device_name[128];
+    char device_id[128];
+
+    snprintf(state_topic, sizeof(state_topic), "weather/berrystation_%d/state", sat_addr);
+    snprintf(device_id, sizeof(device_id), "berrystation_%d", sat_addr);
+    snprintf(device_name, sizeof(device_name), "BerryWeather Station %d", sat_addr);
+
+    snprintf(unique_id, sizeof(unique_id), "%s_soil_temperature_%d", device_id, idx);
+    snprintf(discovery_topic, sizeof(discovery_topic), "homeassistant/sensor/%s/config", unique_id);
+    snprintf(discovery_payload, sizeof(discovery_payload),
+        "{"
+            "\"name\": \"%s Soil Temperature %d\","
+            "\"unique_id\": \"%s\","
+            "\"stat_t\": \"%s\","
+            "\"val_tpl\": \"{{ value_json.st%d if value_json.st%d is defined else None }}\","
+            "\"unit_of_meas\": \"°C\","
+            "\"dev_cla\": \"temperature\","
+            "\"ic\": \"mdi:thermometer\","
+            "\"dev\": {\"ids\": [\"%s\"],\"name\": \"%s\",\"mf\": \"ESAP\"}"
+        "}",
+        device_name, idx, unique_id, state_topic, idx, idx, device_id, device_name);
+    publish_discovery(client, sat_addr, discovery_topic, discovery_payload);
+}
+
+// Extra soil probes already announced, one bit per probe index, per satellite.
+#define MAX_SOIL_PROBES 4
+static struct { int addr; uint8_t mask; } s_soil_announced[8];
+
+static void announce_soil_probes(esp_mqtt_client_handle_t client, int sat_addr, const cJSON *root)
+{
+    int slot;
+    for (slot = 0; slot < (int)(sizeof(s_soil_announced) / sizeof(s_soil_announced[0])); slot++) {
+        if (s_soil_announced[slot].addr == sat_addr || s_soil_announced[slot].addr == 0) break;
+    }
+    if (slot == (int)(sizeof(s_soil_announced) / sizeof(s_soil_announced[0]))) return;
+    s_soil_announced[slot].addr = sat_addr;
+
+    for (int i = 1; i < MAX_SOIL_PROBES; i++) {
+        char key[8];
+        snprintf(key, sizeof(key), "st%d", i);
+        if (cJSON_GetObjectItem(root, key) && !(s_soil_announced[slot].mask & (1 << i))) {
+            ESP_LOGI(TAG, "Satellite %d reports soil probe %d, announcing it", sat_addr, i);
+            publish_soil_probe_discovery(client, sat_addr, i);
+            s_soil_announced[slot].mask |= 1 << i;
+        }
+    }
+}
+
 /**
  * @brief Listens for LoRa messages, parses them, and publishes to MQTT.
  *
@@ -305,12 +684,13 @@ void lora_listen_to_mqtt_task(void *arg)
 
     ESP_LOGI(TAG, "Starting LoRa listen task. Forwarding to MQTT.");
     
-    char rx_buf[256];
+    char rx_buf[LORA_RCV_LINE_MAX + 1]; // a full 240-byte frame and its +RCV framing
     int attempt = 0;
     const int MAX_ATTEMPTS = INT_MAX;
     
     while (attempt < MAX_ATTEMPTS) {
         ESP_LOGI(TAG, "in mqtt listen task while loop");
+        heartbeat_check(client);
         if (lora_wait_for_message(rx_buf, sizeof(rx_buf), 3000)) {
             if (strstr(rx_buf, "SATELLITE_BOOT_OK")) {
                 ESP_LOGI(TAG, "[MM] Satellite boot message received.");
@@ -326,10 +706,6 @@ void lora_listen_to_mqtt_task(void *arg)
                 char *rcv = strstr(rx_buf, "+RCV=");
                 ESP_LOGI(TAG, "Data received from satellite %d: %s", sender_addr, rcv);
             
-                // Send ACK
-                lora_send_message(sender_addr, "MM_ACK_DATA");
-                ESP_LOGI(TAG, "ACK sent to satellite %d.", sender_addr);
-            
                 // Now parse starting from `rcv`, not from `rx_buf`
                 if (strncmp(rcv, "+RCV=", 5) == 0) {
                     ESP_LOGI(TAG, "INSIDE PARSING IT");
@@ -365,7 +741,7 @@ void lora_listen_to_mqtt_task(void *arg)
                         continue;
                     }
             
-                    char json_payload[128];
+                    char json_payload[sizeof(rx_buf)];
                     memcpy(json_payload, ptr, payload_len);
                     json_payload[payload_len] = '\0';
             
@@ -391,14 +767,28 @@ void lora_listen_to_mqtt_task(void *arg)
                         ESP_LOGE(TAG, "Received invalid JSON. Discarding.");
                         continue;
                     }
+
+                    // ACK only a frame we could use: without it the satellite
+                    // keeps the window and resends it with the next frame
+                    lora_send_message(sender_addr, "MM_ACK_DATA");
+                    ESP_LOGI(TAG, "ACK sent to satellite %d.", sender_addr);
+                    announce_soil_probes(client, sender_addr, root);
+                    heartbeat_seen(client, sender_addr, root);
+                    char *state = merge_state(sender_addr, root);
                     cJSON_Delete(root);
+                    if (!state) {
+                        ESP_LOGE(TAG, "No memory for the state of satellite %d", sender_addr);
+                        continue;
+                    }
             
                     char state_topic[128];
                     snprintf(state_topic, sizeof(state_topic),
                              "weather/berrystation_%d/state", sender_addr);
             
                     ESP_LOGI(TAG, "Publishing to MQTT topic: %s", state_topic);
-                    esp_mqtt_client_publish(client, state_topic, json_payload, 0, 0, false);
+                    // Retained: it stays the current state while the satellite is silent
+                    esp_mqtt_client_publish(client, state_topic, state, 0, 1, true);
+                    cJSON_free(state);
                 }
             
             }
@@ -427,6 +817,7 @@ static void mqtt5_event_handler(void *handler_args, esp_event_base_t base, int32
             ESP_LOGI(TAG, "Publishing discovery topics for %d known satellites...", NUM_KNOWN_SATELLITES);
             for (int i = 0; i < NUM_KNOWN_SATELLITES; i++) {
                 publish_discovery_for_satellite(client, KNOWN_SATELLITE_ADDRESSES[i]);
+                heartbeat_slot(KNOWN_SATELLITE_ADDRESSES[i]); // offline if silent from now on
             }
             ESP_LOGI(TAG, "Discovery topics published.");
 
@@ -508,6 +899,7 @@ void init_checks()
 
 void app_main(void)
 {
+    power_mgmt_init(&pm_cfg);
 #if LORA_TEST_ONLY == 1
     // --- LORA TEST MODE ---
     // This code will run if LORA_TEST_ONLY is 1
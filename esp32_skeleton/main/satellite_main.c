@@ -1,35 +1,74 @@
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_system.h"
 #include "esp_random.h"
 #include "esp_log.h"
 #include "esp_sleep.h" // For deep sleep
+#include "esp_attr.h"
 #include "lora_comm.h" 
 #include "bme688.h"
+#include "bme688_sensor.h"
 #include "soil_moisture.h"
+#include "soil_moisture_sensor.h"
 #include "ds18b20.h"
+#include "ds18b20_sensor.h"
 #include "rain_sensor.h"
-#include "as7331.h"
+#include "rain_plate_sensor.h"
+#include "rain_gauge.h"
+#include "ulp_monitor.h"
+#include "adc_service.h"
+#include "as7331_sensor.h"
+#include "probe_power.h"
+#include "acq_scheduler.h"
+#include "sensor_sched.h"
+#include "sensor_registry.h"
+#include "wake_profile.h"
+#include "energy_model.h"
+#include "battery_monitor.h"
+#include "power_governor.h"
+#include "power_mgmt.h"
+#include "i2c_bus.h"
 
 // --- Satellite Specific Configuration ---
 #define SAT_ADDR 10 // This satellite's address
 #define MM_ADDR  1  // The MiddleMan's address
+#define AS7331_READY_GPIO GPIO_NUM_NC // AS7331 READY pin; NC = timed wait + status poll
+
+// Rain plate / soil moisture sampling by the ULP while asleep
+#define ULP_SAMPLE_PERIOD_MS 60000 // one sample a minute
+#define ULP_BATCH_SAMPLES    30    // wake with a full batch after 30 min at the latest
+#define RAIN_ONSET_RAW       150   // plate reading (~0.1 V) that wakes us when rain starts
+
+// Send interval at full charge (e.g., 30 minutes); the power governor
+// stretches it as the battery drains.
+// For testing, you can set this to a shorter duration, like 30 seconds:
+// #define SEND_INTERVAL_S 30
+#define SEND_INTERVAL_S  (30 * 60)
+#define SEND_INTERVAL_US (SEND_INTERVAL_S * 1000000ULL)
+// A send whose readings are all within their deadbands of the last
+// delivered frame is skipped, radio and all, for up to this long.
+#define MAX_SILENCE_US   (3 * 3600 * 1000000ULL)
+
+// Frequency scaling and automatic light sleep while awake: every vTaskDelay
+// wait (conversions, module boot, post-send) is spent in light sleep unless
+// the LoRa UART or the I2C bus holds its lock.
+static const power_mgmt_config_t pm_cfg = {
+    .max_mhz = 160,
+    .min_mhz = 40,
+    .light_sleep = true,
+};
 
 static const char *TAG = "satellite";
 //GLOBAL STRUCTS:
-struct bme68x_data data;
-struct bme68x_dev bme;
-AS7331 sensor;
-AS7331_Light light;
+energy_model_config_t energy_cfg;
 
 #define TEST_I2C_PORT I2C_NUM_0
 #define I2C_MASTER_SCL_IO 22
 #define I2C_MASTER_SDA_IO 21
 
-i2c_master_bus_handle_t main_bus_handle;
-
 i2c_master_bus_config_t i2c_mst_config = {
     .clk_source = I2C_CLK_SRC_DEFAULT,
     .i2c_port = TEST_I2C_PORT,
@@ -39,85 +78,282 @@ i2c_master_bus_config_t i2c_mst_config = {
     .flags.enable_internal_pullup = true,
 };
 
+// BME688 (400 kHz) and AS7331 (100 kHz) share it; i2c_bus serializes their transfers
 void i2c_init_shared_bus(void)
 {
-    ESP_ERROR_CHECK(i2c_new_master_bus(&i2c_mst_config, &main_bus_handle));
+    ESP_ERROR_CHECK(i2c_bus_init(&i2c_mst_config));
 }
 
-/**
- * @brief Main task for the satellite.
- *
- * This task runs in a loop, reads sensor data, sends it via LoRa,
- * and then sleeps for a configured interval.
- */
-void periodic_sensor_task(void *arg)
+/* Sampling schedule. Each sensor runs on its own period and its readings
+ * are folded into the channels below until a frame is delivered, so fast
+ * signals get density and slow ones cost no extra wakes. */
+enum { SENS_AIR, SENS_GAS, SENS_UV, SENS_SOIL_T, SENS_ANALOG, SENS_COUNT };
+
+static const sensor_sched_sensor_t sched_sensors[SENS_COUNT] = {
+    [SENS_AIR]    = { "air",    5 * 60 },  // BME688 T/H/P
+    [SENS_GAS]    = { "gas",   30 * 60 },  // BME688 heater scan, the costly one
+    [SENS_UV]     = { "uv",     5 * 60 },  // clouds move fast
+    [SENS_SOIL_T] = { "soil_t", 30 * 60 }, // ground temperature barely moves
+    [SENS_ANALOG] = { "analog", 10 * 60 }, // rain plate + soil moisture burst
+};
+
+enum {
+    CH_T, CH_H, CH_P, CH_ST, CH_SM, CH_RAIN, CH_UV, CH_UVA, CH_UVB, CH_UVC, CH_AQI,
+    CH_ST1, CH_RA = CH_ST1 + DS18B20_MAX_PROBES - 1, CH_SA, CH_COUNT
+};
+
+// Deadbands (reported units) are the send-on-delta thresholds: roughly
+// each sensor's noise, or the smallest change worth a LoRa frame.
+#define CHANNEL(k, s, a, d, ...) { .key = k, .sensor = s, .agg = SENSOR_SCHED_AGG_##a, .decimals = d, __VA_ARGS__ }
+static const sensor_sched_channel_t sched_channels[CH_COUNT] = {
+    [CH_T]    = CHANNEL("t", SENS_AIR, MINMAX, 2, .deadband = 0.5f),                   // air temp (°C), plus tn/tx
+    [CH_H]    = CHANNEL("h", SENS_AIR, MEAN, 2, .deadband = 3),                        // air humidity (%)
+    [CH_P]    = CHANNEL("p", SENS_AIR, MEAN, 2, .deadband = 1),                        // air pressure (hPa)
+    [CH_ST]   = CHANNEL("st", SENS_SOIL_T, LAST, 2, .deadband = 0.5f),                 // soil temp (°C)
+    [CH_SM]   = CHANNEL("sm", SENS_ANALOG, LAST, 2, .deadband = 0.3f),                 // soil moisture (normalized)
+    [CH_RAIN] = CHANNEL("rain", SENS_ANALOG, MAX, 2, .deadband = 0.03f),               // rain level (normalized), wettest
+    [CH_UV]   = CHANNEL("uv", SENS_UV, MAX, 2, .deadband = 50),                        // derived UV index, peak
+    [CH_UVA]  = CHANNEL("uva", SENS_UV, MEAN, 2, .deadband = 50),
+    [CH_UVB]  = CHANNEL("uvb", SENS_UV, MEAN, 2, .deadband = 10),
+    [CH_UVC]  = CHANNEL("uvc", SENS_UV, MEAN, 2, .deadband = 10),
+    [CH_AQI]  = CHANNEL("aqi", SENS_GAS, LAST, 0, .deadband = 25),                      // BME688 IAQ (0-500)
+    // Extras last: they are dropped first when the frame is full
+    [CH_ST1]     = CHANNEL("st1", SENS_SOIL_T, LAST, 2, .deadband = 0.5f), // extra soil probes
+    [CH_ST1 + 1] = CHANNEL("st2", SENS_SOIL_T, LAST, 2, .deadband = 0.5f),
+    [CH_ST1 + 2] = CHANNEL("st3", SENS_SOIL_T, LAST, 2, .deadband = 0.5f),
+    [CH_RA]   = CHANNEL("ra", SENS_ANALOG, RANGE, 0, .deadband = 100), // ULP rain plate, mV
+    [CH_SA]   = CHANNEL("sa", SENS_ANALOG, RANGE, 0, .deadband = 100), // ULP soil, mV
+};
+_Static_assert(DS18B20_MAX_PROBES == 4, "one st<n> channel per extra probe");
+
+static const sensor_sched_config_t sched_cfg = {
+    .sensors = sched_sensors,
+    .n_sensors = SENS_COUNT,
+    .channels = sched_channels,
+    .n_channels = CH_COUNT,
+    .send_period_us = SEND_INTERVAL_US,
+    .max_silence_us = MAX_SILENCE_US,
+};
+
+/* Battery policy: each level down stretches every period, turns off the
+ * costly optional sensors and gives up on the ACK sooner. Cell voltages
+ * for a 1S LiPo at rest; 100 mV hysteresis on the way back up. */
+#define SENS_BIT(s) (1u << (s))
+static const power_governor_config_t power_cfg = {
+    .level = {
+        //                      enter  leave  stretch  disabled                            attempts
+        [POWER_LEVEL_NORMAL]   = { 0,    0,    1, 0,                                      25 },
+        [POWER_LEVEL_SAVE]     = { 3700, 3800, 2, SENS_BIT(SENS_GAS),                     10 },
+        [POWER_LEVEL_LOW]      = { 3550, 3650, 4, SENS_BIT(SENS_GAS) | SENS_BIT(SENS_UV), 3 },
+        [POWER_LEVEL_CRITICAL] = { 3400, 3500, 8, SENS_BIT(SENS_GAS) | SENS_BIT(SENS_UV), 1 },
+    },
+    .base_send_us = SEND_INTERVAL_US,
+    .min_send_us = 60 * 1000000ULL,       // never hammer the radio, whatever the config
+    .max_send_us = 6 * 3600 * 1000000ULL, // still a sign of life four times a day
+};
+
+/* The sensors fitted to this board. Each entry is a driver's descriptor
+ * (init/start/ready/collect/power-down hooks), the sensor_sched sensor it
+ * is sampled with, and where its values go, with this board's calibration.
+ * sensor_registry brings up and samples the entries that are due, groups
+ * the I2C ones, and skips any that are absent or fail. Table order is
+ * start order: the DS18B20 conversion is the slowest, so it goes first. */
+static const as7331_sensor_cfg_t uv_cfg = { .ready_gpio = AS7331_READY_GPIO };
+
+static const sensor_channel_t soil_t_channels[] = {
+    { .value = 0, .channel = CH_ST },
+    { .value = 1, .channel = CH_ST1 },      // probes beyond the first, when present
+    { .value = 2, .channel = CH_ST1 + 1 },
+    { .value = 3, .channel = CH_ST1 + 2 },
+};
+static const sensor_channel_t uv_channels[] = {
+    { .value = 0, .channel = CH_UV },       // UV index from UVA
+    { .value = 0, .channel = CH_UVA },
+    { .value = 1, .channel = CH_UVB },
+    { .value = 2, .channel = CH_UVC },
+};
+static const sensor_channel_t air_channels[] = {
+    { .value = 0, .channel = CH_T, .offset = -3 },     // self-heating of the enclosure
+    { .value = 1, .channel = CH_H, .offset = 10 },
+    { .value = 2, .channel = CH_P, .scale = 0.01f },   // Pa -> hPa
+};
+static const sensor_channel_t gas_channels[] = {
+    { .value = 0, .channel = CH_AQI },
+};
+static const sensor_channel_t rain_channels[] = {
+    { .value = 0, .channel = CH_RAIN },
+};
+static const sensor_channel_t soil_m_channels[] = {
+    { .value = 0, .channel = CH_SM },
+};
+
+#define ENTRY(d, c, s, ch) { .desc = &d, .ctx = (void *)(c), .sensor = s, .channels = ch, \
+                             .n_channels = sizeof(ch) / sizeof(ch[0]) }
+static const sensor_entry_t sensors[] = {
+    ENTRY(ds18b20_sensor,       NULL,     SENS_SOIL_T, soil_t_channels),
+    ENTRY(as7331_sensor,        &uv_cfg,  SENS_UV,     uv_channels),
+    ENTRY(bme688_air_sensor,    NULL,     SENS_AIR,    air_channels),
+    ENTRY(bme688_gas_sensor,    NULL,     SENS_GAS,    gas_channels), // after air: same device
+    ENTRY(rain_plate_sensor,    NULL,     SENS_ANALOG, rain_channels),
+    ENTRY(soil_moisture_sensor, NULL,     SENS_ANALOG, soil_m_channels),
+};
+#define N_SENSORS ((int)(sizeof(sensors) / sizeof(sensors[0])))
+
+static uint32_t s_heater_us; // this wake
+
+// Samples the sensors due this wake and folds the readings into the window.
+static void sample_due_sensors(uint32_t due)
 {
-    // Define the send interval (e.g., 30 minutes)
-    // For testing, you can set this to a shorter duration, like 30 seconds:
-    // const int SEND_INTERVAL_SECONDS = 30;
-    const int SEND_INTERVAL_MINUTES = 0.16;
-    const uint64_t SEND_INTERVAL_US = (uint64_t)SEND_INTERVAL_MINUTES * 60 * 1000 * 1000;
-    
-    printf("Starting periodic sensor task. Sending every %d minutes.\n", SEND_INTERVAL_MINUTES);
+    if (sensor_registry_sample(due) == 0) return;
 
-    // 1. Read data from sensors
-    float temp, hum, pres;
-    float soil_temp;
-    float rain_level;
-    float soil_moisture;
-    // float temperature = get_temp_data();
-    bme688_read_temperature(&temp, &data, &bme);
-    bme688_read_humidity(&hum, &data, &bme);
-    bme688_read_pressure(&pres, &data, &bme);
-    ESP_LOGI(TAG, "BME688 -> Temp: %.2f °C, Hum: %.2f %%, Pres: %.2f hPa", temp, hum, pres);
+    // Heater on-time for the energy model: the whole gas scan, plus the
+    // forced-mode heater step of a TPH conversion.
+    const acq_timings_t *acq = acq_last_timings();
+    for (int i = 0; i < acq->count; i++) {
+        if (strcmp(acq->phase[i].name, bme688_gas_sensor.name) == 0) {
+            s_heater_us += acq->phase[i].collect_us;
+        } else if (strcmp(acq->phase[i].name, bme688_air_sensor.name) == 0) {
+            s_heater_us += BME688_FORCED_HEATR_DUR * 1000;
+        }
+    }
+}
 
-    ds18b20_read_temperature(&soil_temp);
-    ESP_LOGI(TAG, "DS18B20 -> Soil Temp: %.2f °C", soil_temp);
+// What the ULP sampled while we slept, folded in as [min, mean, max] mV.
+static void fold_ulp_samples(void)
+{
+    ulp_monitor_adc_stats_t ulp_rain, ulp_soil;
+    uint32_t ulp_wake = ulp_monitor_adc_collect(&ulp_rain, &ulp_soil);
+    ESP_LOGI(TAG, "ULP -> %u samples%s%s", ulp_rain.samples,
+             (ulp_wake & ULP_MONITOR_WAKE_ONSET) ? ", rain onset" : "",
+             (ulp_wake & ULP_MONITOR_WAKE_BATCH) ? ", batch full" : "");
+    const ulp_monitor_adc_stats_t *st[] = { &ulp_rain, &ulp_soil };
+    const int ch[] = { CH_RA, CH_SA };
+    for (int i = 0; i < 2; i++) {
+        if (!st[i]->samples) continue;
+        sensor_sched_add_batch(ch[i], st[i]->samples, adc_service_raw_to_mv((int)st[i]->mean),
+                               adc_service_raw_to_mv(st[i]->min), adc_service_raw_to_mv(st[i]->max),
+                               adc_service_raw_to_mv(st[i]->last));
+    }
+    if (ulp_wake & ULP_MONITOR_WAKE_ONSET) {
+        sensor_sched_request_send(); // rain started: report it now
+    }
+}
 
-    rain_level = rain_sensor_get_normalized();
-    ESP_LOGI(TAG, "Rain Sensor -> Level: %.2f", rain_level);
+// Brings the LoRa module up; only on wakes that actually send.
+static void radio_up(void)
+{
+    // 1. Initialize LoRa UART and Reset Module
+    wake_profile_mark(WAKE_PHASE_UART);
+    // UART1 RX cannot wake light sleep and loses its baud below APB 80 MHz:
+    // hold the lock until the send window is over (released by the caller)
+    power_mgmt_acquire(POWER_MGMT_LOCK_UART);
+    lora_uart_config();
+    wake_profile_mark(WAKE_PHASE_LORA_RESET);
+    lora_reset();
 
-    soil_moisture_read(&soil_moisture);
-    ESP_LOGI(TAG, "Soil Moisture -> Value: %.2f", soil_moisture);
+    vTaskDelay(pdMS_TO_TICKS(500));
+    // uart_flush_input(LORA_UART_PORT);
 
-    as7331_read_light(&sensor, &light);
-    ESP_LOGI(TAG, "AS7331 Scaled -> UVA: %.2f, UVB: %.2f, UVC: %.2f uW/cm²", light.uva, light.uvb, light.uvc);
+    // 2. Perform common LoRa setup
+    printf("Setting up LoRa module...\n");
+    wake_profile_mark(WAKE_PHASE_LORA_SETUP);
+    lora_common_setup(SAT_ADDR);
 
-    float uv_index = light.uva;
+    printf("Performing LoRa boot handshake...\n");
+    wake_profile_mark(WAKE_PHASE_HANDSHAKE);
+    if (lora_boot_handshake(false, MM_ADDR)) {
+        printf("Handshake successful!\n");
+    } else {
+        printf("Handshake failed. Continuing anyway.\n");
+    }
+}
 
-    // 2. Create the JSON payload
-    char json_payload[256];
+// Rain in the bucket or a power level change always goes out, deadbands or not.
+static bool must_report(void)
+{
+    rain_gauge_report_t rain = { 0 };
+    rain_gauge_read(&rain);
+    return rain.interval_mm > 0.0f || power_governor_state()->changed;
+}
+
+// Appends ,<field> if it still fits; fmt writes nothing when it does not.
+static int append_optional(char *buf, int len, size_t size, int (*fmt)(char *, size_t))
+{
+    if (size - len <= 2) return len;
+    buf[len] = ',';
+    int n = fmt(buf + len + 1, size - len - 2);
+    return n ? len + 1 + n : len;
+}
+
+// The energy estimate and the last send wake's profile, "em":[..],"wp":[..]
+static int format_diagnostics(char *buf, size_t size)
+{
+    int len = energy_model_format(buf, size);
+    if (len == 0) return wake_profile_format(buf, size);
+    return append_optional(buf, len, size, wake_profile_format);
+}
+
+#define DIAG_FRAME_EVERY 4
+static RTC_DATA_ATTR uint32_t s_frames_built;
+
+// Sends the aggregated window and waits for the MiddleMan's ACK.
+static bool send_window(void)
+{
+    wake_profile_mark(WAKE_PHASE_ENCODE);
+    const power_governor_state_t *power = power_governor_state();
+    rain_gauge_report_t rain = { 0 };
+    rain_gauge_read(&rain);
+    ESP_LOGI(TAG, "Rain Gauge -> %.2f mm in %lu s (%.2f mm/h), %.1f mm total",
+             rain.interval_mm, (unsigned long)rain.interval_s, rain.rate_mm_h, rain.total_mm);
 
-        snprintf(json_payload, sizeof(json_payload),
+    // 2. Create the JSON payload; the scheduled channels fill what room is left
+    // and the diagnostics (energy estimate, wake profile) go in last. A full
+    // frame has no room for them, so every DIAG_FRAME_EVERY-th frame
+    // reserves it; the channels that then do not fit go in the next frame.
+    char diag[128];
+    int diag_len = format_diagnostics(diag, sizeof(diag));
+    bool diag_frame = (s_frames_built++ % DIAG_FRAME_EVERY) == 0;
+    size_t reserve = diag_frame && diag_len ? diag_len + 1 : 0;
+    char json_payload[LORA_MAX_PAYLOAD + 1];
+    int len = snprintf(json_payload, sizeof(json_payload),
             "{"
-            "\"t\":%.2f,"      // air temp (°C)
-            "\"h\":%.2f,"      // air humidity (%%)
-            "\"p\":%.2f,"      // air pressure (hPa)
-            "\"st\":%.2f,"     // soil temp (°C)
-            "\"sm\":%.2f,"     // soil moisture (normalized/ADC)
-            "\"rain\":%.2f,"   // rain level (normalized)
-            "\"uv\":%.2f,"     // combined/derived UV index
-            "\"uva\":%.2f,"
-            "\"uvb\":%.2f,"
-            "\"uvc\":%.2f"
-            "}",
-            temp-3, hum+10, pres/100,
-            soil_temp, soil_moisture, rain_level,
-            uv_index,
-            light.uva, light.uvb, light.uvc);
+            "\"rmm\":%.2f,"    // rainfall since last delivered frame (mm)
+            "\"rr\":%.2f,"     // rain rate over that interval (mm/h)
+            "\"rt\":%.1f,"     // rainfall since cold boot (mm)
+            "\"se\":%lu,"      // soil probe bus errors since cold boot
+            "\"ss\":%lu,"      // sensors not OK, bit i = sensors[i] (sensor_registry.h)
+            "\"bv\":%.2f,"     // battery (V), -1 = no reading
+            "\"pl\":%d,"       // power level, 0 = normal ... 3 = critical
+            "\"hb\":%lu,",     // next frame due within this many s, unchanged or not
+            rain.interval_mm, rain.rate_mm_h, rain.total_mm,
+            (unsigned long)ds18b20_error_count(), (unsigned long)sensor_registry_status(),
+            power->battery_mv > 0 ? power->battery_mv / 1000.0f : -1.0f, (int)power->level,
+            (unsigned long)sensor_sched_heartbeat_s());
+    size_t room = sizeof(json_payload) - len - 1;
+    len += sensor_sched_format(json_payload + len, room > reserve ? room - reserve : 0);
+    if (json_payload[len - 1] == ',') len--; // no channel fitted after the header
+    if (diag_len && len + 1 + diag_len + 1 < (int)sizeof(json_payload)) {
+        json_payload[len++] = ',';
+        memcpy(json_payload + len, diag, diag_len);
+        len += diag_len;
+    }
+    strcpy(json_payload + len, "}");
 
     printf("----------------------------------\n");
     printf("Reading sensors and sending data...\n");
     printf("Payload: %s\n", json_payload);
     
+    wake_profile_mark(WAKE_PHASE_TX);
     lora_send_message(MM_ADDR, json_payload);
     // uart_flush_input(LORA_UART_PORT);
+    wake_profile_mark(WAKE_PHASE_ACK);
     printf("Waiting for data ACK from MiddleMan...\n");
     
     char rx_buf[128];
     bool ack_received = false;
     
-    for (int attempt = 0; attempt < 25; attempt++) {
+    // Fewer resends as the battery drains (power_cfg attempts)
+    for (int attempt = 1; ; attempt++) {
         if (lora_wait_for_message(rx_buf, sizeof(rx_buf), 6000)) {
             if (strstr(rx_buf, "MM_ACK_DATA")) {
                 printf("ACK received from MiddleMan!\n");
@@ -125,54 +361,118 @@ void periodic_sensor_task(void *arg)
                 break;
             }
         }
-        printf("No ACK, retrying send (%d/3)...\n", attempt + 1);
+        if (attempt >= power->attempts) break;
+        printf("No ACK, retrying send (%d/%d)...\n", attempt, power->attempts - 1);
         lora_send_message(MM_ADDR, json_payload);
     }
     
-    // 4. Sleep if ACK or after max retries
     if (!ack_received)
         printf("No ACK from MiddleMan, going to sleep anyway.\n");
+    else
+        rain_gauge_commit(); // otherwise the rain rolls into the next frame
     
     uart_wait_tx_done(LORA_UART_PORT, pdMS_TO_TICKS(1000));
-    vTaskDelay(pdMS_TO_TICKS(500));
-    
-    esp_sleep_enable_timer_wakeup(SEND_INTERVAL_US);
-    esp_deep_sleep_start();
+    return ack_received;
 }
 
-void app_main(void)
+// Hands this wake's draw to the energy model; it is accounted, with the
+// sleep that follows, at the next wake.
+static void close_energy_cycle(uint64_t sleep_us)
 {
-    printf("--- Satellite Device Booting ---\n");
+    const wake_profile_t *wp = wake_profile_last();
+    const lora_tx_stats_t *tx = lora_tx_stats();
+    energy_cycle_t c = {
+        .active_us = wp->total_us,
+        .sensor_us = wp->phase_us[WAKE_PHASE_ACQUIRE],
+        .heater_us = s_heater_us,
+        .light_sleep_us = power_mgmt_light_sleep_us(),
+        .tx_frames = tx->frames,
+        .tx_bytes = tx->bytes,
+        .sleep_us = sleep_us,
+    };
+    // The module listens from its reset until we sleep.
+    if (wp->phase_us[WAKE_PHASE_LORA_RESET]) {
+        for (int i = WAKE_PHASE_LORA_RESET; i <= WAKE_PHASE_SLEEP; i++) {
+            if (i != WAKE_PHASE_ACQUIRE) c.radio_us += wp->phase_us[i]; // sampled before radio_up()
+        }
+    }
+    energy_model_close_wake(&c);
+}
 
-    // 1. Initialize LoRa UART and Reset Module
-    lora_uart_config();
-    lora_reset();
+/**
+ * @brief Main task for the satellite.
+ *
+ * Samples the sensors that are due, sends the aggregated readings when the
+ * send interval is up, and then sleeps until the next sensor or send is due.
+ */
+void periodic_sensor_task(void *arg)
+{
+    const power_governor_state_t *power = power_governor_state();
+    printf("Starting periodic sensor task. Sending every %d minutes (%s power).\n",
+           SEND_INTERVAL_S * power->stretch / 60, power_governor_level_name(power->level));
 
-    vTaskDelay(pdMS_TO_TICKS(500));
-    // uart_flush_input(LORA_UART_PORT);
+    // 1. Read data from the sensors that are due: every conversion runs at once
+    uint32_t due = sensor_sched_due();
+    wake_profile_mark(WAKE_PHASE_ACQUIRE);
+    sample_due_sensors(due);
+    sensor_sched_sampled(due);
 
-    // 2. Perform common LoRa setup
-    printf("Setting up LoRa module...\n");
-    lora_common_setup(SAT_ADDR); 
+    // 2. Send only if something moved beyond its deadband (send-on-delta);
+    // the radio is brought up after sampling so a skipped send costs nothing
+    if (sensor_sched_send_due() && (must_report() || sensor_sched_should_send())) {
+        radio_up();
+        sensor_sched_sent(send_window());
+        power_mgmt_release(POWER_MGMT_LOCK_UART); // taken in radio_up()
+        wake_profile_mark(WAKE_PHASE_SLEEP);
+        vTaskDelay(pdMS_TO_TICKS(500));
+    } else {
+        if (sensor_sched_send_due()) {
+            ESP_LOGI(TAG, "Readings unchanged, send skipped");
+            sensor_sched_skipped();
+        }
+        wake_profile_mark(WAKE_PHASE_SLEEP);
+    }
+    
+    // 3. Sleep until the next sensor or send is due
+    uint64_t sleep_us = sensor_sched_sleep_us();
+    ESP_LOGI(TAG, "Sleeping %llu s", (unsigned long long)(sleep_us / 1000000));
+    sensor_registry_power_down();
+    probe_power_prepare_sleep(); // probe supplies latched off while asleep
+    adc_service_release();       // ADC1 goes to the ULP
+    ulp_monitor_prepare_sleep(); // ULP counts rain gauge tips and samples the probes
+    esp_sleep_enable_timer_wakeup(sleep_us);
+    power_mgmt_log();
+    i2c_bus_log_stats();
+    wake_profile_finish();
+    close_energy_cycle(sleep_us);
+    esp_deep_sleep_start();
+}
 
-    //INITIALIZE SENSORS:
+void app_main(void)
+{
+    wake_profile_begin();
+    printf("--- Satellite Device Booting ---\n");
+    power_mgmt_init(&pm_cfg);
+    energy_model_default_config(&energy_cfg);
+    energy_model_init(&energy_cfg); // accounts the previous wake and its sleep
+    ulp_monitor_adc_pause(); // ADC1 is ours until the next deep sleep
+    battery_monitor_init();  // first on the ADC, so its burst is the cell alone
+    const power_governor_state_t *power = power_governor_update(&power_cfg, battery_monitor_read_mv());
+    sensor_sched_set_policy(power->disabled, power->stretch);
+    sensor_sched_init(&sched_cfg);
+    uint32_t due = sensor_sched_due();
 
     //INIT BUS:
     i2c_init_shared_bus();
 
-    ds18b20_init();
+    //INITIALIZE SENSORS: only the ones sampled this wake
+    sensor_registry_init(sensors, N_SENSORS, due);
     rain_sensor_init();
+    rain_gauge_init();
+    ulp_monitor_adc_config(ULP_SAMPLE_PERIOD_MS, ULP_BATCH_SAMPLES, RAIN_ONSET_RAW);
     soil_moisture_init();
-    as7331_init(&sensor, main_bus_handle);
-    bme688_init(&data, &bme, main_bus_handle);
-
+    fold_ulp_samples();
 
-    printf("Performing LoRa boot handshake...\n");
-    if (lora_boot_handshake(false, MM_ADDR)) {
-        printf("Handshake successful! Starting periodic task.\n");
-    } else {
-        printf("Handshake failed. Continuing anyway.\n");
-    }
     xTaskCreate(periodic_sensor_task, "periodic_sensor_task", 4096, NULL, 5, NULL);
 
-}
\ No newline at end of file
+}